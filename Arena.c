@@ -0,0 +1,91 @@
+/*
+ * Arena.c - a bump allocator for search trees
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * See Arena.h
+ */
+
+
+#include <stdlib.h>
+#include <assert.h>
+#include "Arena.h"
+
+
+typedef struct _arena {
+    char *memory;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+} arena;
+
+
+// =====================================================================
+//   ARENA FUNCTIONS BEGIN
+// =====================================================================
+
+Arena newArena (size_t capacity) {
+    Arena a = malloc(sizeof(arena));
+    a->memory = malloc(capacity);
+    a->capacity = capacity;
+    a->used = 0;
+    a->peak = 0;
+    return a;
+}
+
+
+void disposeArena (Arena a) {
+    free(a->memory);
+    free(a);
+}
+
+
+void *arenaAlloc (Arena a, size_t size) {
+    size_t start = (a->used + ARENA_ALIGNMENT - 1)
+        & ~(size_t)(ARENA_ALIGNMENT - 1);
+    void *block = NULL;
+    if (start <= a->capacity && size <= a->capacity - start) {
+        block = a->memory + start;
+        a->used = start + size;
+        if (a->used > a->peak) {
+            a->peak = a->used;
+        }
+    }
+    return block;
+}
+
+
+void *arenaStart (Arena a) {
+    return a->memory;
+}
+
+
+void arenaReset (Arena a) {
+    a->used = 0;
+}
+
+
+size_t arenaMark (Arena a) {
+    return a->used;
+}
+
+
+void arenaRelease (Arena a, size_t mark) {
+    assert(mark <= a->used);
+    a->used = mark;
+}
+
+
+size_t arenaUsed (Arena a) {
+    return a->used;
+}
+
+
+size_t arenaPeak (Arena a) {
+    return a->peak;
+}
+
+
+size_t arenaCapacity (Arena a) {
+    return a->capacity;
+}
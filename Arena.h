@@ -0,0 +1,52 @@
+/*
+ *  Arena.h - a bump allocator for search trees
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  An arena gets all its memory with one malloc when it's made, and
+ *  after that allocating is moving a pointer along it. Nothing is
+ *  freed on its own: the whole arena is reset at once (or everything
+ *  after a mark is released), which is what a search wants when it
+ *  throws a tree away. When it runs out arenaAlloc() says so rather
+ *  than going back to the heap.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// every allocation starts on a multiple of this, which is enough for
+// the doubles and 64 bit sets in the engine's structs. Allocations
+// which are multiples of it come out one straight after another
+#define ARENA_ALIGNMENT 8
+
+typedef struct _arena *Arena;
+
+// an arena which can hand out capacity bytes
+Arena newArena (size_t capacity);
+void disposeArena (Arena a);
+
+// size bytes from the arena, or NULL if there isn't room left
+void *arenaAlloc (Arena a, size_t size);
+
+// where the arena's memory starts. Everything allocated since the
+// last reset is at or after it
+void *arenaStart (Arena a);
+
+// free everything allocated from the arena
+void arenaReset (Arena a);
+
+// how much is allocated now, to release() back to later
+size_t arenaMark (Arena a);
+
+// free everything allocated since mark was taken
+void arenaRelease (Arena a, size_t mark);
+
+// how many bytes are allocated now, the most there have ever been
+// at once, and how many there could be
+size_t arenaUsed (Arena a);
+size_t arenaPeak (Arena a);
+size_t arenaCapacity (Arena a);
+
+#endif
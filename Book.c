@@ -0,0 +1,248 @@
+/*
+ * Book.c - an opening book of positions searched ahead of time
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Linear probing on the low bits of the key, which hashGame() has
+ * already mixed. The table doubles whenever it would be more than half
+ * full, so a probe never goes far. See Book.h
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "Book.h"
+
+
+// how many slots a new book starts with (a power of 2)
+#define BOOK_START_SLOTS 1024
+
+// the key of a slot with nothing in it. A position which really hashes
+// to it is kept under EMPTY_KEY_STANDIN instead
+#define EMPTY_KEY 0
+#define EMPTY_KEY_STANDIN 1
+
+
+// what comes first in a book file
+typedef struct _bookHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t board;
+    uint32_t numSlots;
+    uint32_t numEntries;
+} bookHeader;
+
+// one slot of the table, 16 bytes on disk and in memory
+typedef struct _bookEntry {
+    uint64_t key;
+    uint8_t actionCode;
+    uint8_t target;
+    uint16_t unused;
+    uint32_t playouts;
+} bookEntry;
+
+typedef struct _book {
+    bookHeader header;
+    bookEntry *entries;
+} book;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// the slot the key is in, or the empty slot where it would go
+static bookEntry *findSlot(book *b, uint64_t key);
+
+// move every entry into a table with numSlots slots
+static void resizeBook(book *b, uint32_t numSlots);
+
+// keys are never EMPTY_KEY
+static uint64_t slotKey(uint64_t key);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static bookEntry *findSlot(book *b, uint64_t key) {
+    uint32_t mask = b->header.numSlots - 1;
+    uint32_t slot = key & mask;
+    while (b->entries[slot].key != EMPTY_KEY
+            && b->entries[slot].key != key) {
+        slot = (slot + 1) & mask;
+    }
+    return &b->entries[slot];
+}
+
+
+static void resizeBook(book *b, uint32_t numSlots) {
+    bookEntry *old = b->entries;
+    uint32_t oldSlots = b->header.numSlots;
+    b->entries = malloc(numSlots * sizeof(bookEntry));
+    memset(b->entries, 0, numSlots * sizeof(bookEntry));
+    b->header.numSlots = numSlots;
+
+    uint32_t slot = 0;
+    while (slot < oldSlots) {
+        if (old[slot].key != EMPTY_KEY) {
+            *findSlot(b, old[slot].key) = old[slot];
+        }
+        slot++;
+    }
+    free(old);
+}
+
+
+static uint64_t slotKey(uint64_t key) {
+    if (key == EMPTY_KEY) {
+        key = EMPTY_KEY_STANDIN;
+    }
+    return key;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   BOOK FUNCTIONS BEGIN
+// =====================================================================
+
+Book newBook (uint64_t board) {
+    Book b = malloc(sizeof(book));
+    memset(b, 0, sizeof(book));
+    b->header.magic = BOOK_MAGIC;
+    b->header.version = BOOK_VERSION;
+    b->header.board = board;
+    resizeBook(b, BOOK_START_SLOTS);
+    return b;
+}
+
+
+void disposeBook (Book b) {
+    free(b->entries);
+    free(b);
+}
+
+
+uint64_t bookBoard (Book b) {
+    return b->header.board;
+}
+
+
+int bookSize (Book b) {
+    return b->header.numEntries;
+}
+
+
+// Only the purchase is kept: the target of a campus, GO8 or ARC is its
+// vertex or edge ID, which fits in a byte
+void bookAdd (Book b, uint64_t key, const macroAction *macro,
+        int playouts) {
+    if (2 * (b->header.numEntries + 1) > b->header.numSlots) {
+        resizeBook(b, 2 * b->header.numSlots);
+    }
+
+    key = slotKey(key);
+    bookEntry *entry = findSlot(b, key);
+    if (entry->key == EMPTY_KEY) {
+        b->header.numEntries++;
+    }
+
+    const action *bought = &macro->actions[macro->numActions-1];
+    int target = 0;
+    if (bought->actionCode == BUILD_CAMPUS
+            || bought->actionCode == BUILD_GO8) {
+        target = vertexOfPath(bought->destination);
+    } else if (bought->actionCode == OBTAIN_ARC) {
+        target = edgeOfPath(bought->destination);
+    }
+
+    entry->key = key;
+    entry->actionCode = bought->actionCode;
+    entry->target = target;
+    entry->playouts = playouts;
+}
+
+
+int bookLookup (Book b, uint64_t key, rolloutMove *build, int *playouts) {
+    bookEntry *entry = findSlot(b, slotKey(key));
+    int found = (entry->key != EMPTY_KEY);
+    if (found) {
+        build->actionCode = entry->actionCode;
+        build->target = entry->target;
+        build->disciplineFrom = -1;
+        build->disciplineTo = -1;
+        if (playouts != NULL) {
+            *playouts = entry->playouts;
+        }
+    }
+    return found;
+}
+
+
+int bookGameMacro (Book b, Game g, macroAction *macro) {
+    rolloutMove build;
+    int found = bookLookup(b, hashGame(g), &build, NULL);
+    if (found) {
+        rolloutBoard board;
+        rollout r;
+        rolloutBoardFromGame(&board, g);
+        rolloutFromGame(&r, &board, g, 0);
+        rolloutMacroAction(&r, &build, macro);
+    }
+    return found;
+}
+
+
+int saveBook (Book b, const char *fileName) {
+    int saved = FALSE;
+    FILE *file = fopen(fileName, "wb");
+    if (file != NULL) {
+        saved = fwrite(&b->header, sizeof(bookHeader), 1, file) == 1
+            && fwrite(b->entries, sizeof(bookEntry), b->header.numSlots,
+                    file) == b->header.numSlots;
+        if (fclose(file) != 0) {
+            saved = FALSE;
+        }
+    }
+    return saved;
+}
+
+
+// The header and the file's size are checked before anything is
+// allocated for the entries, so a file that isn't a book can't ask
+// for a huge table
+Book loadBook (const char *fileName) {
+    Book b = NULL;
+    FILE *file = fopen(fileName, "rb");
+    if (file != NULL) {
+        bookHeader header;
+        if (fread(&header, sizeof(bookHeader), 1, file) == 1
+                && header.magic == BOOK_MAGIC
+                && header.version == BOOK_VERSION
+                && header.numSlots >= BOOK_START_SLOTS
+                && (header.numSlots & (header.numSlots - 1)) == 0
+                && 2 * (uint64_t)header.numEntries <= header.numSlots
+                && fseek(file, 0, SEEK_END) == 0
+                && ftell(file) == (long)(sizeof(bookHeader)
+                    + (uint64_t)header.numSlots * sizeof(bookEntry))
+                && fseek(file, sizeof(bookHeader), SEEK_SET) == 0) {
+            b = malloc(sizeof(book));
+            b->header = header;
+            b->entries = malloc(header.numSlots * sizeof(bookEntry));
+            if (fread(b->entries, sizeof(bookEntry), header.numSlots,
+                        file) != header.numSlots) {
+                disposeBook(b);
+                b = NULL;
+            }
+        }
+        fclose(file);
+    }
+    return b;
+}
@@ -0,0 +1,67 @@
+/*
+ *  Book.h - an opening book of positions searched ahead of time
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  The first few turns on a board go the same way game after game, so
+ *  rather than search them again every time a bot can look them up.
+ *  buildBook (see buildBook.c) searches them offline and saves what it
+ *  found in a book file. A bot loads the book once at the start of the
+ *  game and asks it about each decision for as long as the game stays
+ *  in the book.
+ *
+ *  A book is for one board (see hashBoard() in GameEngine.h) and its
+ *  positions are keyed by hashGame(). It is an open addressing table
+ *  that is never more than half full, written to disk just as it is
+ *  in memory, so loading it is one read and a lookup is a hash and a
+ *  probe or two. Each position takes 16 bytes: its key and what to
+ *  buy there. The retraining to pay for it is worked out again when
+ *  it is looked up (see Macro.h). A book file is only meant to be read
+ *  on the same kind of machine that wrote it.
+ *
+ *  Include Game.h, GameEngine.h, Rollout.h and Macro.h before this
+ *  file.
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+// the first bytes of every book file ("BOOK"), and the version of the
+// format after them
+#define BOOK_MAGIC 0x4B4F4F42
+#define BOOK_VERSION 1
+
+typedef struct _book *Book;
+
+// an empty book for the board with the hash board
+Book newBook (uint64_t board);
+void disposeBook (Book b);
+
+// which board the book is for, and how many positions it has
+uint64_t bookBoard (Book b);
+int bookSize (Book b);
+
+// remember the macro action as the one to make in the position with
+// the key (from hashGame()), which searched playouts playouts to find
+// it. Replaces whatever the book had for the position
+void bookAdd (Book b, uint64_t key, const macroAction *macro,
+        int playouts);
+
+// fill in the purchase for the position with the key, and how many
+// playouts found it (if playouts isn't NULL). returns FALSE if the
+// position isn't in the book
+int bookLookup (Book b, uint64_t key, rolloutMove *build, int *playouts);
+
+// fill in the macro action for whoever's turn it is in g, retraining
+// and all. returns FALSE if g isn't in the book. A START_SPINOFF at
+// the end has to be turned into what it became before it's made
+int bookGameMacro (Book b, Game g, macroAction *macro);
+
+// write the book to the file. returns FALSE if it couldn't
+int saveBook (Book b, const char *fileName);
+
+// read a book saved by saveBook(), or NULL if the file can't be read
+// or isn't a book of this version
+Book loadBook (const char *fileName);
+
+#endif
@@ -0,0 +1,414 @@
+/*
+ * Endgame.c - searching the last few turns to WINNING_KPI
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Expectimax with the planner doing the maximising: the score it asks
+ * for at the end of each of the player's turns is the chance of
+ * winning from there, which rolls the dice, plays the other unis'
+ * turns and plans the player's next turn in its turn. See Endgame.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+#include "Forecast.h"
+#include "Endgame.h"
+
+
+// the table of positions has 1 << ENDGAME_TABLE_BITS entries
+#define ENDGAME_TABLE_BITS 16
+#define ENDGAME_TABLE_SIZE (1 << ENDGAME_TABLE_BITS)
+
+// and each uni's turns to win estimate is kept in one of these
+#define ESTIMATE_TABLE_BITS 14
+#define ESTIMATE_TABLE_SIZE (1 << ESTIMATE_TABLE_BITS)
+
+// the constants of the splitmix64 generator, which mixHash() uses
+#define MIX_STEP 0x9E3779B97F4A7C15ULL
+#define MIX_MULTIPLIER_1 0xBF58476D1CE4E5B9ULL
+#define MIX_MULTIPLIER_2 0x94D049BB133111EBULL
+
+
+// the chance of winning from the end of a turn, with turnsLeft more
+// of the player's turns still to search
+typedef struct _endgameEntry {
+    uint64_t hash;
+    int turnsLeft;
+    double value;
+} endgameEntry;
+
+// estimateWin() for a uni, which only depends on what that uni has
+typedef struct _estimateEntry {
+    uint64_t hash;
+    winEstimate estimate;
+} estimateEntry;
+
+// what the planner's score needs to carry the search on after a turn
+typedef struct _endgameTurn {
+    struct _endgame *e;
+    int turnsLeft;
+} endgameTurn;
+
+typedef struct _endgame {
+    long nodeBudget;
+    long nodes;
+    int outOfBudget;
+
+    // the uni the search is for and how many of its turns ahead
+    int player;
+    int searchTurns;
+
+    // a planner for each of the player's turns being searched (each
+    // one is partway through its plan while the next is used) and one
+    // for the other unis
+    Planner ours[MAX_ENDGAME_TURNS];
+    endgameTurn turns[MAX_ENDGAME_TURNS];
+    Planner theirs;
+
+    endgameEntry table[ENDGAME_TABLE_SIZE];
+    estimateEntry estimates[ESTIMATE_TABLE_SIZE];
+} endgame;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// the planner's score for the end of one of the player's turns
+static double turnScore(const rollout *r, int player, void *data);
+
+// the chance of winning from the end of whoever's turn it is in r
+static double afterTurn(endgame *e, const rollout *r, int turnsLeft);
+
+// the chance of winning from the start of whoever's turn it is in r,
+// once the dice have been thrown
+static double startTurn(endgame *e, const rollout *r, int turnsLeft);
+
+// the chance of winning from the start of the player's turn in r,
+// searching turnsLeft of their turns
+static double playerTurn(endgame *e, const rollout *r, int turnsLeft,
+        turnPlan *plan);
+
+// the chance of winning from r going by winChancesFrom()
+static double estimateChance(endgame *e, const rollout *r);
+
+// estimateWin() for the player in r, from the table if it's there
+static winEstimate rolloutEstimate(endgame *e, const rollout *r,
+        int player);
+
+// fold value into a hash so every bit of it changes every bit of hash
+static uint64_t mixHash(uint64_t hash, uint64_t value);
+
+// count a node, or FALSE if the budget has run out
+static int spendNode(endgame *e);
+
+// the table entry for r
+static endgameEntry *positionEntry(endgame *e, const rollout *r,
+        uint64_t *hash);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static double turnScore(const rollout *r, int player, void *data) {
+    endgameTurn *turn = data;
+    return afterTurn(turn->e, r, turn->turnsLeft);
+}
+
+
+// Whoever just played wins if they got there, otherwise throw the
+// dice for the next turn
+static double afterTurn(endgame *e, const rollout *r, int turnsLeft) {
+    int current = rolloutWhoseTurn(r);
+    double value = 0;
+
+    if (r->kpi[current-1] >= WINNING_KPI) {
+        value = (current == e->player);
+    } else {
+        uint64_t hash;
+        endgameEntry *entry = positionEntry(e, r, &hash);
+        if (entry->hash == hash && entry->turnsLeft == turnsLeft) {
+            value = entry->value;
+        } else if (spendNode(e)) {
+            int score = 2;
+            while (score <= 12) {
+                rollout thrown = *r;
+                rolloutThrowDice(&thrown, score);
+                value += getDiceChance(score)
+                    * startTurn(e, &thrown, turnsLeft);
+                score++;
+            }
+            // the dice chances don't quite add up to 1 in doubles
+            if (value > 1) {
+                value = 1;
+            }
+            if (!e->outOfBudget) {
+                entry = positionEntry(e, r, &hash);
+                entry->hash = hash;
+                entry->turnsLeft = turnsLeft;
+                entry->value = value;
+            }
+        }
+    }
+
+    return value;
+}
+
+
+// The other unis make their best plan for KPI points, taking any
+// spinoff as a publication
+static double startTurn(endgame *e, const rollout *r, int turnsLeft) {
+    int current = rolloutWhoseTurn(r);
+    double value = 0;
+
+    if (current == e->player) {
+        if (turnsLeft == 0) {
+            value = estimateChance(e, r);
+        } else {
+            turnPlan plan;
+            value = playerTurn(e, r, turnsLeft, &plan);
+        }
+    } else if (spendNode(e)) {
+        turnPlan plan;
+        planTurn(e->theirs, r, NULL, NULL, &plan);
+        rollout played = *r;
+        int i = 0;
+        while (i < plan.numMoves) {
+            rolloutMove move = plan.moves[i];
+            if (move.actionCode == START_SPINOFF) {
+                move.actionCode = OBTAIN_PUBLICATION;
+            }
+            rolloutMakeMove(&played, &move);
+            i++;
+        }
+        value = afterTurn(e, &played, turnsLeft);
+    }
+
+    return value;
+}
+
+
+// each of the player's turns has its own planner, since the one for
+// the turn before is still partway through its plan
+static double playerTurn(endgame *e, const rollout *r, int turnsLeft,
+        turnPlan *plan) {
+    int depth = e->searchTurns - turnsLeft;
+    e->turns[depth].e = e;
+    e->turns[depth].turnsLeft = turnsLeft - 1;
+    planTurn(e->ours[depth], r, turnScore, &e->turns[depth], plan);
+    return plan->score;
+}
+
+
+static double estimateChance(endgame *e, const rollout *r) {
+    winEstimate estimates[NUM_UNIS];
+    double chance[NUM_UNIS];
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        estimates[player-1] = rolloutEstimate(e, r, player);
+        player++;
+    }
+    winChancesFrom(estimates, rolloutWhoseTurn(r), chance);
+    return chance[e->player-1];
+}
+
+
+// The outlook only depends on the uni's KPI, students and where its
+// campuses are (which also sets its exchange rates), and on whether
+// it's playing now
+static winEstimate rolloutEstimate(endgame *e, const rollout *r,
+        int player) {
+    int i = player - 1;
+    int playingNow = (rolloutWhoseTurn(r) == player);
+    uint64_t h = mixHash(player, playingNow);
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        h = mixHash(h, r->students[i][discipline]);
+        discipline++;
+    }
+    h = mixHash(h, r->kpi[i]);
+    h = mixHash(h, r->campuses[i]);
+    h = mixHash(h, r->go8s[i]);
+
+    estimateEntry *entry = &e->estimates[h >> (64 - ESTIMATE_TABLE_BITS)];
+    if (entry->hash != h) {
+        kpiOutlook outlook;
+        rolloutKPIOutlook(r, player, &outlook);
+        entry->hash = h;
+        entry->estimate = estimateWin(&outlook);
+    }
+    return entry->estimate;
+}
+
+
+static uint64_t mixHash(uint64_t hash, uint64_t value) {
+    uint64_t z = (hash + MIX_STEP) ^ value;
+    z = (z ^ (z >> 30)) * MIX_MULTIPLIER_1;
+    z = (z ^ (z >> 27)) * MIX_MULTIPLIER_2;
+    return z ^ (z >> 31);
+}
+
+
+static int spendNode(endgame *e) {
+    if (e->nodes >= e->nodeBudget) {
+        e->outOfBudget = TRUE;
+    } else {
+        e->nodes++;
+    }
+    return !e->outOfBudget;
+}
+
+
+// Everything that differs between positions in the search: what each
+// uni has, who has the prestige, whose turn it is and who is asking.
+// Only the hash is kept, two positions sharing one is too unlikely to
+// worry about
+static endgameEntry *positionEntry(endgame *e, const rollout *r,
+        uint64_t *hash) {
+    uint64_t h = mixHash(e->player, rolloutWhoseTurn(r));
+    int i = 0;
+    while (i < NUM_UNIS) {
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            h = mixHash(h, r->students[i][discipline]);
+            discipline++;
+        }
+        h = mixHash(h, r->kpi[i]);
+        h = mixHash(h, r->numPubs[i]);
+        h = mixHash(h, r->numIPs[i]);
+        h = mixHash(h, r->campuses[i]);
+        h = mixHash(h, r->go8s[i]);
+        h = mixHash(h, r->arcs[i].bits[0]);
+        h = mixHash(h, r->arcs[i].bits[1]);
+        i++;
+    }
+    h = mixHash(h, r->mostARCs);
+    h = mixHash(h, r->mostPubs);
+
+    *hash = h;
+    return &e->table[h >> (64 - ENDGAME_TABLE_BITS)];
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   ENDGAME FUNCTIONS BEGIN
+// =====================================================================
+
+Endgame newEndgame (long nodeBudget) {
+    Endgame e = malloc(sizeof(endgame));
+    memset(e, 0, sizeof(endgame));
+    e->nodeBudget = nodeBudget;
+    int depth = 0;
+    while (depth < MAX_ENDGAME_TURNS) {
+        e->ours[depth] = newPlanner();
+        depth++;
+    }
+    e->theirs = newPlanner();
+    return e;
+}
+
+
+void disposeEndgame (Endgame e) {
+    int depth = 0;
+    while (depth < MAX_ENDGAME_TURNS) {
+        disposePlanner(e->ours[depth]);
+        depth++;
+    }
+    disposePlanner(e->theirs);
+    free(e);
+}
+
+
+int isEndgame (const rollout *r, int player) {
+    return r->kpi[player-1] >= WINNING_KPI - ENDGAME_KPI;
+}
+
+
+// Start from the planner's plan in case the budget doesn't even cover
+// one turn, then search a turn deeper each time until it runs out. A
+// certain win can't get any better, and looking deeper would only find
+// ways of winning later
+void solveEndgame (Endgame e, const rollout *r, int maxTurns,
+        endgameResult *result) {
+    e->player = rolloutWhoseTurn(r);
+    e->nodes = 0;
+    e->outOfBudget = FALSE;
+    if (maxTurns > MAX_ENDGAME_TURNS) {
+        maxTurns = MAX_ENDGAME_TURNS;
+    }
+
+    memset(result, 0, sizeof(endgameResult));
+    if (e->player != NO_ONE) {
+        planTurn(e->theirs, r, NULL, NULL, &result->plan);
+        result->winChance = estimateChance(e, r);
+
+        int turns = 1;
+        while (turns <= maxTurns && !e->outOfBudget
+                && (turns == 1 || result->winChance < 1)) {
+            turnPlan plan;
+            e->searchTurns = turns;
+            double chance = playerTurn(e, r, turns, &plan);
+            if (!e->outOfBudget) {
+                result->plan = plan;
+                result->winChance = chance;
+                result->turnsSearched = turns;
+            }
+            turns++;
+        }
+    }
+    result->nodes = e->nodes;
+}
+
+
+// like getKPIOutlook() in Forecast.c, with the production counted up
+// the way rolloutThrowDice() hands it out
+void rolloutKPIOutlook (const rollout *r, int player,
+        kpiOutlook *outlook) {
+    const rolloutBoard *board = r->board;
+    int i = player - 1;
+    memset(outlook, 0, sizeof(kpiOutlook));
+    outlook->kpi = r->kpi[i];
+
+    int score = 2;
+    while (score <= 12) {
+        int region = 0;
+        while (region < board->numProducing[score]) {
+            vertexSet around = board->producingVertices[score][region];
+            int discipline = board->producingDiscipline[score][region];
+            outlook->production[score][discipline] +=
+                __builtin_popcountll(r->campuses[i] & around)
+                + 2 * __builtin_popcountll(r->go8s[i] & around);
+            region++;
+        }
+        score++;
+    }
+
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        outlook->students[discipline] = r->students[i][discipline];
+        outlook->exchangeRate[discipline] =
+            rolloutExchangeRate(r, player, discipline);
+        discipline++;
+    }
+    outlook->numCampuses = r->numCampuses[i];
+    outlook->numGO8s = r->numGO8s[i];
+    outlook->playingNow = (rolloutWhoseTurn(r) == player);
+}
+
+
+void solveGameEndgame (Endgame e, Game g, int maxTurns,
+        endgameResult *result) {
+    rolloutBoard board;
+    rollout r;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&r, &board, g, 0);
+    solveEndgame(e, &r, maxTurns, result);
+}
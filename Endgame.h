@@ -0,0 +1,69 @@
+/*
+ *  Endgame.h - searching the last few turns to WINNING_KPI
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Close to the end a good move is the one that makes winning most
+ *  likely, not the one worth the most KPI points. The solver looks a
+ *  few of the player's turns ahead through every roll of the dice: on
+ *  the player's turns it tries everything the planner (see Planner.h)
+ *  would consider, and the other unis play the plan that gets them
+ *  the most KPI points. Positions it hasn't the turns to see past are
+ *  scored with winChancesFrom() (see Forecast.h).
+ *
+ *  Positions already worked out are remembered, and the search stops
+ *  when it has used up its node budget. It goes one turn deeper at a
+ *  time and answers with the deepest search it finished.
+ *
+ *  Include Game.h, GameEngine.h, Rollout.h, Planner.h and Forecast.h
+ *  before this file.
+ */
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+// a uni this close to WINNING_KPI is in its endgame
+#define ENDGAME_KPI 30
+
+// the most of the player's turns the solver looks ahead
+#define MAX_ENDGAME_TURNS 4
+
+typedef struct _endgameResult {
+    // the best plan for this turn and the chance of winning with it
+    turnPlan plan;
+    double winChance;
+
+    // how many of the player's turns the answer looked ahead. 0 if the
+    // budget ran out before one turn was done, and the plan is just
+    // the planner's. Less than asked for if it found a certain win
+    int turnsSearched;
+
+    // how many nodes the whole search used
+    long nodes;
+} endgameResult;
+
+typedef struct _endgame *Endgame;
+
+// a solver which searches at most nodeBudget nodes for each answer.
+// Keep it and reuse it, it remembers positions between answers
+Endgame newEndgame (long nodeBudget);
+void disposeEndgame (Endgame e);
+
+// TRUE if the player is within ENDGAME_KPI of winning
+int isEndgame (const rollout *r, int player);
+
+// find the plan most likely to win for whoever's turn it is in r,
+// looking up to maxTurns (at most MAX_ENDGAME_TURNS) of their turns
+// ahead
+void solveEndgame (Endgame e, const rollout *r, int maxTurns,
+        endgameResult *result);
+
+// getKPIOutlook() (see Forecast.h) for the player in r
+void rolloutKPIOutlook (const rollout *r, int player,
+        kpiOutlook *outlook);
+
+// solveEndgame() for whoever's turn it is in g
+void solveGameEndgame (Endgame e, Game g, int maxTurns,
+        endgameResult *result);
+
+#endif
@@ -0,0 +1,571 @@
+/*
+ * Forecast.c - how many students a uni could have in a few turns
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Each discipline's count is pushed through one roll at a time: every
+ * count moves up by what each dice score produces, weighted by the
+ * chance of that score.
+ *
+ * The turns to win are worked out a turn at a time the same way: each
+ * turn's income goes on the plan that earns KPI points fastest, and
+ * the income grows with every campus and GO8. See Forecast.h
+ */
+
+
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Forecast.h"
+
+
+#define SEVEN 7
+
+// the ways the turns to win estimate turns students into KPI points
+#define NUM_PLANS 3
+#define CAMPUS_PLAN 0   // a campus and the two ARCs leading up to it
+#define GO8_PLAN 1
+#define SPINOFF_PLAN 2
+
+// how many times affordable() halves its guess
+#define AFFORD_STEPS 30
+
+// the least spread an estimate can have, a turn either way covers the
+// students never quite adding up to a whole build
+#define MIN_SPREAD 0.5
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// one roll for a discipline 7s don't touch (THD is handled on its own)
+static void rollPlain(double chance[], const double dice[],
+        const int gain[]);
+
+// one roll for MTV or MMONEY, which a 7 sends back to 0
+static void rollConverted(double chance[], const double dice[],
+        const int gain[]);
+
+// one roll for the pair (THD, MTV + MMONEY), which a 7 moves from the
+// second to the first
+static void rollTHD(double joint[][FORECAST_CAP], const double dice[],
+        const int thdGain[], const int convertedGain[]);
+
+// the count as an index, lumping everything past the cap into the
+// last count
+static int capped(int count);
+
+// how many of a plan (as a fraction) the students could pay for,
+// retraining what isn't needed into what is
+static double affordable(const double students[], const double cost[],
+        const int exchangeRate[]);
+
+// whether students can pay for times lots of cost
+static int canAfford(const double students[], const double cost[],
+        const int exchangeRate[], double times);
+
+// the chance a uni has won by its own turn number turn
+static double chanceWonBy(const winEstimate *estimate, int turn);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static void rollPlain(double chance[], const double dice[],
+        const int gain[]) {
+    double next[FORECAST_CAP] = {0};
+    int n = 0;
+    while (n < FORECAST_CAP) {
+        if (chance[n] != 0) {
+            int score = 2;
+            while (score <= 12) {
+                next[capped(n + gain[score])] += chance[n] * dice[score];
+                score++;
+            }
+        }
+        n++;
+    }
+    memcpy(chance, next, sizeof(next));
+}
+
+
+// the students made on a 7 are converted along with the rest
+static void rollConverted(double chance[], const double dice[],
+        const int gain[]) {
+    double next[FORECAST_CAP] = {0};
+    int n = 0;
+    while (n < FORECAST_CAP) {
+        if (chance[n] != 0) {
+            int score = 2;
+            while (score <= 12) {
+                if (score == SEVEN) {
+                    next[0] += chance[n] * dice[score];
+                } else {
+                    next[capped(n + gain[score])]
+                        += chance[n] * dice[score];
+                }
+                score++;
+            }
+        }
+        n++;
+    }
+    memcpy(chance, next, sizeof(next));
+}
+
+
+static void rollTHD(double joint[][FORECAST_CAP], const double dice[],
+        const int thdGain[], const int convertedGain[]) {
+    double next[FORECAST_CAP][FORECAST_CAP];
+    memset(next, 0, sizeof(next));
+
+    int thd = 0;
+    while (thd < FORECAST_CAP) {
+        int converted = 0;
+        while (converted < FORECAST_CAP) {
+            double p = joint[thd][converted];
+            if (p != 0) {
+                int score = 2;
+                while (score <= 12) {
+                    int newTHD = thd + thdGain[score];
+                    int newConverted = converted + convertedGain[score];
+                    if (score == SEVEN) {
+                        newTHD += newConverted;
+                        newConverted = 0;
+                    }
+                    next[capped(newTHD)][capped(newConverted)]
+                        += p * dice[score];
+                    score++;
+                }
+            }
+            converted++;
+        }
+        thd++;
+    }
+    memcpy(joint, next, sizeof(next));
+}
+
+
+static int capped(int count) {
+    if (count >= FORECAST_CAP) {
+        count = FORECAST_CAP - 1;
+    }
+    return count;
+}
+
+
+// canAfford() only gets harder as times goes up, so halve the gap
+// between what can and can't be paid for. It can never be more than
+// all the students over the whole cost
+static double affordable(const double students[], const double cost[],
+        const int exchangeRate[]) {
+    double total = 0;
+    double totalCost = 0;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        total += students[discipline];
+        totalCost += cost[discipline];
+        discipline++;
+    }
+
+    double low = 0;
+    double high = total / totalCost;
+    if (canAfford(students, cost, exchangeRate, high)) {
+        low = high;
+    }
+    int step = 0;
+    while (step < AFFORD_STEPS && low < high) {
+        double middle = (low + high) / 2;
+        if (canAfford(students, cost, exchangeRate, middle)) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+        step++;
+    }
+    return low;
+}
+
+
+static int canAfford(const double students[], const double cost[],
+        const int exchangeRate[], double times) {
+    double missing = 0;
+    double retrained = 0;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        double left = students[discipline] - times * cost[discipline];
+        if (left < 0) {
+            missing -= left;
+        } else if (discipline != STUDENT_THD) {
+            retrained += left / exchangeRate[discipline];
+        }
+        discipline++;
+    }
+    return missing <= retrained;
+}
+
+
+// The estimate says the uni wins partway through turn ceil(turns), so
+// centre the normal curve half a turn before each whole turn. Nobody
+// has won before their first turn
+static double chanceWonBy(const winEstimate *estimate, int turn) {
+    double chance = 0;
+    if (turn > 0) {
+        double z = (turn + 0.5 - estimate->turns) / estimate->spread;
+        chance = erfc(-z / sqrt(2)) / 2;
+    }
+    return chance;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   FORECAST FUNCTIONS BEGIN
+// =====================================================================
+
+void forecastStudents (Game g, int player, int rolls,
+        studentForecast *forecast) {
+    int production[NUM_DICE_SCORES][NUM_DISCIPLINES];
+    int students[NUM_DISCIPLINES];
+    getProduction(g, player, production);
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        students[discipline] = getStudents(g, player, discipline);
+        discipline++;
+    }
+    forecastFromProduction(production, students, rolls, forecast);
+}
+
+
+// Start each discipline as a certainty at the students there are now,
+// then roll it forward. THD needs MTV + MMONEY alongside it for the 7s
+void forecastFromProduction (
+        const int production[NUM_DICE_SCORES][NUM_DISCIPLINES],
+        const int students[NUM_DISCIPLINES], int rolls,
+        studentForecast *forecast) {
+    double dice[NUM_DICE_SCORES];
+    int gain[NUM_DISCIPLINES][NUM_DICE_SCORES];
+    int convertedGain[NUM_DICE_SCORES];
+    int score = 0;
+    while (score < NUM_DICE_SCORES) {
+        dice[score] = getDiceChance(score);
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            gain[discipline][score] = production[score][discipline];
+            discipline++;
+        }
+        convertedGain[score] = production[score][STUDENT_MTV]
+            + production[score][STUDENT_MMONEY];
+        score++;
+    }
+
+    memset(forecast, 0, sizeof(studentForecast));
+    forecast->rolls = rolls;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        forecast->chance[discipline][capped(students[discipline])] = 1;
+        discipline++;
+    }
+
+    double joint[FORECAST_CAP][FORECAST_CAP];
+    memset(joint, 0, sizeof(joint));
+    joint[capped(students[STUDENT_THD])][capped(students[STUDENT_MTV]
+            + students[STUDENT_MMONEY])] = 1;
+
+    int roll = 0;
+    while (roll < rolls) {
+        rollPlain(forecast->chance[STUDENT_BPS], dice, gain[STUDENT_BPS]);
+        rollPlain(forecast->chance[STUDENT_BQN], dice, gain[STUDENT_BQN]);
+        rollPlain(forecast->chance[STUDENT_MJ], dice, gain[STUDENT_MJ]);
+        rollConverted(forecast->chance[STUDENT_MTV], dice,
+                gain[STUDENT_MTV]);
+        rollConverted(forecast->chance[STUDENT_MMONEY], dice,
+                gain[STUDENT_MMONEY]);
+        rollTHD(joint, dice, gain[STUDENT_THD], convertedGain);
+        roll++;
+    }
+
+    // THD on its own is the joint chance summed over MTV + MMONEY
+    memset(forecast->chance[STUDENT_THD], 0,
+            sizeof(forecast->chance[STUDENT_THD]));
+    int thd = 0;
+    while (thd < FORECAST_CAP) {
+        int converted = 0;
+        while (converted < FORECAST_CAP) {
+            forecast->chance[STUDENT_THD][thd] += joint[thd][converted];
+            converted++;
+        }
+        thd++;
+    }
+}
+
+
+double chanceOfAtLeast (const studentForecast *forecast, int discipline,
+        int n) {
+    double chance = 0;
+    if (n < 0) {
+        n = 0;
+    }
+    while (n < FORECAST_CAP) {
+        chance += forecast->chance[discipline][n];
+        n++;
+    }
+    return chance;
+}
+
+
+double expectedStudents (const studentForecast *forecast,
+        int discipline) {
+    double expected = 0;
+    int n = 0;
+    while (n < FORECAST_CAP) {
+        expected += n * forecast->chance[discipline][n];
+        n++;
+    }
+    return expected;
+}
+
+
+// =====================================================================
+//   FORECAST FUNCTIONS END
+//   TURNS TO WIN FUNCTIONS BEGIN
+// =====================================================================
+
+void getKPIOutlook (Game g, int player, kpiOutlook *outlook) {
+    memset(outlook, 0, sizeof(kpiOutlook));
+    outlook->kpi = getKPIpoints(g, player);
+    getProduction(g, player, outlook->production);
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        outlook->students[discipline] = getStudents(g, player, discipline);
+        outlook->exchangeRate[discipline] =
+            getExchangeRateFast(g, player, discipline);
+        discipline++;
+    }
+    outlook->numCampuses = getCampuses(g, player);
+    outlook->numGO8s = getGO8s(g, player);
+    outlook->playingNow = (getWhoseTurn(g) == player);
+}
+
+
+// Income here is per turn of the uni's own, which is one roll for each
+// uni. THD can't be spent or retrained so it isn't counted. The spread
+// comes from how much a turn's income varies against its average
+winEstimate estimateWin (const kpiOutlook *outlook) {
+    double income[NUM_DISCIPLINES] = {0};
+    double rollMean = 0;
+    double rollSquares = 0;
+    int score = 2;
+    while (score <= 12) {
+        double rolled = 0;
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            if (discipline != STUDENT_THD) {
+                double gain = outlook->production[score][discipline];
+                income[discipline] += NUM_UNIS * getDiceChance(score) * gain;
+                rolled += gain;
+            }
+            discipline++;
+        }
+        rollMean += getDiceChance(score) * rolled;
+        rollSquares += getDiceChance(score) * rolled * rolled;
+        score++;
+    }
+
+    // every campus brings in about as much as the ones there already,
+    // and a GO8 counts as two
+    double perCampus[NUM_DISCIPLINES] = {0};
+    double campuses = outlook->numCampuses;
+    double go8s = outlook->numGO8s;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        if (campuses + 2 * go8s > 0) {
+            perCampus[discipline] = income[discipline]
+                / (campuses + 2 * go8s);
+        }
+        discipline++;
+    }
+
+    double cost[NUM_PLANS][NUM_DISCIPLINES];
+    double planKPI[NUM_PLANS] = {CAMPUS_KPI + 2 * ARC_KPI,
+        GO8_KPI - CAMPUS_KPI, (double)IP_KPI / IP_PATENT_ODDS};
+    discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        cost[CAMPUS_PLAN][discipline] = actionCosts[BUILD_CAMPUS][discipline]
+            + 2 * actionCosts[OBTAIN_ARC][discipline];
+        cost[GO8_PLAN][discipline] = actionCosts[BUILD_GO8][discipline];
+        cost[SPINOFF_PLAN][discipline] =
+            actionCosts[START_SPINOFF][discipline];
+        discipline++;
+    }
+
+    double kpi = outlook->kpi;
+    double turns = 0;
+    while (kpi < WINNING_KPI && turns < WIN_TURNS_CAP) {
+        // the first turn also has the students the uni has now, but if
+        // it's playing now the dice haven't brought in any more yet
+        double spend[NUM_DISCIPLINES];
+        discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            spend[discipline] = income[discipline];
+            if (turns == 0) {
+                spend[discipline] = outlook->students[discipline];
+                if (!outlook->playingNow) {
+                    spend[discipline] += income[discipline];
+                }
+            }
+            discipline++;
+        }
+
+        int best = CAMPUS_PLAN;
+        double bestTimes = 0;
+        int plan = 0;
+        while (plan < NUM_PLANS) {
+            double times = affordable(spend, cost[plan],
+                    outlook->exchangeRate);
+            if (plan == GO8_PLAN && times > campuses) {
+                times = campuses;
+            }
+            if (times * planKPI[plan] > bestTimes * planKPI[best]) {
+                best = plan;
+                bestTimes = times;
+            }
+            plan++;
+        }
+
+        // a turn that gains nothing leaves the next one just the same
+        double gained = bestTimes * planKPI[best];
+        if (gained == 0 && turns > 0) {
+            turns = WIN_TURNS_CAP;
+        } else if (kpi + gained >= WINNING_KPI) {
+            turns += (WINNING_KPI - kpi) / gained;
+        } else {
+            turns++;
+        }
+        kpi += gained;
+
+        if (best != SPINOFF_PLAN) {
+            discipline = 0;
+            while (discipline < NUM_DISCIPLINES) {
+                income[discipline] += bestTimes * perCampus[discipline];
+                discipline++;
+            }
+            if (best == CAMPUS_PLAN) {
+                campuses += bestTimes;
+            } else {
+                campuses -= bestTimes;
+            }
+        }
+    }
+
+    winEstimate estimate = {.turns = turns, .spread = MIN_SPREAD};
+    if (turns > WIN_TURNS_CAP) {
+        estimate.turns = WIN_TURNS_CAP;
+    }
+    if (rollMean > 0) {
+        double rollSpread = sqrt(rollSquares - rollMean * rollMean);
+        double spread = rollSpread / (rollMean * sqrt(NUM_UNIS))
+            * sqrt(estimate.turns);
+        if (spread > estimate.spread) {
+            estimate.spread = spread;
+        }
+    }
+    return estimate;
+}
+
+
+double turnsToWin (Game g, int player) {
+    kpiOutlook outlook;
+    getKPIOutlook(g, player, &outlook);
+    return estimateWin(&outlook).turns;
+}
+
+
+// Uni i wins on its turn number t if it has won by then but not by its
+// turn before, the unis before it this round haven't won by their turn
+// t and the unis after it haven't won by their turn t-1. Whatever
+// chance is left of nobody winning in WIN_TURNS_CAP turns is shared
+// out in proportion. Once some uni is sure to have won nobody else can
+// win later, so stop there
+void winChancesFrom (const winEstimate estimates[NUM_UNIS], int firstUni,
+        double chance[NUM_UNIS]) {
+    double total = 0;
+    double wonBefore[NUM_UNIS];
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        chance[uni] = 0;
+        wonBefore[uni] = 0;
+        uni++;
+    }
+
+    int certain = FALSE;
+    int turn = 1;
+    while (turn <= WIN_TURNS_CAP && !certain) {
+        double wonBy[NUM_UNIS];
+        uni = 0;
+        while (uni < NUM_UNIS) {
+            wonBy[uni] = chanceWonBy(&estimates[uni], turn);
+            uni++;
+        }
+
+        int i = 0;
+        while (i < NUM_UNIS) {
+            int winner = (firstUni - 1 + i) % NUM_UNIS;
+            double p = wonBy[winner] - wonBefore[winner];
+            int j = 0;
+            while (j < NUM_UNIS) {
+                int other = (firstUni - 1 + j) % NUM_UNIS;
+                if (j < i) {
+                    p *= 1 - wonBy[other];
+                } else if (j > i) {
+                    p *= 1 - wonBefore[other];
+                }
+                j++;
+            }
+            chance[winner] += p;
+            total += p;
+            i++;
+        }
+
+        uni = 0;
+        while (uni < NUM_UNIS) {
+            wonBefore[uni] = wonBy[uni];
+            if (wonBy[uni] == 1) {
+                certain = TRUE;
+            }
+            uni++;
+        }
+        turn++;
+    }
+
+    uni = 0;
+    while (uni < NUM_UNIS) {
+        if (total > 0) {
+            chance[uni] /= total;
+        } else {
+            chance[uni] = 1.0 / NUM_UNIS;
+        }
+        uni++;
+    }
+}
+
+
+void getWinChances (Game g, double chance[NUM_UNIS]) {
+    winEstimate estimates[NUM_UNIS];
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        kpiOutlook outlook;
+        getKPIOutlook(g, player, &outlook);
+        estimates[player-1] = estimateWin(&outlook);
+        player++;
+    }
+
+    int firstUni = getWhoseTurn(g);
+    if (firstUni == NO_ONE) {
+        firstUni = UNI_A;
+    }
+    winChancesFrom(estimates, firstUni, chance);
+}
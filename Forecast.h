@@ -0,0 +1,117 @@
+/*
+ *  Forecast.h - how many students a uni could have in a few turns
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  The average income per roll hides how likely a uni really is to
+ *  have (say) the 2 MJ and 3 MMONEY for a GO8 by a certain turn. These
+ *  work out the exact chance of having each number of students of each
+ *  discipline after some number of dice rolls, from what the uni
+ *  produces on each score (see getProduction()), including 7s turning
+ *  MTVs and MMONEYs into THDs.
+ *
+ *  The disciplines all come from the same dice, so they aren't
+ *  independent of each other: each discipline's forecast is exact on
+ *  its own, but multiplying two of them together is only a guess at
+ *  the chance of both.
+ *
+ *  Include Game.h and GameEngine.h before this file.
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+// forecasts count up to FORECAST_CAP-1 students of a discipline, the
+// last count stands for "that many or more"
+#define FORECAST_CAP 64
+
+typedef struct _studentForecast {
+    // how many rolls the forecast is for
+    int rolls;
+
+    // chance[discipline][n] is the chance of having exactly n students
+    // of the discipline after the rolls
+    double chance[NUM_DISCIPLINES][FORECAST_CAP];
+} studentForecast;
+
+// forecast the player's students after the dice are thrown rolls more
+// times, starting from what they have now. Assumes they don't build
+// or retrain in the meantime
+void forecastStudents (Game g, int player, int rolls,
+        studentForecast *forecast);
+
+// the same from a production table and starting students, so search
+// can forecast for a board the game isn't in yet (eg after a GO8)
+void forecastFromProduction (
+        const int production[NUM_DICE_SCORES][NUM_DISCIPLINES],
+        const int students[NUM_DISCIPLINES], int rolls,
+        studentForecast *forecast);
+
+// the chance of having at least n students of the discipline
+double chanceOfAtLeast (const studentForecast *forecast, int discipline,
+        int n);
+
+// the average number of students of the discipline
+double expectedStudents (const studentForecast *forecast,
+        int discipline);
+
+
+// =====================================================================
+//   TURNS TO WIN
+// =====================================================================
+
+// Estimates of how many more of its own turns a uni needs to reach
+// WINNING_KPI. Each turn it spends its income (retraining where it has
+// to) on whichever of a campus with two ARCs, a GO8 or a spinoff earns
+// KPI points fastest, and campuses and GO8s bring in more income for
+// the turns after. It's a rough guide for search and for showing who
+// is ahead, not a plan: it ignores where there is room to build and
+// the prestige awards.
+
+// the estimate gives up after this many turns
+#define WIN_TURNS_CAP 500
+
+// everything the estimate needs about a uni, so search can fill one in
+// from its own copy of the game
+typedef struct _kpiOutlook {
+    int kpi;
+    int students[NUM_DISCIPLINES];
+    int production[NUM_DICE_SCORES][NUM_DISCIPLINES];
+    // students of each discipline it takes to retrain to 1 of another
+    // (THD is never retrained from)
+    int exchangeRate[NUM_DISCIPLINES];
+    int numCampuses;
+    int numGO8s;
+    // TRUE if it is the uni's turn now, so it has to make do with the
+    // students it has before the dice bring in any more
+    int playingNow;
+} kpiOutlook;
+
+typedef struct _winEstimate {
+    // own turns until the uni has WINNING_KPI, counting this one if it
+    // is playingNow. 0 if it already has, WIN_TURNS_CAP if never
+    double turns;
+    // the standard deviation of that from the luck of the dice
+    double spread;
+} winEstimate;
+
+// fill in the outlook for the player in g
+void getKPIOutlook (Game g, int player, kpiOutlook *outlook);
+
+// estimate how long the uni needs to win
+winEstimate estimateWin (const kpiOutlook *outlook);
+
+// estimateWin() for the player in g
+double turnsToWin (Game g, int player);
+
+// the chance of each uni (indexed player-1) reaching WINNING_KPI
+// first, treating the estimates as normal distributions. firstUni is
+// the uni which plays first from now on
+void winChancesFrom (const winEstimate estimates[NUM_UNIS], int firstUni,
+        double chance[NUM_UNIS]);
+
+// winChancesFrom() for the unis in g, starting from whoever's turn it
+// is (UNI_A during Terra Nullis)
+void getWinChances (Game g, double chance[NUM_UNIS]);
+
+#endif
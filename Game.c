@@ -16,7 +16,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "Game.h" // See Game.h for all API functions and structs
+#include "GameEngine.h" // extensions to the API which Game.h can't hold
 
 
 #define GRID_WIDTH 7
@@ -24,17 +30,51 @@
 #define NUM_ARCS_PER_HEX 3
 #define NUM_VERTICES_PER_HEX 2
 #define NUM_RETRAINS_PER_HEX 2
-#define NUM_DISCIPLINES 6
 #define NUM_RETRAINING_CENTRES 10
 #define DISCOUNT_EXCHANGE_RATE 2
 #define DEFAULT_EXCHANGE_RATE 3
 #define OUTSIDE_BOARD -1
 
-#define CAMPUS_KPI 10
-#define GO8_KPI 20
-#define ARC_KPI 2
-#define IP_KPI 10
-#define PRESTIGE_BONUS 10
+// the constants of the splitmix64 generator, which mixHash() uses
+#define MIX_STEP 0x9E3779B97F4A7C15ULL
+#define MIX_MULTIPLIER_1 0xBF58476D1CE4E5B9ULL
+#define MIX_MULTIPLIER_2 0x94D049BB133111EBULL
+
+// actions whose cost is a fixed row in actionCosts (everything but
+// retraining, which depends on the exchange rate)
+#define FIXED_COST_ACTIONS (~(1 << RETRAIN_STUDENTS))
+
+// argument checks on the API in Game.h (the "checked" API that
+// untrusted callers such as player AIs go through). Normally these
+// are asserts, and vanish when NDEBUG is defined. Building with
+// -DGAME_HARD_CHECKS keeps every check as a hard error in all builds.
+// The unchecked fast path API in GameEngine.h never checks anything
+#ifdef GAME_HARD_CHECKS
+#define CHECK(condition, message) \
+    ((condition) ? (void)0 : checkFailed(message, __func__))
+#else
+#define CHECK(condition, message) assert((condition) && message)
+#endif
+
+#define IS_PLAYER(player) \
+    ((player) == UNI_A || (player) == UNI_B || (player) == UNI_C)
+#define IS_DISCIPLINE(discipline) \
+    ((discipline) >= STUDENT_THD && (discipline) <= STUDENT_MMONEY)
+
+// tell the game's observer (if it has one, and it cares) that
+// something happened, eg NOTIFY(g, onARCBuilt, player, path).
+// Building with NO_GAME_EVENTS takes every notification out, otherwise
+// a game with no observer pays one pointer test per event
+#ifdef NO_GAME_EVENTS
+#define NOTIFY(g, callback, ...) do { } while (0)
+#else
+#define NOTIFY(g, callback, ...) do { \
+    if ((g)->observer != NULL && (g)->observer->callback != NULL) { \
+        (g)->observer->callback((g)->observer->context, (g), \
+                __VA_ARGS__); \
+    } \
+} while (0)
+#endif
 
 
 
@@ -126,11 +166,127 @@ typedef struct _game {
     // holds which uni has the most publications and how many they have
     int uniWithMostPubs;
     int uniWithMostPubs_number;
+
+    // each uni's network, by vertex ID: every vertex its campuses,
+    // GO8s and ARCs touch, and the ones at the ends of its ARCs (where
+    // it may build campuses). Only ever grow
+    vertexSet network[NUM_UNIS];
+    vertexSet arcEnds[NUM_UNIS];
+
+    // which connected piece of its network each vertex is in, as a
+    // disjoint set forest over vertex IDs (union by size). A vertex
+    // not in the network is on its own
+    int networkParent[NUM_UNIS][NUM_VERTICES];
+    int networkSize[NUM_UNIS][NUM_VERTICES];
+
+    // where each uni could build a campus/ARC right now (if it could
+    // pay), kept up to date as anyone builds. See updateFrontiers()
+    vertexSet campusFrontier[NUM_UNIS];
+    edgeSet arcFrontier[NUM_UNIS];
+
+    // vertices with a campus or next to one (nobody can build there)
+    // and edges with an ARC
+    vertexSet campusBlocked;
+    edgeSet arcsTaken;
+
+    // who to tell when things happen, NULL if no-one is listening.
+    // See setGameObserver()
+    const gameObserver *observer;
 } game;
 
 
+// Where a retraining centre is and which discipline it retrains
+typedef struct _retrainingCentre {
+    int x;
+    int y;
+    int vertNum;
+    int discipline;
+} retrainingCentre;
+
+
+// Every vertex and edge on the island gets a small integer ID so the
+// engine can refer to them without walking a path. The IDs number the
+// vertices 0..NUM_VERTICES-1 and edges 0..NUM_EDGES-1 going through
+// the grid column by column. The same for every game, so there is one
+// copy shared by all of them, built the first time a game is made.
+typedef struct _boardGeometry {
+    // the grid coordinate of each vertex/edge ID
+    coord vertexCoord[NUM_VERTICES];
+    coord edgeCoord[NUM_EDGES];
+
+    // the ID at each grid position, NO_VERTEX/NO_EDGE in the sea
+    int vertexID[GRID_WIDTH][GRID_HEIGHT][NUM_VERTICES_PER_HEX];
+    int edgeID[GRID_WIDTH][GRID_HEIGHT][NUM_ARCS_PER_HEX];
+
+    // what is next to what, by ID. Handed out by getBoardGraph()
+    boardGraph graph;
+
+    // the canonical path to each vertex and along each edge, see
+    // findShortestPaths() and pathOfVertex()
+    path vertexPath[NUM_VERTICES];
+    path edgePath[NUM_EDGES];
+} boardGeometry;
+
+
+// The last game state published for other threads to read, guarded by
+// a sequence number (a seqlock). The writer makes the number odd,
+// copies the game in, then makes it even again. A reader copies the
+// game out between two reads of the number and keeps the copy if the
+// number was even and hadn't changed, otherwise it tries again.
+// The copy is kept as atomic words so a reader racing the writer
+// reads stale words rather than undefined behaviour
+#define PUBLISHED_WORDS ((sizeof(game) + sizeof(uint64_t) - 1) \
+        / sizeof(uint64_t))
+
+typedef struct _gamePublisher {
+    atomic_uint sequence;
+    _Atomic uint64_t words[PUBLISHED_WORDS];
+} gamePublisher;
+
+
 // =====================================================================
 //   TYPEDEFS/STRUCTS END
+//   RULES TABLES BEGIN
+// =====================================================================
+
+// the students each action costs, one padded row per action code.
+// Columns are THD, BPS, BQN, MJ, MTV, MMONEY then two padding lanes.
+// This is the only place the costs are written down, makeAction()
+// pays from it and isLegalAction() checks against it.
+const short actionCosts[NUM_ACTION_CODES][COST_LANES] = {
+    [PASS]               = {0, 0, 0, 0, 0, 0, 0, 0},
+    [BUILD_CAMPUS]       = {0, 1, 1, 1, 1, 0, 0, 0},
+    [BUILD_GO8]          = {0, 0, 0, 2, 0, 3, 0, 0},
+    [OBTAIN_ARC]         = {0, 1, 1, 0, 0, 0, 0, 0},
+    [START_SPINOFF]      = {0, 0, 0, 1, 1, 1, 0, 0},
+    [OBTAIN_PUBLICATION] = {0, 0, 0, 1, 1, 1, 0, 0},
+    [OBTAIN_IP_PATENT]   = {0, 0, 0, 1, 1, 1, 0, 0},
+    [RETRAIN_STUDENTS]   = {0, 0, 0, 0, 0, 0, 0, 0}
+};
+
+
+// the ten retraining centres, two of each kind
+static const retrainingCentre retrainingCentres[NUM_RETRAINING_CENTRES] 
+        = {
+    {2, 5, 0, STUDENT_MTV},
+    {2, 5, 1, STUDENT_MTV},
+    {4, 4, 0, STUDENT_MMONEY},
+    {4, 4, 1, STUDENT_MMONEY},
+    {6, 1, 0, STUDENT_BQN},
+    {5, 1, 1, STUDENT_BQN},
+    {5, 0, 0, STUDENT_MJ},
+    {4, 0, 1, STUDENT_MJ},
+    {1, 2, 1, STUDENT_BPS},
+    {2, 1, 0, STUDENT_BPS}
+};
+
+// the vertex and edge IDs, see buildBoardGeometry()
+static boardGeometry board;
+static pthread_once_t boardBuilt = PTHREAD_ONCE_INIT;
+
+
+// =====================================================================
+//   RULES TABLES END
 //   STATIC FUNCTION DECLARATIONS BEGIN
 // =====================================================================
 
@@ -155,16 +311,101 @@ static int isPathContained(path inPath);
 // when building a new campus, call "isCampusConnected" on the 
 // destination vertex to ensure there are arcs adjacent. When building 
 // an ARC, call isARCConnected on the destination edge to ensure an
-// ARC or campus is adjacent
-static int isARCConnected(path inPath, Game g, int player);
-static int isCampusConnected(path inPath, Game g, int player);
+// ARC, campus or GO8 is adjacent
+static int isARCConnected(Game g, int edge, int player);
+static int isCampusConnected(Game g, int vertex, int player);
+
+// add a campus/ARC to the player's network, joining up the pieces
+// it connects
+static void addCampusToNetwork(Game g, int player, int vertex);
+static void addARCToNetwork(Game g, int player, int edge);
 
-// returns true if there are campuses next to the vertex at inPath
-static int isCampusTooClose(Game g, path inPath);
+// the vertex standing for the piece of the player's network the
+// vertex is in (halving the path up the tree as it goes)
+static int findNetworkRoot(Game g, int player, int vertex);
+
+// update every uni's frontiers for a new campus/ARC by player
+static void addCampusToFrontiers(Game g, int player, int vertex);
+static void addARCToFrontiers(Game g, int player, int edge);
 
 // returns true if the coordinate is inside the board
 static int isCoordInside(coord c);
 
+// take the students for a fixed cost action (see actionCosts) away
+// from the player
+static void payForAction(Game g, int player, int actionCode);
+
+// work out who holds a prestige award (most ARCs or most publications)
+// after "player" goes up to newCount of the thing it is awarded for.
+// The bonus that changes hands is added to kpiChange [A, B, C] and the
+// new holder and their count are written to newHolder/newHolderCount.
+// makeAction() and previewAction() both use this so they always agree
+static void awardPrestige(int holder, int holderCount, int player,
+        int newCount, int kpiChange[], int *newHolder, 
+        int *newHolderCount);
+
+// awardPrestige() for most publications, which works a little
+// differently: see the function
+static void awardPublicationPrestige(int holder, int holderCount,
+        int player, int newCount, int kpiChange[], int *newHolder,
+        int *newHolderCount);
+
+// add a change in KPI [A, B, C] to every university's KPI
+static void addKPI(Game g, int kpiChange[]);
+
+// add the students a campus on vertex v is expected to produce per
+// dice roll to income[NUM_DISCIPLINES]
+static void addVertexIncome(Game g, coord v, double income[]);
+
+// the chance of rolling diceScore with two six sided dice
+static double diceChance(int diceScore);
+
+#ifdef GAME_HARD_CHECKS
+// report a failed CHECK and stop the program
+static void checkFailed(const char *message, const char *function);
+#endif
+
+// number every vertex and edge on the island (see boardGeometry).
+// Run once through pthread_once by newGame()
+static void buildBoardGeometry(void);
+
+// the ID of the vertex/edge at a grid coordinate, or NO_VERTEX/NO_EDGE
+// if it is in the sea or off the grid
+static int coordToVertexID(coord c);
+static int coordToEdgeID(coord c);
+static int vertexIDAt(int x, int y, int vertNum);
+static int edgeIDAt(int x, int y, int arcNum);
+
+// fill in the adjacency tables of the board graph from the IDs
+static void linkBoardGraph(void);
+
+// fill in the canonical path to every vertex and edge with a breadth
+// first search over paths
+static void findShortestPaths(void);
+
+// what is on the vertex/edge at the end of a path. These don't check
+// the path, the caller must already know it is on the board
+static int campusAtPath(Game g, path inPath);
+static int arcAtPath(Game g, path inPath);
+
+// the exchange rate, without any checking
+static int exchangeRate(Game g, int player, int disciplineFrom);
+
+// makeAction() without copying the action
+static void applyAction(Game g, const action *a);
+
+// checkAction() for an action in an applyActions() batch, where a
+// publication or IP patent is the outcome of a spinoff
+static int checkBatchAction(Game g, const action *a);
+
+// returns TRUE if the path is made of L/R/B, is terminated inside
+// PATH_LIMIT characters and isPathContained() accepts it
+static int isLegalPath(const char *p);
+
+// fold value into a hash so every bit of it changes every bit of hash
+// (the splitmix64 finaliser)
+static uint64_t mixHash(uint64_t hash, uint64_t value);
+
 
 // =====================================================================
 //   STATIC FUNCTION DECLARATIONS END
@@ -450,39 +691,6 @@ static int isPathContained(path inPath) {
 }
 
 
-// Returns true if there are campuses adjacent to the vertex located at
-// path "inPath"
-static int isCampusTooClose(Game g, path inPath) {
-    assert(isPathContained(inPath) == TRUE && "INVALID PATH");
-
-    int isTooClose = FALSE;
-    coord c = pathToVertex(inPath);
-    if (c.vertNum == 0) {
-        if (g->grid[c.x][c.y].vertices[1] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        } 
-        if (g->grid[c.x-1][c.y].vertices[1] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        } 
-        if (g->grid[c.x-1][c.y+1].vertices[1] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        }
-    } else if (c.vertNum == 1) {
-        if (g->grid[c.x][c.y].vertices[0] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        } 
-        if (g->grid[c.x+1][c.y].vertices[0] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        }
-        if (g->grid[c.x+1][c.y-1].vertices[0] != VACANT_VERTEX) {
-            isTooClose = TRUE;
-        }
-    }
-
-    return isTooClose;
-}
-
-
 // Returns true if the coordinate is inside the board, false otherwise
 // the original way of doing this was to check if coordToRegID returned
 // -1, however that wouldn't work for hexes that lay outside the board
@@ -555,60 +763,625 @@ static int isCoordInside(coord c) {
 }
 
 
-static int isARCConnected(path inPath, Game g, int player) {
-   assert(isPathContained(inPath) == TRUE && "INVALID PATH");
-   assert((player == UNI_A || player == UNI_B || player == UNI_C)
-           && "INVALID PLAYER");
-
-   int connected = FALSE;
-
-   path pL,pR,pBL,pBR,v0,v1;
-   strcpy(pL, inPath);
-   strcat(pL, "L");
-   strcpy(pR, inPath);
-   strcat(pR, "R");
-   strcpy(pBL, inPath);
-   strcat(pBL, "BL");
-   strcpy(pBR, inPath);
-   strcat(pBR, "BR");
-   strcpy(v1, inPath);
-   strcat(v1, "B");
-   strcpy(v0, inPath);
-
-   if ((isPathContained(pL) && getARC(g,pL) == player)
-           || (isPathContained(pR) && getARC(g,pR) == player)
-           || (isPathContained(pBL) && getARC(g,pBL) == player)
-           || (isPathContained(pBR) && getARC(g,pBR) == player)
-           || (isPathContained(v0) && getCampus(g,v0) == player)
-           || (isPathContained(v1) && getCampus(g,v1) == player)) {
-      connected = TRUE;
-   }
+// the edge is connected when either end is on the player's network
+static int isARCConnected(Game g, int edge, int player) {
+    return (board.graph.edgeEndSet[edge] & g->network[player-1]) != 0;
+}
+
+
+// a campus needs one of the player's ARCs on an edge of its vertex
+static int isCampusConnected(Game g, int vertex, int player) {
+    return (g->arcEnds[player-1] & VERTEX_BIT(vertex)) != 0;
+}
+
 
-   return connected;
+static void addCampusToNetwork(Game g, int player, int vertex) {
+    g->network[player-1] |= VERTEX_BIT(vertex);
 }
 
 
-static int isCampusConnected(path inPath, Game g, int player){
-   assert(isPathContained(inPath) == TRUE && "INVALID PATH");
-   assert((player == UNI_A || player == UNI_B || player == UNI_C)
-           && "INVALID PLAYER");
+// the ARC's two ends go into the network and their pieces become one,
+// the smaller piece hanging off the root of the bigger
+static void addARCToNetwork(Game g, int player, int edge) {
+    int *parent = g->networkParent[player-1];
+    int *size = g->networkSize[player-1];
+    g->network[player-1] |= board.graph.edgeEndSet[edge];
+    g->arcEnds[player-1] |= board.graph.edgeEndSet[edge];
+
+    int rootA = findNetworkRoot(g, player, board.graph.edgeEnds[edge][0]);
+    int rootB = findNetworkRoot(g, player, board.graph.edgeEnds[edge][1]);
+    if (rootA != rootB) {
+        if (size[rootA] < size[rootB]) {
+            int swap = rootA;
+            rootA = rootB;
+            rootB = swap;
+        }
+        parent[rootB] = rootA;
+        size[rootA] += size[rootB];
+    }
+}
+
 
-   int connected = FALSE;
+static int findNetworkRoot(Game g, int player, int vertex) {
+    int *parent = g->networkParent[player-1];
+    while (parent[vertex] != vertex) {
+        parent[vertex] = parent[parent[vertex]];
+        vertex = parent[vertex];
+    }
+    return vertex;
+}
 
-   path pL;
-   path pR;
-   strcpy(pL, inPath);
-   strcat(pL, "L");
-   strcpy(pR, inPath);
-   strcat(pR, "R");
 
-   if ((isPathContained(pL) && getARC(g,pL) == player)
-           || (isPathContained(pR) && getARC(g,pR) == player)
-           || (isPathContained(inPath) && getARC(g,inPath) == player)) {
-      connected = TRUE;
-   }
+// A new campus takes its vertex and the ones next to it away from
+// everyone, and opens up the free edges around it to its owner
+static void addCampusToFrontiers(Game g, int player, int vertex) {
+    const boardGraph *graph = &board.graph;
+    g->campusBlocked |= VERTEX_BIT(vertex) | graph->neighbourSet[vertex];
+
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        g->campusFrontier[uni] &= ~g->campusBlocked;
+        uni++;
+    }
+
+    edgeSet *arcs = &g->arcFrontier[player-1];
+    arcs->bits[0] |= graph->vertexEdgeSet[vertex].bits[0]
+        & ~g->arcsTaken.bits[0];
+    arcs->bits[1] |= graph->vertexEdgeSet[vertex].bits[1]
+        & ~g->arcsTaken.bits[1];
+}
+
+
+// A new ARC takes its edge away from everyone, and opens up its ends
+// (unless blocked) and the free edges around them to its owner
+static void addARCToFrontiers(Game g, int player, int edge) {
+    const boardGraph *graph = &board.graph;
+    edgeSetAdd(&g->arcsTaken, edge);
+
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        edgeSetRemove(&g->arcFrontier[uni], edge);
+        uni++;
+    }
+
+    g->campusFrontier[player-1] 
+        |= graph->edgeEndSet[edge] & ~g->campusBlocked;
+
+    edgeSet *arcs = &g->arcFrontier[player-1];
+    int end = 0;
+    while (end < 2) {
+        const edgeSet *around 
+            = &graph->vertexEdgeSet[graph->edgeEnds[edge][end]];
+        arcs->bits[0] |= around->bits[0] & ~g->arcsTaken.bits[0];
+        arcs->bits[1] |= around->bits[1] & ~g->arcsTaken.bits[1];
+        end++;
+    }
+}
+
+
+// Subtract the row of actionCosts for this action from the player's
+// students. The caller must already know they can afford it.
+static void payForAction(Game g, int player, int actionCode) {
+    assert(actionCode >= 0 && actionCode < NUM_ACTION_CODES
+            && "INVALID ACTION CODE");
+
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        g->studentAmounts[player-1][discipline] 
+            -= actionCosts[actionCode][discipline];
+        discipline++;
+    }
+}
+
+
+// If the player already holds the award they keep it and it just
+// records their new count. Otherwise they take it (and the bonus) once
+// they have strictly more than the current holder.
+static void awardPrestige(int holder, int holderCount, int player,
+        int newCount, int kpiChange[], int *newHolder, 
+        int *newHolderCount) {
+    if (holder == player) {
+        holderCount = newCount;
+    } else if (newCount > holderCount) {
+        if (holder != NO_ONE) {
+            kpiChange[holder-1] -= PRESTIGE_BONUS;
+        }
+        kpiChange[player-1] += PRESTIGE_BONUS;
+        holder = player;
+        holderCount = newCount;
+    }
+
+    *newHolder = holder;
+    *newHolderCount = holderCount;
+}
+
+
+// Anyone going past the holder's count takes the award, and that
+// includes the holder going past their own count, so they get the bonus
+// again for every publication that extends their lead
+static void awardPublicationPrestige(int holder, int holderCount,
+        int player, int newCount, int kpiChange[], int *newHolder,
+        int *newHolderCount) {
+    if (newCount > holderCount) {
+        if (holder != NO_ONE && holder != player) {
+            kpiChange[holder-1] -= PRESTIGE_BONUS;
+        }
+        kpiChange[player-1] += PRESTIGE_BONUS;
+        holder = player;
+        holderCount = newCount;
+    }
+
+    *newHolder = holder;
+    *newHolderCount = holderCount;
+}
+
+
+// Add a change in KPI to each uni
+static void addKPI(Game g, int kpiChange[]) {
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        g->numKPI[uni] += kpiChange[uni];
+        uni++;
+    }
+}
+
+
+// Each vertex touches three hexes. Going by the way throwDice() looks
+// up the vertices around a hex, vertex 0 of (x, y) touches the hexes
+// (x, y), (x, y+1) and (x-1, y+1), and vertex 1 touches (x, y), 
+// (x, y+1) and (x+1, y). Hexes in the sea have a dice number of -1.
+static void addVertexIncome(Game g, coord v, double income[]) {
+    int hexX[3] = {v.x, v.x, v.x + 1};
+    int hexY[3] = {v.y, v.y + 1, v.y + 1};
+    if (v.vertNum == 0) {
+        hexX[2] = v.x - 1;
+    } else {
+        hexY[2] = v.y;
+    }
+
+    int i = 0;
+    while (i < 3) {
+        if (hexX[i] >= 0 && hexX[i] < GRID_WIDTH 
+                && hexY[i] >= 0 && hexY[i] < GRID_HEIGHT
+                && g->grid[hexX[i]][hexY[i]].diceNum != -1) {
+            hex *h = &g->grid[hexX[i]][hexY[i]];
+            income[h->resType] += diceChance(h->diceNum);
+        }
+        i++;
+    }
+}
+
+
+// 2 and 12 come up 1 time in 36, 7 comes up 6 times in 36
+static double diceChance(int diceScore) {
+    double chance = 0;
+    if (diceScore >= 2 && diceScore <= 12) {
+        int ways = 6 - abs(diceScore - 7);
+        chance = ways / 36.0;
+    }
+    return chance;
+}
+
+
+#ifdef GAME_HARD_CHECKS
+// Print which check failed and where, then abort so the failure can't
+// be missed (or compiled out)
+static void checkFailed(const char *message, const char *function) {
+    fprintf(stderr, "%s: check failed: %s\n", function, message);
+    abort();
+}
+#endif
+
+
+// Go through the grid column by column and give the next ID to every
+// vertex and edge isCoordInside() says is on the island
+static void buildBoardGeometry(void) {
+    int vertices = 0;
+    int edges = 0;
+    int x = 0;
+    while (x < GRID_WIDTH) {
+        int y = 0;
+        while (y < GRID_HEIGHT) {
+            int vertNum = 0;
+            while (vertNum < NUM_VERTICES_PER_HEX) {
+                coord c = {.x = x, .y = y, .arcNum = -1, 
+                    .vertNum = vertNum};
+                board.vertexID[x][y][vertNum] = NO_VERTEX;
+                if (isCoordInside(c)) {
+                    board.vertexID[x][y][vertNum] = vertices;
+                    board.vertexCoord[vertices] = c;
+                    vertices++;
+                }
+                vertNum++;
+            }
+
+            int arcNum = 0;
+            while (arcNum < NUM_ARCS_PER_HEX) {
+                coord c = {.x = x, .y = y, .arcNum = arcNum, 
+                    .vertNum = -1};
+                board.edgeID[x][y][arcNum] = NO_EDGE;
+                if (isCoordInside(c)) {
+                    board.edgeID[x][y][arcNum] = edges;
+                    board.edgeCoord[edges] = c;
+                    edges++;
+                }
+                arcNum++;
+            }
+            y++;
+        }
+        x++;
+    }
+
+    assert(vertices == NUM_VERTICES && edges == NUM_EDGES
+            && "ISLAND IS THE WRONG SHAPE");
+
+    linkBoardGraph();
+    findShortestPaths();
+}
+
+
+// Going by the way the grid lays out each hex's two vertices and the
+// way the path walkers number arcs, vertex 0 of hex (x, y) is joined to
+//   vertex 1 of (x, y)      by arc 1 of (x, y)
+//   vertex 1 of (x-1, y)    by arc 0 of (x, y)
+//   vertex 1 of (x-1, y+1)  by arc 2 of (x-1, y+1)
+// and vertex 1 of hex (x, y) is joined to
+//   vertex 0 of (x, y)      by arc 1 of (x, y)
+//   vertex 0 of (x+1, y)    by arc 0 of (x+1, y)
+//   vertex 0 of (x+1, y-1)  by arc 2 of (x, y)
+// Any of these can be in the sea, which leaves a NO_VERTEX/NO_EDGE.
+// The regions around a vertex are worked out as in addVertexIncome()
+static void linkBoardGraph(void) {
+    boardGraph *graph = &board.graph;
+    memset(graph->neighbourSet, 0, sizeof(graph->neighbourSet));
+    memset(graph->vertexEdgeSet, 0, sizeof(graph->vertexEdgeSet));
+    memset(graph->edgeEndSet, 0, sizeof(graph->edgeEndSet));
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        coord c = board.vertexCoord[v];
+        int *next = graph->vertexNeighbours[v];
+        int *edges = graph->vertexEdges[v];
+        coord hexes[3] = {
+            {.x = c.x, .y = c.y, .arcNum = -1, .vertNum = -1},
+            {.x = c.x, .y = c.y + 1, .arcNum = -1, .vertNum = -1},
+            {.x = c.x + 1, .y = c.y, .arcNum = -1, .vertNum = -1}
+        };
+        if (c.vertNum == 0) {
+            next[0] = vertexIDAt(c.x, c.y, 1);
+            next[1] = vertexIDAt(c.x - 1, c.y, 1);
+            next[2] = vertexIDAt(c.x - 1, c.y + 1, 1);
+            edges[0] = edgeIDAt(c.x, c.y, 1);
+            edges[1] = edgeIDAt(c.x, c.y, 0);
+            edges[2] = edgeIDAt(c.x - 1, c.y + 1, 2);
+            hexes[2].x = c.x - 1;
+            hexes[2].y = c.y + 1;
+        } else {
+            next[0] = vertexIDAt(c.x, c.y, 0);
+            next[1] = vertexIDAt(c.x + 1, c.y, 0);
+            next[2] = vertexIDAt(c.x + 1, c.y - 1, 0);
+            edges[0] = edgeIDAt(c.x, c.y, 1);
+            edges[1] = edgeIDAt(c.x + 1, c.y, 0);
+            edges[2] = edgeIDAt(c.x, c.y, 2);
+        }
+
+        // the vertex at the other end of edges[i] is next[i]
+        int i = 0;
+        while (i < 3) {
+            if (next[i] != NO_VERTEX) {
+                graph->neighbourSet[v] |= VERTEX_BIT(next[i]);
+                int e = edges[i];
+                edgeSetAdd(&graph->vertexEdgeSet[v], e);
+                graph->edgeEndSet[e] |= VERTEX_BIT(v);
+                if (c.vertNum == 0) {
+                    graph->edgeEnds[e][0] = v;
+                } else {
+                    graph->edgeEnds[e][1] = v;
+                }
+            }
+
+            graph->vertexRegions[v][i] = -1;
+            if (isCoordInside(hexes[i])) {
+                graph->vertexRegions[v][i] = coordToRegID(hexes[i]);
+            }
+            i++;
+        }
 
-   return connected;
+        graph->vertexRetrain[v] = -1;
+        v++;
+    }
+
+    int centre = 0;
+    while (centre < NUM_RETRAINING_CENTRES) {
+        const retrainingCentre *rc = &retrainingCentres[centre];
+        graph->vertexRetrain[vertexIDAt(rc->x, rc->y, rc->vertNum)]
+            = rc->discipline;
+        centre++;
+    }
+}
+
+
+// Every step of a path takes us to a vertex along an edge, and where
+// we can go next only depends on that vertex and edge. So searching
+// breadth first over (vertex, edge) states, extending each path by L,
+// R and B, visits every vertex and edge by one of its shortest paths.
+// Steps which leave the island (even ones isPathContained() lets
+// through) are never taken.
+static void findShortestPaths(void) {
+    int vertexFound[NUM_VERTICES] = {FALSE};
+    int edgeFound[NUM_EDGES] = {FALSE};
+    static int stateSeen[NUM_VERTICES][NUM_EDGES];
+    memset(stateSeen, FALSE, sizeof(stateSeen));
+
+    // each vertex can be arrived at along at most 3 edges
+    path queue[NUM_VERTICES * 3 + 1];
+    int head = 0;
+    int tail = 0;
+
+    // the empty path is the first campus of UNI_A with no edge yet
+    strcpy(queue[tail], "");
+    tail++;
+    int start = coordToVertexID(pathToVertex(queue[0]));
+    strcpy(board.vertexPath[start], "");
+    vertexFound[start] = TRUE;
+
+    const char turns[] = "LRB";
+    while (head < tail) {
+        int length = strlen(queue[head]);
+        int i = 0;
+        while (i < 3 && length + 1 < PATH_LIMIT) {
+            path next;
+            strcpy(next, queue[head]);
+            next[length] = turns[i];
+            next[length + 1] = 0;
+
+            int v = NO_VERTEX;
+            int e = NO_EDGE;
+            if (isPathContained(next)) {
+                v = coordToVertexID(pathToVertex(next));
+                e = coordToEdgeID(pathToARC(next));
+            }
+            if (v != NO_VERTEX && e != NO_EDGE && !stateSeen[v][e]) {
+                stateSeen[v][e] = TRUE;
+                strcpy(queue[tail], next);
+                tail++;
+                if (!vertexFound[v]) {
+                    vertexFound[v] = TRUE;
+                    strcpy(board.vertexPath[v], next);
+                }
+                if (!edgeFound[e]) {
+                    edgeFound[e] = TRUE;
+                    strcpy(board.edgePath[e], next);
+                }
+            }
+            i++;
+        }
+        head++;
+    }
+}
+
+
+// The path walkers can finish just off the grid for paths which hug
+// the coast, so the coordinate has to be range checked first
+static int coordToVertexID(coord c) {
+    int id = NO_VERTEX;
+    if (c.x >= 0 && c.x < GRID_WIDTH && c.y >= 0 && c.y < GRID_HEIGHT
+            && c.vertNum >= 0 && c.vertNum < NUM_VERTICES_PER_HEX) {
+        id = board.vertexID[c.x][c.y][c.vertNum];
+    }
+    return id;
+}
+
+
+static int vertexIDAt(int x, int y, int vertNum) {
+    coord c = {.x = x, .y = y, .arcNum = -1, .vertNum = vertNum};
+    return coordToVertexID(c);
+}
+
+
+static int edgeIDAt(int x, int y, int arcNum) {
+    coord c = {.x = x, .y = y, .arcNum = arcNum, .vertNum = -1};
+    return coordToEdgeID(c);
+}
+
+
+static int coordToEdgeID(coord c) {
+    int id = NO_EDGE;
+    if (c.x >= 0 && c.x < GRID_WIDTH && c.y >= 0 && c.y < GRID_HEIGHT
+            && c.arcNum >= 0 && c.arcNum < NUM_ARCS_PER_HEX) {
+        id = board.edgeID[c.x][c.y][c.arcNum];
+    }
+    return id;
+}
+
+
+static int campusAtPath(Game g, path inPath) {
+    coord vertex = pathToVertex(inPath);
+    return g->grid[vertex.x][vertex.y].vertices[vertex.vertNum];
+}
+
+
+static int arcAtPath(Game g, path inPath) {
+    coord arc = pathToARC(inPath);
+    return g->grid[arc.x][arc.y].arcs[arc.arcNum];
+}
+
+
+// Check the characters and length first so isPathContained() never
+// sees a bad character
+static int isLegalPath(const char *p) {
+    int isLegal = TRUE;
+    int i = 0;
+    while (i < PATH_LIMIT && p[i] != 0 && isLegal == TRUE) {
+        if (p[i] != 'L' && p[i] != 'R' && p[i] != 'B') {
+            isLegal = FALSE;
+        }
+        i++;
+    }
+    if (i == PATH_LIMIT) {
+        isLegal = FALSE;
+    }
+    if (isLegal == TRUE) {
+        isLegal = isPathContained((char *)p);
+    }
+    return isLegal;
+}
+
+
+static uint64_t mixHash(uint64_t hash, uint64_t value) {
+    uint64_t z = (hash + MIX_STEP) ^ value;
+    z = (z ^ (z >> 30)) * MIX_MULTIPLIER_1;
+    z = (z ^ (z >> 27)) * MIX_MULTIPLIER_2;
+    return z ^ (z >> 31);
+}
+
+
+// by default, exchange rate is 3. If a player's campus (or GO8) lies
+// on a retraining centre, the exchange rate to retrain a discipline
+// (identical to the type of retraining centre) falls to 2.
+static int exchangeRate(Game g, int player, int disciplineFrom) {
+    int playerCampus = CAMPUS_A + player - UNI_A;
+    int playerGroupOfEight = GO8_A + player - UNI_A;
+
+    int rate = DEFAULT_EXCHANGE_RATE;
+    int i = 0;
+    while (i < NUM_RETRAINING_CENTRES) {
+        const retrainingCentre *centre = &retrainingCentres[i];
+        if (centre->discipline == disciplineFrom) {
+            int owner = g->grid[centre->x][centre->y]
+                .vertices[centre->vertNum];
+            if (owner == playerCampus || owner == playerGroupOfEight) {
+                rate = DISCOUNT_EXCHANGE_RATE;
+            }
+        }
+        i++;
+    }
+
+    return rate;
+}
+
+
+// Does the work of makeAction(). Takes the action by pointer so
+// applyActions() doesn't copy every path
+static void applyAction(Game g, const action *a) {
+    // perform the requested action `a'
+    // update counters as required (e.g. uniWithMostPubs, numIPs, 
+    // numKPI, studentAmounts etc)
+
+    int player = getWhoseTurn(g);
+
+    int playerCampus;
+    int playerGroupOfEight;
+    int playerArc;
+
+    if(player == 1) {
+        playerCampus = CAMPUS_A;
+        playerGroupOfEight = GO8_A;
+        playerArc = ARC_A;
+    } else if (player == 2) {
+        playerCampus = CAMPUS_B;
+        playerGroupOfEight = GO8_B;
+        playerArc = ARC_B;
+    } else {
+        playerCampus = CAMPUS_C;
+        playerGroupOfEight = GO8_C;
+        playerArc = ARC_C;
+    }
+
+    // only walk the path for actions that have one
+    coord locateV;
+    coord locateA;
+    if (a->actionCode == BUILD_CAMPUS || a->actionCode == BUILD_GO8) {
+        locateV = pathToVertex((char *)a->destination);
+    } else if (a->actionCode == OBTAIN_ARC) {
+        locateA = pathToARC((char *)a->destination);
+    }
+
+    if(a->actionCode == BUILD_CAMPUS) {
+        g->grid[locateV.x][locateV.y].vertices[locateV.vertNum]
+            = playerCampus;
+        addCampusToNetwork(g, player, coordToVertexID(locateV));
+        addCampusToFrontiers(g, player, coordToVertexID(locateV));
+        g->numCampuses[player-1]++;
+        payForAction(g, player, BUILD_CAMPUS);
+        g->numKPI[player-1] += CAMPUS_KPI;
+        NOTIFY(g, onCampusBuilt, player, FALSE, a->destination);
+    } else if (a->actionCode == BUILD_GO8) {
+        g->grid[locateV.x][locateV.y].vertices[locateV.vertNum]
+            = playerGroupOfEight;
+        g->numGO8s[player-1]++;
+        g->numCampuses[player-1]--;
+        payForAction(g, player, BUILD_GO8);
+
+        // total increase in KPI is 10 since we lose
+        // one campus (10 KPI) to gain a GO8 (20 KPI)
+        g->numKPI[player-1] -= CAMPUS_KPI;
+        g->numKPI[player-1] += GO8_KPI;
+        NOTIFY(g, onCampusBuilt, player, TRUE, a->destination);
+    } else if (a->actionCode == OBTAIN_ARC) {
+        g->grid[locateA.x][locateA.y].arcs[locateA.arcNum]
+            = playerArc;
+        addARCToNetwork(g, player, coordToEdgeID(locateA));
+        addARCToFrontiers(g, player, coordToEdgeID(locateA));
+        g->numARCs[player-1]++;
+        payForAction(g, player, OBTAIN_ARC);
+        g->numKPI[player-1] += ARC_KPI;
+        NOTIFY(g, onARCBuilt, player, a->destination);
+
+        // checks for prestige bonus regarding having most ARC grants
+        int kpiChange[NUM_UNIS] = {0};
+        int oldHolder = g->uniWithMostARCs;
+        awardPrestige(g->uniWithMostARCs, g->uniWithMostARCs_number,
+                player, g->numARCs[player-1], kpiChange,
+                &g->uniWithMostARCs, &g->uniWithMostARCs_number);
+        addKPI(g, kpiChange);
+        if (g->uniWithMostARCs != oldHolder) {
+            NOTIFY(g, onPrestigeTransfer, MOST_ARCS_AWARD, oldHolder,
+                    g->uniWithMostARCs);
+        }
+    } else if (a->actionCode == OBTAIN_PUBLICATION) {
+        payForAction(g, player, OBTAIN_PUBLICATION);
+        g->numPubs[player-1]++;
+
+        // checks for prestige bonus regarding having most publications
+        int kpiChange[NUM_UNIS] = {0};
+        int oldHolder = g->uniWithMostPubs;
+        awardPublicationPrestige(g->uniWithMostPubs, g->uniWithMostPubs_number,
+                player, g->numPubs[player-1], kpiChange,
+                &g->uniWithMostPubs, &g->uniWithMostPubs_number);
+        addKPI(g, kpiChange);
+        if (g->uniWithMostPubs != oldHolder) {
+            NOTIFY(g, onPrestigeTransfer, MOST_PUBS_AWARD, oldHolder,
+                    g->uniWithMostPubs);
+        }
+    } else if (a->actionCode == OBTAIN_IP_PATENT) {
+        payForAction(g, player, OBTAIN_IP_PATENT);
+        g->numIPs[player-1]++;
+        g->numKPI[player-1] += IP_KPI;
+    } else if (a->actionCode == RETRAIN_STUDENTS) {
+        int rate = exchangeRate(g, player, a->disciplineFrom);
+        g->studentAmounts[player-1][a->disciplineFrom] -= rate;
+        g->studentAmounts[player-1][a->disciplineTo]++;
+    } 
+
+}
+
+
+// The caller has already rolled the spinoff, so check the outcome
+// the way the spinoff itself would have been checked
+static int checkBatchAction(Game g, const action *a) {
+    int reason;
+    if (a->actionCode == OBTAIN_PUBLICATION 
+            || a->actionCode == OBTAIN_IP_PATENT) {
+        action spinoff = {.actionCode = START_SPINOFF};
+        reason = checkAction(g, &spinoff);
+    } else if (a->actionCode == START_SPINOFF) {
+        // makeAction() can't make one, it has to be resolved first
+        reason = ILLEGAL_ACTION_CODE;
+    } else {
+        reason = checkAction(g, a);
+    }
+    return reason;
 }
 
 
@@ -621,6 +1394,7 @@ static int isCampusConnected(path inPath, Game g, int player){
 // as the hex types as given by the discipline[] and dice[] arrays, and
 // return a Game variable holding a pointer to it
 Game newGame (int discipline[], int dice[]) {
+    pthread_once(&boardBuilt, buildBoardGeometry);
     Game g = malloc(sizeof(game));
 
     // turn number starts at -1
@@ -692,6 +1466,9 @@ Game newGame (int discipline[], int dice[]) {
     g->uniWithMostPubs = NO_ONE;
     g->uniWithMostPubs_number = NO_ONE;
 
+    // nobody is watching yet
+    g->observer = NULL;
+
     // create the campuses
     g->grid[3][0].vertices[1] = CAMPUS_A;
     g->grid[3][5].vertices[0] = CAMPUS_A;
@@ -700,19 +1477,43 @@ Game newGame (int discipline[], int dice[]) {
     g->grid[0][5].vertices[1] = CAMPUS_B;
     g->grid[6][0].vertices[0] = CAMPUS_B;
 
-    // create the retrainers
-    g->grid[2][5].retrainCenters[0] = STUDENT_MTV;
-    g->grid[2][5].retrainCenters[1] = STUDENT_MTV;
-    g->grid[4][4].retrainCenters[0] = STUDENT_MMONEY;
-    g->grid[4][4].retrainCenters[1] = STUDENT_MMONEY;
-    g->grid[6][1].retrainCenters[0] = STUDENT_BQN;
-    g->grid[5][1].retrainCenters[1] = STUDENT_BQN;
-    g->grid[5][0].retrainCenters[0] = STUDENT_MJ;
-    g->grid[4][0].retrainCenters[1] = STUDENT_MJ;
-    g->grid[1][2].retrainCenters[1] = STUDENT_BPS;
-    g->grid[2][1].retrainCenters[0] = STUDENT_BPS;
-
-    return g;
+    // every vertex starts as its own piece, then the campuses go into
+    // their networks and frontiers
+    g->campusBlocked = 0;
+    memset(&g->arcsTaken, 0, sizeof(edgeSet));
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        g->network[uni] = 0;
+        g->arcEnds[uni] = 0;
+        g->campusFrontier[uni] = 0;
+        memset(&g->arcFrontier[uni], 0, sizeof(edgeSet));
+        int vertex = 0;
+        while (vertex < NUM_VERTICES) {
+            g->networkParent[uni][vertex] = vertex;
+            g->networkSize[uni][vertex] = 1;
+            vertex++;
+        }
+        uni++;
+    }
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        int contents = getCampusAt(g, vertex);
+        if (contents != VACANT_VERTEX) {
+            addCampusToNetwork(g, contents, vertex);
+            addCampusToFrontiers(g, contents, vertex);
+        }
+        vertex++;
+    }
+
+    // create the retrainers
+    int centre = 0;
+    while (centre < NUM_RETRAINING_CENTRES) {
+        const retrainingCentre *c = &retrainingCentres[centre];
+        g->grid[c->x][c->y].retrainCenters[c->vertNum] = c->discipline;
+        centre++;
+    }
+
+    return g;
 }
 
 
@@ -727,104 +1528,7 @@ void disposeGame (Game g) {
 // The function may assume that the action requested is legal.
 // START_SPINOFF is not a legal action here
 void makeAction (Game g, action a) {
-    // perform the requested action `a'
-    // update counters as required (e.g. uniWithMostPubs, numIPs, 
-    // numKPI, studentAmounts etc)
-
-    int player = getWhoseTurn(g);
-
-    int playerCampus;
-    int playerGroupOfEight;
-    int playerArc;
-
-    if(player == 1) {
-        playerCampus = CAMPUS_A;
-        playerGroupOfEight = GO8_A;
-        playerArc = ARC_A;
-    } else if (player == 2) {
-        playerCampus = CAMPUS_B;
-        playerGroupOfEight = GO8_B;
-        playerArc = ARC_B;
-    } else {
-        playerCampus = CAMPUS_C;
-        playerGroupOfEight = GO8_C;
-        playerArc = ARC_C;
-    }
-
-    coord locateV = pathToVertex(a.destination);
-    coord locateA = pathToARC(a.destination);
-
-    if(a.actionCode == BUILD_CAMPUS) {
-        g->grid[locateV.x][locateV.y].vertices[locateV.vertNum]
-            = playerCampus;
-        g->numCampuses[player-1]++;
-        g->studentAmounts[player-1][STUDENT_BPS]--;
-        g->studentAmounts[player-1][STUDENT_BQN]--;
-        g->studentAmounts[player-1][STUDENT_MJ]--;
-        g->studentAmounts[player-1][STUDENT_MTV]--;
-        g->numKPI[player-1] += CAMPUS_KPI;
-    } else if (a.actionCode == BUILD_GO8) {
-        g->grid[locateV.x][locateV.y].vertices[locateV.vertNum]
-            = playerGroupOfEight;
-        g->numGO8s[player-1]++;
-        g->numCampuses[player-1]--;
-        g->studentAmounts[player-1][STUDENT_MJ] -= 2;
-        g->studentAmounts[player-1][STUDENT_MMONEY] -= 3;
-
-        // total increase in KPI is 10 since we lose
-        // one campus (10 KPI) to gain a GO8 (20 KPI)
-        g->numKPI[player-1] -= CAMPUS_KPI;
-        g->numKPI[player-1] += GO8_KPI;
-    } else if (a.actionCode == OBTAIN_ARC) {
-        g->grid[locateA.x][locateA.y].arcs[locateA.arcNum]
-            = playerArc;
-        g->numARCs[player-1]++;
-        g->studentAmounts[player-1][STUDENT_BPS]--;
-        g->studentAmounts[player-1][STUDENT_BQN]--;
-        g->numKPI[player-1] += ARC_KPI;
-
-        // checks for prestige bonus regarding having most ARC grants
-        if (g->uniWithMostARCs == player) {
-            g->uniWithMostARCs_number++;
-        }
-        if(g->numARCs[player-1] > g->uniWithMostARCs_number) {
-            if(getMostARCs(g) != NO_ONE &&
-               getMostARCs(g) != player){
-                g->numKPI[getMostARCs(g)-1] -= PRESTIGE_BONUS;
-            }
-            g->numKPI[player-1] += PRESTIGE_BONUS;
-            g->uniWithMostARCs_number = g->numARCs[player-1];
-            g->uniWithMostARCs = player;
-        }
-    } else if (a.actionCode == OBTAIN_PUBLICATION) {
-        g->studentAmounts[player-1][STUDENT_MJ]--;
-        g->studentAmounts[player-1][STUDENT_MTV]--;
-        g->studentAmounts[player-1][STUDENT_MMONEY]--;
-        g->numPubs[player-1]++;
-
-        // checks for prestige bonus regarding having most publications
-        if(g->numPubs[player-1] > g->uniWithMostPubs_number) {
-            if(getMostPublications(g) != NO_ONE &&
-               getMostPublications(g) != player) {
-                g->numKPI[getMostPublications(g)-1] -= PRESTIGE_BONUS;
-            }
-            g->numKPI[player-1] += PRESTIGE_BONUS;
-            g->uniWithMostPubs_number = g->numPubs[player-1];
-            g->uniWithMostPubs = player;
-        }
-    } else if (a.actionCode == OBTAIN_IP_PATENT) {
-        g->studentAmounts[player-1][STUDENT_MJ]--;
-        g->studentAmounts[player-1][STUDENT_MTV]--;
-        g->studentAmounts[player-1][STUDENT_MMONEY]--;
-        g->numIPs[player-1]++;
-        g->numKPI[player-1] += IP_KPI;
-    } else if (a.actionCode == RETRAIN_STUDENTS) {
-        int exchangeRate = getExchangeRate(g, player,
-            a.disciplineFrom, a.disciplineTo);
-        g->studentAmounts[player-1][a.disciplineFrom] -= exchangeRate;
-        g->studentAmounts[player-1][a.disciplineTo]++;
-    } 
-
+    applyAction(g, &a);
 }
 
 
@@ -833,7 +1537,7 @@ void makeAction (Game g, action a) {
 // the game starts in turn -1 (we call this state "Terra Nullis") and 
 // moves to turn 0 as soon as the first dice is thrown. 
 void throwDice (Game g, int diceScore) {
-   assert(diceScore >= 2 && diceScore <= 12 && "INVALID DICE NUM");
+   CHECK(diceScore >= 2 && diceScore <= 12, "INVALID DICE NUM");
 
    g->turnNumber++;
    int X = 0;
@@ -841,6 +1545,15 @@ void throwDice (Game g, int diceScore) {
    int pCount = 0;
    int add = 0;
 
+#ifndef NO_GAME_EVENTS
+   // if someone is watching remember the students from before the 
+   // roll so we can tell them what each uni was given
+   int before[NUM_UNIS][NUM_DISCIPLINES];
+   if (g->observer != NULL) {
+      memcpy(before, g->studentAmounts, sizeof(before));
+   }
+#endif
+
    // Check the entire board for the hex with the equivalent diceScore
    while (Y < GRID_HEIGHT){
       X = 0;
@@ -898,14 +1611,33 @@ void throwDice (Game g, int diceScore) {
       Y++;
    }//endwhile
 
+#ifndef NO_GAME_EVENTS
+   if (g->observer != NULL) {
+      int produced[NUM_UNIS][NUM_DISCIPLINES];
+      pCount = 0;
+      while (pCount < NUM_UNIS) {
+         int discipline = 0;
+         while (discipline < NUM_DISCIPLINES) {
+            produced[pCount][discipline] = 
+               g->studentAmounts[pCount][discipline]
+                  - before[pCount][discipline];
+            discipline++;
+         }
+         pCount++;
+      }
+      NOTIFY(g, onStudentsProduced, diceScore, produced);
+   }
+#endif
+
    if (diceScore == 7) {
       int player = 0;
       while (player < NUM_UNIS) {
-         g->studentAmounts[player][STUDENT_THD] += 
-            g->studentAmounts[player][STUDENT_MTV]
-               + g->studentAmounts[player][STUDENT_MMONEY];
+         int mtv = g->studentAmounts[player][STUDENT_MTV];
+         int mmoney = g->studentAmounts[player][STUDENT_MMONEY];
+         g->studentAmounts[player][STUDENT_THD] += mtv + mmoney;
          g->studentAmounts[player][STUDENT_MTV] = 0;
          g->studentAmounts[player][STUDENT_MMONEY] = 0;
+         NOTIFY(g, onSevenConversion, player + 1, mtv, mmoney);
          player++;
      }
    }
@@ -916,8 +1648,8 @@ void throwDice (Game g, int diceScore) {
 // regionID is the index of the region in the newGame arrays (above) 
 // see discipline codes above
 int getDiscipline (Game g, int regionID) {
-    assert(regionID >= 0 && regionID < NUM_REGIONS 
-            && "INVALID REGION ID");
+    CHECK(regionID >= 0 && regionID < NUM_REGIONS, 
+            "INVALID REGION ID");
     coord c = regIDToCoord(regionID);
     return g->grid[c.x][c.y].resType;
 }
@@ -926,8 +1658,8 @@ int getDiscipline (Game g, int regionID) {
 // what dice value produces students in the specified region?
 // 2..12
 int getDiceValue (Game g, int regionID) {
-    assert(regionID >= 0 && regionID < NUM_REGIONS 
-            && "INVALID REGION ID");
+    CHECK(regionID >= 0 && regionID < NUM_REGIONS, 
+            "INVALID REGION ID");
     coord c = regIDToCoord(regionID);
     return g->grid[c.x][c.y].diceNum;
 }
@@ -968,23 +1700,20 @@ int getWhoseTurn (Game g) {
 
 
 // return the contents of the given vertex (ie campus code or 
-// VACANT_VERTEX)
+// VACANT_VERTEX). A path can hug the coast past isPathContained() and
+// still end in the sea, so it must also lead to a vertex
 int getCampus(Game g, path inPath) {
-    assert(isPathContained(inPath) == TRUE && "INVALID PATH");
-
-    //get the 2d coord of the path
-    coord vertex = pathToVertex(inPath);
-    return g->grid[vertex.x][vertex.y].vertices[vertex.vertNum];
+    CHECK(isPathContained(inPath) == TRUE, "INVALID PATH");
+    CHECK(vertexOfPath(inPath) != NO_VERTEX, "PATH ENDS IN THE SEA");
+    return campusAtPath(g, inPath);
 }
 
 
 // return the contents of the given edge (ie ARC code or vacant ARC)
 int getARC(Game g, path pathToEdge) {
-    assert(isPathContained(pathToEdge) == TRUE && "INVALID PATH");
-
-    //get the 2d coord of the path
-    coord arc = pathToARC(pathToEdge);
-    return g->grid[arc.x][arc.y].arcs[arc.arcNum];
+    CHECK(isPathContained(pathToEdge) == TRUE, "INVALID PATH");
+    CHECK(edgeOfPath(pathToEdge) != NO_EDGE, "PATH ENDS IN THE SEA");
+    return arcAtPath(g, pathToEdge);
 }
 
 
@@ -994,166 +1723,15 @@ int getARC(Game g, path pathToEdge) {
 // or OBTAIN_IP_PATENT (they can make the move START_SPINOFF)
 // you can assume that any paths passed in are NULL terminated strings.
 int isLegalAction (Game g, action a) {
-    // assume the action is legal, then go through a series of tests,
-    // changing it to FALSE if it fails a test.
-    int isLegal = TRUE;
-    
-    // example: players cannot outright ask to obtain ip/publication
-    if (a.actionCode == OBTAIN_PUBLICATION 
-            || a.actionCode == OBTAIN_IP_PATENT) {
-        isLegal = FALSE;
-    }
-
-    // check the action code is legal
-    if (a.actionCode < 0 || a.actionCode > 7){
-        isLegal= FALSE;
-    }
-
-
-    // run a check on each character in the path to ensure it is valid
-    int i = 0;
-    int isValidPath = TRUE;
-    if (a.actionCode == OBTAIN_ARC || a.actionCode == BUILD_CAMPUS
-            || a.actionCode == BUILD_GO8) {
-        while (i < strlen(a.destination)) {
-            if (a.destination[i] != 'R' && a.destination[i] != 'L'
-                    && a.destination[i] != 'B') {
-                isValidPath = FALSE;
-                isLegal = FALSE;
-            }
-            i++;
-        }
-    }
-
-    // it is illegal to make any action during terra nullis
-    if (getTurnNumber(g) == -1) {
-        isLegal = FALSE;
-    }
-    
-    // check that conditions are satisfied for building a campus
-    if (a.actionCode == BUILD_CAMPUS && getTurnNumber(g) != -1) {
-        int resourceA = getStudents(g, getWhoseTurn(g), STUDENT_BPS);
-        int resourceB = getStudents(g, getWhoseTurn(g), STUDENT_BQN);
-        int resourceC = getStudents(g, getWhoseTurn(g), STUDENT_MJ);
-        int resourceD = getStudents(g, getWhoseTurn(g), STUDENT_MTV);
-
-        //check for enough students
-        if (resourceA<1 || resourceB<1 || resourceC<1 || resourceD<1) {
-            isLegal = FALSE;
-        }
-
-        if (isValidPath) {
-            if (isPathContained(a.destination) == FALSE) {
-                isLegal = FALSE;
-            } else {
-                //check if the vertex is vacant and there is an arc
-                if (getCampus(g,a.destination) != VACANT_VERTEX) {
-                    isLegal = FALSE;
-                }
-
-                // check the campus is connected to player's ARCs
-                if (isCampusConnected(a.destination, g, getWhoseTurn(g)) 
-                        == FALSE) {
-                    isLegal = FALSE;
-                }
-
-                // check there is separation between campuses
-                if (isCampusTooClose(g, a.destination) == TRUE) {
-                    isLegal = FALSE;
-                }
-            }
-        }
-    }
-
-    // check that conditions are satisfied for building a GO8
-    if (a.actionCode == BUILD_GO8 && getTurnNumber(g) != -1) {
-        int resourceA = getStudents(g, getWhoseTurn(g), STUDENT_MJ);
-        int resourceB = getStudents(g, getWhoseTurn(g), STUDENT_MMONEY);
-
-        // check for enough students 
-        if (resourceA<2 || resourceB<3) {
-            isLegal = FALSE;
-        }
-
-        if (isValidPath) {
-            if (isPathContained(a.destination) == FALSE) {
-                isLegal = FALSE;
-            } else {
-                if (getCampus(g, a.destination) != getWhoseTurn(g)) {
-                    isLegal = FALSE;
-                }
-            }
-        }
-    }
-
-    // check that conditions are satisfied for building an ARC
-    if (a.actionCode == OBTAIN_ARC && getTurnNumber(g) != -1) {
-        int resourceA = getStudents(g, getWhoseTurn(g), STUDENT_BPS);
-        int resourceB = getStudents(g, getWhoseTurn(g), STUDENT_BQN);
-
-        // check for enough students
-        if (resourceA<1 || resourceB<1) {
-            isLegal = FALSE;
-        }
-
-        if (strlen(a.destination) == 0) {
-            isLegal = FALSE;
-        }
-
-        if (isValidPath) {
-            if (isPathContained(a.destination) == FALSE) {
-                isLegal = FALSE;
-            } else {
-                if (getARC(g,a.destination) != VACANT_ARC) {
-                    isLegal = FALSE;
-                }
-                if (isARCConnected(a.destination, g, 
-                            getWhoseTurn(g)) == FALSE) {
-                    isLegal = FALSE;
-                }
-            }
-        }
-    }
-    
-    
-    // check there are enough students to start a spinoff
-    if (a.actionCode == START_SPINOFF && getTurnNumber(g) != -1) {
-        int resourceA = getStudents(g, getWhoseTurn(g), STUDENT_MJ);
-        int resourceB = getStudents(g, getWhoseTurn(g), STUDENT_MTV);
-        int resourceC = getStudents(g, getWhoseTurn(g), STUDENT_MMONEY);
-        if (resourceA < 1 || resourceB < 1 || resourceC < 1) {
-            isLegal = FALSE;
-        }
-    }
-    
-
-    // check there are enough students to retrain
-    if (a.actionCode == RETRAIN_STUDENTS && getTurnNumber(g) != -1) {
-        int resourceA = getStudents(g, getWhoseTurn(g), a.disciplineFrom);
-        int resourceB = getStudents(g, getWhoseTurn(g), a.disciplineTo);
-        
-        // check if the user entered a valid student type
-        if ((resourceA > 5 && resourceA < 1) 
-                || (resourceB > 5 && resourceB < 0)) {
-            isLegal = FALSE;
-        }
-        
-        // check for enough of the from student to retrain
-        if (getStudents(g, getWhoseTurn(g), a.disciplineFrom)
-                < getExchangeRate(g, getWhoseTurn(g), a.disciplineFrom,
-                    a.disciplineTo)) {
-            isLegal = FALSE;
-        }
-    }
-    
-    return isLegal;
+    // all the work is done by checkAction, which also says *why* an
+    // action isn't legal for callers who care
+    return checkAction(g, &a) == LEGAL_ACTION;
 }
 
 
 // return the number of KPI points the specified player has
 int getKPIpoints (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numKPI[player-1];
@@ -1162,8 +1740,7 @@ int getKPIpoints (Game g, int player) {
 
 // return the number of ARC grants the specified player has
 int getARCs (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numARCs[player-1];
@@ -1172,8 +1749,7 @@ int getARCs (Game g, int player) {
 
 // return the number of GO8 campuses the specified player has
 int getGO8s (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numGO8s[player-1];
@@ -1182,8 +1758,7 @@ int getGO8s (Game g, int player) {
 
 // return the number of normal Campuses the specified player has
 int getCampuses (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numCampuses[player-1];
@@ -1192,8 +1767,7 @@ int getCampuses (Game g, int player) {
 
 // return the number of IP Patents the specified player has
 int getIPs (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numIPs[player-1];
@@ -1202,8 +1776,7 @@ int getIPs (Game g, int player) {
 
 // return the number of Publications the specified player has
 int getPublications (Game g, int player) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     return g->numPubs[player-1];
@@ -1213,14 +1786,8 @@ int getPublications (Game g, int player) {
 // return the number of students of the specified discipline type 
 // the specified player has
 int getStudents (Game g, int player, int discipline) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
-    assert(((discipline == STUDENT_THD) ||
-           (discipline == STUDENT_BPS)  ||
-           (discipline == STUDENT_BQN)  ||
-           (discipline == STUDENT_MJ )  ||
-           (discipline == STUDENT_MTV)  ||
-           (discipline == STUDENT_MMONEY)) && "INVALID STUDENT");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    CHECK(IS_DISCIPLINE(discipline), "INVALID STUDENT");
 
     // player-1 so that we can use the player number 1..3 as index 0..2
     // use the discipline 0..5 as the index
@@ -1234,126 +1801,732 @@ int getStudents (Game g, int player, int discipline) {
 // on what retraining centers, if any, they have a campus at.
 int getExchangeRate (Game g, int player, 
                      int disciplineFrom, int disciplineTo) {
-    assert((player == UNI_A || player == UNI_B || player == UNI_C)
-            && "INVALID PLAYER");
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
 
     // checks that the discipline that
     // wants to be retrained is not a THD
-    assert(disciplineFrom != STUDENT_THD && "CAN'T RETRAIN THD");
+    CHECK(IS_DISCIPLINE(disciplineFrom) 
+            && disciplineFrom != STUDENT_THD, "CAN'T RETRAIN THD");
 
     // checks that the discipline that
     // wants to be trained into is valid
-    assert(((disciplineTo == STUDENT_THD) ||
-           (disciplineTo == STUDENT_BPS)  ||
-           (disciplineTo == STUDENT_BQN)  ||
-           (disciplineTo == STUDENT_MJ )  ||
-           (disciplineTo == STUDENT_MTV)  ||
-           (disciplineTo == STUDENT_MMONEY)) && "INVALID STUDENT");
+    CHECK(IS_DISCIPLINE(disciplineTo), "INVALID STUDENT");
 
-    int playerCampus;
-    int playerGroupOfEight;
+    return exchangeRate(g, player, disciplineFrom);
+}
 
-    if (player == UNI_A) {
-        playerCampus = CAMPUS_A;
-        playerGroupOfEight = GO8_A;
-    } else if (player == UNI_B) {
-        playerCampus = CAMPUS_B;
-        playerGroupOfEight = GO8_B;
+
+// =====================================================================
+//   API FUNCTIONS END
+//   ENGINE EXTENSION FUNCTIONS BEGIN (see GameEngine.h)
+// =====================================================================
+
+// returns a bitmask with bit (1 << actionCode) set for every fixed
+// cost action the player has enough students to pay for.
+// The player's six disciplines are packed into 8 lanes (the last two
+// are 0 like the padding in actionCosts) and every row of the cost
+// table is checked with one vector compare: a row is affordable when
+// no lane of the cost is greater than what the player has.
+int getAffordableActions (Game g, int player) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+
+    int mask = 0;
+    int actionCode = 0;
+
+#ifdef __SSE2__
+    // pack the students down to 16 bit lanes, saturating so a huge
+    // number of students still compares as "enough"
+    int *students = g->studentAmounts[player-1];
+    __m128i low = _mm_setr_epi32(students[0], students[1], 
+            students[2], students[3]);
+    __m128i high = _mm_setr_epi32(students[4], students[5], 0, 0);
+    __m128i have = _mm_packs_epi32(low, high);
+
+    while (actionCode < NUM_ACTION_CODES) {
+        __m128i cost = _mm_loadu_si128(
+                (const __m128i *)actionCosts[actionCode]);
+        __m128i tooFew = _mm_cmpgt_epi16(cost, have);
+        if (_mm_movemask_epi8(tooFew) == 0) {
+            mask |= 1 << actionCode;
+        }
+        actionCode++;
+    }
+#else
+    // no vector unit, compare lane by lane
+    while (actionCode < NUM_ACTION_CODES) {
+        int tooFew = 0;
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            tooFew |= actionCosts[actionCode][discipline] 
+                > g->studentAmounts[player-1][discipline];
+            discipline++;
+        }
+        if (tooFew == 0) {
+            mask |= 1 << actionCode;
+        }
+        actionCode++;
+    }
+#endif
+
+    return mask & FIXED_COST_ACTIONS;
+}
+
+
+// works out whether the current player may make the action, running
+// the checks cheapest first and stopping at the first one that fails.
+// returns LEGAL_ACTION or the ILLEGAL_ reason code (see GameEngine.h)
+int checkAction (Game g, const action *a) {
+    int reason = LEGAL_ACTION;
+    int code = a->actionCode;
+
+    // stage 1: things that don't depend on the board at all
+    // players cannot outright ask to obtain ip/publication
+    if (code < 0 || code >= NUM_ACTION_CODES
+            || code == OBTAIN_PUBLICATION || code == OBTAIN_IP_PATENT) {
+        reason = ILLEGAL_ACTION_CODE;
+    } else if (g->turnNumber == -1) {
+        reason = ILLEGAL_TERRA_NULLIS;
+    }
+
+    int player = NO_ONE;
+    if (reason == LEGAL_ACTION) {
+        player = getWhoseTurn(g);
+    }
+
+    // stage 2: can the player pay for it
+    if (reason == LEGAL_ACTION && code == RETRAIN_STUDENTS) {
+        int from = a->disciplineFrom;
+        int to = a->disciplineTo;
+        if (from <= STUDENT_THD || from > STUDENT_MMONEY
+                || to < STUDENT_THD || to > STUDENT_MMONEY) {
+            reason = ILLEGAL_DISCIPLINE;
+        } else if (g->studentAmounts[player-1][from]
+                < exchangeRate(g, player, from)) {
+            reason = ILLEGAL_UNAFFORDABLE;
+        }
+    } else if (reason == LEGAL_ACTION) {
+        if ((getAffordableActions(g, player) & (1 << code)) == 0) {
+            reason = ILLEGAL_UNAFFORDABLE;
+        }
+    }
+
+    int needsPath = (code == BUILD_CAMPUS || code == BUILD_GO8 
+            || code == OBTAIN_ARC);
+
+    // stage 3: is the path well formed and on the island. Some paths
+    // which hug the coast get past isPathContained() but finish in the
+    // sea, so the end of the path must also have a vertex/edge ID
+    int vertex = NO_VERTEX;
+    int edge = NO_EDGE;
+    if (reason == LEGAL_ACTION && needsPath) {
+        if (isLegalPath(a->destination) == FALSE) {
+            reason = ILLEGAL_PATH;
+        } else if (code == OBTAIN_ARC) {
+            // an ARC needs at least one step to say which edge it is on
+            if (a->destination[0] != 0) {
+                edge = coordToEdgeID(pathToARC((char *)a->destination));
+            }
+            if (edge == NO_EDGE) {
+                reason = ILLEGAL_PATH;
+            }
+        } else {
+            vertex = coordToVertexID(pathToVertex((char *)a->destination));
+            if (vertex == NO_VERTEX) {
+                reason = ILLEGAL_PATH;
+            }
+        }
+    }
+
+    // stage 4: is the destination available
+    if (reason == LEGAL_ACTION && needsPath) {
+        if (code == BUILD_CAMPUS) {
+            if (getCampusAt(g, vertex) != VACANT_VERTEX) {
+                reason = ILLEGAL_OCCUPIED;
+            } else if (g->campusBlocked & VERTEX_BIT(vertex)) {
+                reason = ILLEGAL_TOO_CLOSE;
+            } else if (isCampusConnected(g, vertex, player) == FALSE) {
+                reason = ILLEGAL_NOT_CONNECTED;
+            }
+        } else if (code == BUILD_GO8) {
+            // campus codes line up with player ids
+            if (getCampusAt(g, vertex) != player) {
+                reason = ILLEGAL_OCCUPIED;
+            }
+        } else {
+            if (getARCAt(g, edge) != VACANT_ARC) {
+                reason = ILLEGAL_OCCUPIED;
+            } else if (isARCConnected(g, edge, player) == FALSE) {
+                reason = ILLEGAL_NOT_CONNECTED;
+            }
+        }
+    }
+
+    return reason;
+}
+
+
+// reports what the action would change for the current player without
+// changing the game. Works on the same rules as makeAction() so the
+// two always agree (a START_SPINOFF gives the average of the two ways
+// it can turn out)
+void previewAction (Game g, const action *a, actionDelta *delta) {
+    int player = getWhoseTurn(g);
+    assert(player != NO_ONE && "NO ACTIONS IN TERRA NULLIS");
+    int code = a->actionCode;
+
+    memset(delta, 0, sizeof(actionDelta));
+
+    // the students it costs
+    if (code == RETRAIN_STUDENTS) {
+        delta->students[a->disciplineFrom] -= exchangeRate(g, player,
+                a->disciplineFrom);
+        delta->students[a->disciplineTo]++;
     } else {
-        playerCampus = CAMPUS_C;
-        playerGroupOfEight = GO8_C;
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            delta->students[discipline] -= actionCosts[code][discipline];
+            discipline++;
+        }
     }
-    // by default, exchange rate is 3. If a player's campus lies
-    // on a retraining centre, the exchange rate to retrain a
-    // discipline (identical to the type of retraining centre)
-    // falls to 2.
-    int exchangeRate = DEFAULT_EXCHANGE_RATE;
-    int x = 0;
-    int y = 0;
-    int z = 0;
-
-    while(y < GRID_HEIGHT) {
-        while(x < GRID_WIDTH) {
-            while(z < NUM_VERTICES_PER_HEX){
-                if(disciplineFrom == STUDENT_MTV) {
-                    if(playerCampus == 
-                       g->grid[2][5].vertices[0] ||
-                       playerCampus ==
-                       g->grid[2][5].vertices[1] ||
-                       playerGroupOfEight ==
-                       g->grid[2][5].vertices[0] ||
-                       playerGroupOfEight ==
-                       g->grid[2][5].vertices[1]) {
-                        exchangeRate = DISCOUNT_EXCHANGE_RATE;
-                        x = GRID_WIDTH;
-                        y = GRID_HEIGHT;
-                        z = NUM_VERTICES_PER_HEX;                        
-                    }
-                } else if(disciplineFrom == STUDENT_MMONEY) {
-                    if(playerCampus ==
-                       g->grid[4][4].vertices[0] ||
-                       playerCampus ==
-                       g->grid[4][4].vertices[1] ||
-                       playerGroupOfEight ==
-                       g->grid[4][4].vertices[0] ||
-                       playerGroupOfEight ==
-                       g->grid[4][4].vertices[1]) {
-                        exchangeRate = DISCOUNT_EXCHANGE_RATE;
-                        x = GRID_WIDTH;
-                        y = GRID_HEIGHT;
-                        z = NUM_VERTICES_PER_HEX; 
-                    }
-                } else if(disciplineFrom == STUDENT_BQN) {
-                    if(playerCampus ==
-                       g->grid[6][1].vertices[0] ||
-                       playerCampus ==
-                       g->grid[5][1].vertices[1] ||
-                       playerGroupOfEight ==
-                       g->grid[6][1].vertices[0] ||
-                       playerGroupOfEight ==
-                       g->grid[5][1].vertices[1]) {
-                        exchangeRate = DISCOUNT_EXCHANGE_RATE;
-                        x = GRID_WIDTH;
-                        y = GRID_HEIGHT;
-                        z = NUM_VERTICES_PER_HEX; 
-                    }
-                } else if(disciplineFrom == STUDENT_MJ) {
-                    if(playerCampus ==
-                       g->grid[5][0].vertices[0] ||
-                       playerCampus ==
-                       g->grid[4][0].vertices[1] ||
-                       playerGroupOfEight ==
-                       g->grid[5][0].vertices[0] ||
-                       playerGroupOfEight ==
-                       g->grid[4][0].vertices[1]) {
-                        exchangeRate = DISCOUNT_EXCHANGE_RATE;
-                        x = GRID_WIDTH;
-                        y = GRID_HEIGHT;
-                        z = NUM_VERTICES_PER_HEX; 
-                    }
-                } else if(disciplineFrom == STUDENT_BPS) {
-                    if(playerCampus ==
-                       g->grid[1][2].vertices[1] ||
-                       playerCampus ==
-                       g->grid[2][1].vertices[0] ||
-                       playerGroupOfEight ==
-                       g->grid[1][2].vertices[1] ||
-                       playerGroupOfEight ==
-                       g->grid[2][1].vertices[0]) {
-                        exchangeRate = DISCOUNT_EXCHANGE_RATE;
-                        x = GRID_WIDTH;
-                        y = GRID_HEIGHT;
-                        z = NUM_VERTICES_PER_HEX; 
-                    }
+
+    // the KPI and income it brings in
+    if (code == BUILD_CAMPUS) {
+        delta->kpi[player-1] += CAMPUS_KPI;
+        addVertexIncome(g, pathToVertex((char *)a->destination), 
+                delta->income);
+    } else if (code == BUILD_GO8) {
+        // a GO8 produces two students where the campus produced one
+        delta->kpi[player-1] += GO8_KPI - CAMPUS_KPI;
+        addVertexIncome(g, pathToVertex((char *)a->destination), 
+                delta->income);
+    } else if (code == OBTAIN_ARC) {
+        int kpiChange[NUM_UNIS] = {0};
+        int holder;
+        int holderCount;
+        kpiChange[player-1] += ARC_KPI;
+        awardPrestige(g->uniWithMostARCs, g->uniWithMostARCs_number,
+                player, g->numARCs[player-1] + 1, kpiChange,
+                &holder, &holderCount);
+        int uni = 0;
+        while (uni < NUM_UNIS) {
+            delta->kpi[uni] += kpiChange[uni];
+            uni++;
+        }
+    } else if (code == OBTAIN_PUBLICATION || code == OBTAIN_IP_PATENT
+            || code == START_SPINOFF) {
+        // how much each outcome counts towards the result
+        double ipWeight = 0;
+        double pubWeight = 0;
+        if (code == OBTAIN_IP_PATENT) {
+            ipWeight = 1;
+        } else if (code == OBTAIN_PUBLICATION) {
+            pubWeight = 1;
+        } else {
+            ipWeight = 1.0 / IP_PATENT_ODDS;
+            pubWeight = 1 - ipWeight;
+        }
+
+        int kpiChange[NUM_UNIS] = {0};
+        int holder;
+        int holderCount;
+        awardPublicationPrestige(g->uniWithMostPubs, g->uniWithMostPubs_number,
+                player, g->numPubs[player-1] + 1, kpiChange,
+                &holder, &holderCount);
+        int uni = 0;
+        while (uni < NUM_UNIS) {
+            delta->kpi[uni] += pubWeight * kpiChange[uni];
+            uni++;
+        }
+        delta->kpi[player-1] += ipWeight * IP_KPI;
+    }
+}
+
+
+// start telling observer about things happening in the game, or stop
+// if it is NULL
+void setGameObserver (Game g, const gameObserver *observer) {
+    g->observer = observer;
+}
+
+
+// which vertex the path leads to, NO_VERTEX if it isn't a legal path
+// or it ends in the sea
+int vertexOfPath (const char *p) {
+    pthread_once(&boardBuilt, buildBoardGeometry);
+    int id = NO_VERTEX;
+    if (isLegalPath(p)) {
+        id = coordToVertexID(pathToVertex((char *)p));
+    }
+    return id;
+}
+
+
+// which edge the path's last step is along, NO_EDGE if it isn't a
+// legal path, it is empty or the edge is in the sea
+int edgeOfPath (const char *p) {
+    pthread_once(&boardBuilt, buildBoardGeometry);
+    int id = NO_EDGE;
+    if (p[0] != 0 && isLegalPath(p)) {
+        id = coordToEdgeID(pathToARC((char *)p));
+    }
+    return id;
+}
+
+
+// --- the unchecked fast path API ---
+// nothing below checks its arguments, see GameEngine.h
+
+int getCampusAt (Game g, int vertex) {
+    coord c = board.vertexCoord[vertex];
+    return g->grid[c.x][c.y].vertices[c.vertNum];
+}
+
+
+int getARCAt (Game g, int edge) {
+    coord c = board.edgeCoord[edge];
+    return g->grid[c.x][c.y].arcs[c.arcNum];
+}
+
+
+int getStudentsFast (Game g, int player, int discipline) {
+    return g->studentAmounts[player-1][discipline];
+}
+
+
+int getKPIpointsFast (Game g, int player) {
+    return g->numKPI[player-1];
+}
+
+
+int getExchangeRateFast (Game g, int player, int disciplineFrom) {
+    return exchangeRate(g, player, disciplineFrom);
+}
+
+
+// the board's vertices, edges and what joins them. The same for every
+// game
+const boardGraph *getBoardGraph (void) {
+    pthread_once(&boardBuilt, buildBoardGeometry);
+    return &board.graph;
+}
+
+
+// the canonical paths come straight out of the table findShortestPaths()
+// filled in
+const char *pathOfVertex (int vertex) {
+    CHECK(vertex >= 0 && vertex < NUM_VERTICES, "INVALID VERTEX");
+    pthread_once(&boardBuilt, buildBoardGeometry);
+    return board.vertexPath[vertex];
+}
+
+
+const char *pathOfEdge (int edge) {
+    CHECK(edge >= 0 && edge < NUM_EDGES, "INVALID EDGE");
+    pthread_once(&boardBuilt, buildBoardGeometry);
+    return board.edgePath[edge];
+}
+
+
+int canonicalVertexPath (const char *p, path out) {
+    int vertex = vertexOfPath(p);
+    out[0] = 0;
+    if (vertex != NO_VERTEX) {
+        strcpy(out, board.vertexPath[vertex]);
+    }
+    return vertex != NO_VERTEX;
+}
+
+
+int canonicalEdgePath (const char *p, path out) {
+    int edge = edgeOfPath(p);
+    out[0] = 0;
+    if (edge != NO_EDGE) {
+        strcpy(out, board.edgePath[edge]);
+    }
+    return edge != NO_EDGE;
+}
+
+
+// Checks and makes each action in turn on the game itself with the
+// observer unhooked, then puts back the copy taken at the start if one
+// is illegal. If someone is watching and the batch went through, it is
+// made again from the start with them hooked back in so they only ever
+// hear about turns that happened
+int applyActions (Game g, const action *acts, int n) {
+    game start = *g;
+    const gameObserver *observer = g->observer;
+    g->observer = NULL;
+
+    int failed = ALL_ACTIONS_APPLIED;
+    int i = 0;
+    while (i < n && failed == ALL_ACTIONS_APPLIED) {
+        if (checkBatchAction(g, &acts[i]) == LEGAL_ACTION) {
+            applyAction(g, &acts[i]);
+        } else {
+            failed = i;
+        }
+        i++;
+    }
+
+    if (failed != ALL_ACTIONS_APPLIED) {
+        *g = start;
+    } else if (observer != NULL) {
+        *g = start;
+        i = 0;
+        while (i < n) {
+            applyAction(g, &acts[i]);
+            i++;
+        }
+    }
+    g->observer = observer;
+
+    return failed;
+}
+
+
+// a copy of the game that shares nothing with it, not even the
+// observer
+Game cloneGame (Game g) {
+    Game copy = malloc(sizeof(game));
+    *copy = *g;
+    copy->observer = NULL;
+    return copy;
+}
+
+
+GamePublisher newGamePublisher (Game g) {
+    GamePublisher pub = malloc(sizeof(gamePublisher));
+    atomic_init(&pub->sequence, 0);
+    publishGame(pub, g);
+    return pub;
+}
+
+
+void disposeGamePublisher (GamePublisher pub) {
+    free(pub);
+}
+
+
+// only one thread may publish to a publisher, so nothing else ever
+// makes the sequence number odd
+void publishGame (GamePublisher pub, Game g) {
+    uint64_t words[PUBLISHED_WORDS] = {0};
+    memcpy(words, g, sizeof(game));
+
+    unsigned int sequence = atomic_load_explicit(&pub->sequence,
+            memory_order_relaxed);
+    atomic_store_explicit(&pub->sequence, sequence + 1, 
+            memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    size_t i = 0;
+    while (i < PUBLISHED_WORDS) {
+        atomic_store_explicit(&pub->words[i], words[i],
+                memory_order_relaxed);
+        i++;
+    }
+
+    atomic_store_explicit(&pub->sequence, sequence + 2,
+            memory_order_release);
+}
+
+
+void readPublishedGame (GamePublisher pub, Game out) {
+    uint64_t words[PUBLISHED_WORDS];
+    unsigned int before;
+    unsigned int after;
+    do {
+        before = atomic_load_explicit(&pub->sequence,
+                memory_order_acquire);
+        size_t i = 0;
+        while (i < PUBLISHED_WORDS) {
+            words[i] = atomic_load_explicit(&pub->words[i],
+                    memory_order_relaxed);
+            i++;
+        }
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&pub->sequence,
+                memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    memcpy(out, words, sizeof(game));
+    out->observer = NULL;
+}
+
+
+int isOnNetwork (Game g, int player, int vertex) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    CHECK(vertex >= 0 && vertex < NUM_VERTICES, "INVALID VERTEX");
+    return (g->network[player-1] & VERTEX_BIT(vertex)) != 0;
+}
+
+
+int isTouchingNetwork (Game g, int player, int edge) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    CHECK(edge >= 0 && edge < NUM_EDGES, "INVALID EDGE");
+    return isARCConnected(g, edge, player);
+}
+
+
+int getNetworkPiece (Game g, int player, int vertex) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    CHECK(vertex >= 0 && vertex < NUM_VERTICES, "INVALID VERTEX");
+    int piece = NO_VERTEX;
+    if (g->network[player-1] & VERTEX_BIT(vertex)) {
+        piece = findNetworkRoot(g, player, vertex);
+    }
+    return piece;
+}
+
+
+int getNetworkPieceSize (Game g, int player, int vertex) {
+    int piece = getNetworkPiece(g, player, vertex);
+    int size = 0;
+    if (piece != NO_VERTEX) {
+        size = g->networkSize[player-1][piece];
+    }
+    return size;
+}
+
+
+vertexSet getNetwork (Game g, int player) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    return g->network[player-1];
+}
+
+
+vertexSet getCampusFrontier (Game g, int player) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    return g->campusFrontier[player-1];
+}
+
+
+edgeSet getARCFrontier (Game g, int player) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    return g->arcFrontier[player-1];
+}
+
+
+// A campus gets one student from each region it touches when the
+// region's number comes up and a GO8 gets two, as in throwDice()
+void getProduction (Game g, int player,
+        int production[NUM_DICE_SCORES][NUM_DISCIPLINES]) {
+    CHECK(IS_PLAYER(player), "INVALID PLAYER");
+    memset(production, 0, 
+            sizeof(int) * NUM_DICE_SCORES * NUM_DISCIPLINES);
+
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        int contents = getCampusAt(g, vertex);
+        int students = 0;
+        if (contents == player) {
+            students = 1;
+        } else if (contents == player + GO8_A - CAMPUS_A) {
+            students = 2;
+        }
+
+        int i = 0;
+        while (students != 0 && i < 3) {
+            int region = board.graph.vertexRegions[vertex][i];
+            if (region != -1) {
+                coord c = regIDToCoord(region);
+                hex *h = &g->grid[c.x][c.y];
+                if (h->diceNum >= 2 && h->diceNum <= 12) {
+                    production[h->diceNum][h->resType] += students;
                 }
-                z++;
             }
-            x++;
-            z = 0;
+            i++;
         }
-        y++;
-        x = 0;
+        vertex++;
     }
+}
+
+
+double getDiceChance (int diceScore) {
+    return diceChance(diceScore);
+}
 
-    return exchangeRate;
+
+uint64_t hashBoard (int discipline[], int dice[]) {
+    uint64_t h = NUM_REGIONS;
+    int region = 0;
+    while (region < NUM_REGIONS) {
+        h = mixHash(h, discipline[region]);
+        h = mixHash(h, dice[region]);
+        region++;
+    }
+    return h;
+}
+
+
+// The network, frontiers and counts all follow from what is on the
+// vertices and edges, so they don't need hashing as well
+uint64_t hashGame (Game g) {
+    int discipline[NUM_REGIONS];
+    int dice[NUM_REGIONS];
+    int region = 0;
+    while (region < NUM_REGIONS) {
+        coord c = regIDToCoord(region);
+        discipline[region] = g->grid[c.x][c.y].resType;
+        dice[region] = g->grid[c.x][c.y].diceNum;
+        region++;
+    }
+
+    uint64_t h = mixHash(hashBoard(discipline, dice), g->turnNumber);
+    int i = 0;
+    while (i < NUM_UNIS) {
+        int d = 0;
+        while (d < NUM_DISCIPLINES) {
+            h = mixHash(h, g->studentAmounts[i][d]);
+            d++;
+        }
+        h = mixHash(h, g->numKPI[i]);
+        h = mixHash(h, g->numPubs[i]);
+        h = mixHash(h, g->numIPs[i]);
+        i++;
+    }
+    h = mixHash(h, g->uniWithMostARCs);
+    h = mixHash(h, g->uniWithMostPubs);
+
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        h = mixHash(h, getCampusAt(g, vertex));
+        vertex++;
+    }
+    int edge = 0;
+    while (edge < NUM_EDGES) {
+        h = mixHash(h, getARCAt(g, edge));
+        edge++;
+    }
+    return h;
+}
+
+
+// The campus and ARC blocks are one-hot, so they are cleared with the
+// rest and only the 1s written
+void getFeatures (Game g, float features[]) {
+    memset(features, 0, NUM_FEATURES * sizeof(float));
+
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        features[FEATURE_VERTICES + vertex * VERTEX_STATES
+            + getCampusAt(g, vertex)] = 1;
+        vertex++;
+    }
+    int edge = 0;
+    while (edge < NUM_EDGES) {
+        features[FEATURE_ARCS + edge * ARC_STATES
+            + getARCAt(g, edge)] = 1;
+        edge++;
+    }
+
+    int production[NUM_DICE_SCORES][NUM_DISCIPLINES];
+    int i = 0;
+    while (i < NUM_UNIS) {
+        getProduction(g, i + 1, production);
+        int d = 0;
+        while (d < NUM_DISCIPLINES) {
+            int feature = i * NUM_DISCIPLINES + d;
+            features[FEATURE_STUDENTS + feature] = g->studentAmounts[i][d];
+
+            double income = 0;
+            int score = 2;
+            while (score <= 12) {
+                income += production[score][d] * diceChance(score);
+                score++;
+            }
+            features[FEATURE_INCOME + feature] = income;
+            features[FEATURE_EXCHANGE + feature] = exchangeRate(g, i + 1, d);
+            d++;
+        }
+        features[FEATURE_KPI + i] = g->numKPI[i];
+        i++;
+    }
+    features[FEATURE_MOST_ARCS + g->uniWithMostARCs] = 1;
+    features[FEATURE_MOST_PUBS + g->uniWithMostPubs] = 1;
+}
+
+
+// The games are done FEATURE_LANES at a time: each one's features go
+// into a block, which is then copied out a row of lanes at a time, so
+// the writes to the batch go along its rows rather than down them
+void getFeatureBatch (Game games[], int numGames, float batch[]) {
+    int stride = FEATURE_BATCH_STRIDE(numGames);
+    float block[FEATURE_LANES][NUM_FEATURES];
+    int first = 0;
+    while (first < numGames) {
+        int lane = 0;
+        while (lane < FEATURE_LANES) {
+            if (first + lane < numGames) {
+                getFeatures(games[first + lane], block[lane]);
+            } else {
+                memset(block[lane], 0, NUM_FEATURES * sizeof(float));
+            }
+            lane++;
+        }
+
+        int feature = 0;
+        while (feature < NUM_FEATURES) {
+            float *row = &batch[feature * stride + first];
+            lane = 0;
+            while (lane < FEATURE_LANES) {
+                row[lane] = block[lane][feature];
+                lane++;
+            }
+            feature++;
+        }
+        first += FEATURE_LANES;
+    }
+}
+
+
+// Each row of the batch is a whole number of FEATURE_LANES, so every
+// group of games is scored with the same vector code and only the
+// scores of the games that are really there are kept
+void scoreFeatureBatch (const float batch[], int numGames,
+        const float weights[], float scores[]) {
+    int stride = FEATURE_BATCH_STRIDE(numGames);
+    float sums[FEATURE_LANES];
+    int first = 0;
+    while (first < numGames) {
+#ifdef __SSE2__
+        // two 4 lane sums cover the group
+        __m128 low = _mm_setzero_ps();
+        __m128 high = _mm_setzero_ps();
+        int feature = 0;
+        while (feature < NUM_FEATURES) {
+            const float *row = &batch[feature * stride + first];
+            __m128 weight = _mm_set1_ps(weights[feature]);
+            low = _mm_add_ps(low, _mm_mul_ps(weight, _mm_loadu_ps(row)));
+            high = _mm_add_ps(high,
+                    _mm_mul_ps(weight, _mm_loadu_ps(row + 4)));
+            feature++;
+        }
+        _mm_storeu_ps(sums, low);
+        _mm_storeu_ps(sums + 4, high);
+#else
+        // no vector unit, a lane at a time in the same order
+        int lane = 0;
+        while (lane < FEATURE_LANES) {
+            sums[lane] = 0;
+            lane++;
+        }
+        int feature = 0;
+        while (feature < NUM_FEATURES) {
+            const float *row = &batch[feature * stride + first];
+            lane = 0;
+            while (lane < FEATURE_LANES) {
+                sums[lane] += weights[feature] * row[lane];
+                lane++;
+            }
+            feature++;
+        }
+#endif
+        int game = first;
+        while (game < numGames && game < first + FEATURE_LANES) {
+            scores[game] = sums[game - first];
+            game++;
+        }
+        first += FEATURE_LANES;
+    }
 }
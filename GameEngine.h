@@ -0,0 +1,514 @@
+/*
+ *  GameEngine.h - engine extensions to the Game ADT
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Game.h is the fixed interface we were given and we aren't allowed
+ *  to alter it, so anything extra the bots and tools need from the
+ *  engine is declared here instead. Everything in this file is
+ *  implemented in Game.c next to the Game.h functions.
+ *
+ *  Game.h has no include guard, so include it BEFORE this file and
+ *  only include it once.
+ */
+
+#ifndef GAME_ENGINE_H
+#define GAME_ENGINE_H
+
+#include <stdint.h>
+
+#define NUM_DISCIPLINES 6
+
+// one more than the largest action code in Game.h
+#define NUM_ACTION_CODES 8
+
+// KPI points awarded for each thing a university owns
+#define CAMPUS_KPI 10
+#define GO8_KPI 20
+#define ARC_KPI 2
+#define IP_KPI 10
+#define PRESTIGE_BONUS 10
+
+// the first uni to get this many KPI points wins (see runGame.c)
+#define WINNING_KPI 150
+
+// dice scores go from 2 to 12, index a table by the score
+#define NUM_DICE_SCORES 13
+
+// 1 in IP_PATENT_ODDS spinoffs become an IP patent, the rest become
+// publications (see runGame.c)
+#define IP_PATENT_ODDS 3
+
+
+// =====================================================================
+//   ACTION COSTS
+// =====================================================================
+
+// the cost table stores one row per action code with a lane per
+// discipline, padded out to 8 lanes so a whole row can be compared
+// against a player's students in a single 128 bit vector compare.
+// The two padding lanes are always 0.
+#define COST_LANES 8
+
+// how many students of each discipline an action costs, indexed by
+// [actionCode][discipline]. PASS costs nothing. START_SPINOFF,
+// OBTAIN_PUBLICATION and OBTAIN_IP_PATENT share the same cost since a
+// spinoff turns into one of the other two. RETRAIN_STUDENTS is all 0
+// because its cost depends on the exchange rate, see
+// getExchangeRate()
+extern const short actionCosts[NUM_ACTION_CODES][COST_LANES];
+
+// returns a bitmask with bit (1 << actionCode) set for every action
+// the player currently has enough students to pay for.
+// RETRAIN_STUDENTS is never set (it isn't a fixed cost) and PASS is
+// always set. OBTAIN_PUBLICATION and OBTAIN_IP_PATENT are set whenever
+// START_SPINOFF is, even though players can't request them directly.
+// eg to see if UNI_A could afford a campus
+//   if (getAffordableActions(g, UNI_A) & (1 << BUILD_CAMPUS)) ...
+int getAffordableActions (Game g, int player);
+
+
+// =====================================================================
+//   LEGALITY WITH REASONS
+// =====================================================================
+
+// the reasons checkAction() gives for an action not being legal.
+// The first three (and ILLEGAL_DISCIPLINE) don't depend on the path,
+// so when one comes back every other action with the same action
+// code (and for retraining, the same disciplineFrom) is illegal too
+// until the player's students change
+#define LEGAL_ACTION 0
+#define ILLEGAL_ACTION_CODE 1   // not a code a player may ask for
+#define ILLEGAL_TERRA_NULLIS 2  // nothing is legal before turn 0
+#define ILLEGAL_UNAFFORDABLE 3  // not enough students
+#define ILLEGAL_DISCIPLINE 4    // retraining from/to a bad discipline
+#define ILLEGAL_PATH 5          // bad characters, too long, or in the sea
+#define ILLEGAL_OCCUPIED 6      // vertex/edge already taken (for a GO8:
+                                // not one of the player's campuses)
+#define ILLEGAL_NOT_CONNECTED 7 // not next to the player's ARCs/campuses
+                                // (a GO8 counts as a campus for ARCs)
+#define ILLEGAL_TOO_CLOSE 8     // a campus is on a neighbouring vertex
+
+// same rules as isLegalAction() but says why an action is illegal.
+// Checks run cheapest first and stop at the first failure, so this
+// never walks the path unless the player can already pay.
+// returns LEGAL_ACTION or one of the ILLEGAL_ codes above
+int checkAction (Game g, const action *a);
+
+
+// =====================================================================
+//   WHAT-IF PREVIEWS
+// =====================================================================
+
+// what an action would change, see previewAction()
+typedef struct _actionDelta {
+    // change in each university's KPI [A, B, C], including any
+    // prestige award changing hands
+    double kpi[NUM_UNIS];
+
+    // change in the current player's students of each discipline
+    int students[NUM_DISCIPLINES];
+
+    // change in the number of students of each discipline the current
+    // player can expect to be given per dice roll
+    double income[NUM_DISCIPLINES];
+} actionDelta;
+
+// fills in delta with what makeAction() would do for the current
+// player, without changing the game. Like makeAction() this assumes
+// the action is legal. START_SPINOFF is allowed here and gives the
+// expected change (1 in IP_PATENT_ODDS chance of an IP patent,
+// otherwise a publication)
+void previewAction (Game g, const action *a, actionDelta *delta);
+
+
+// =====================================================================
+//   EVENT HOOKS
+// =====================================================================
+
+// which prestige award onPrestigeTransfer is talking about
+#define MOST_ARCS_AWARD 0
+#define MOST_PUBS_AWARD 1
+
+// callbacks for things happening in a game. Any of them can be NULL
+// if you don't care about that event. Every callback is given back
+// the context pointer and the game the event happened in. They are
+// called during makeAction()/throwDice(), so don't change the game
+// from inside one.
+typedef struct _gameObserver {
+    void *context;
+
+    // player built a campus (or upgraded one to a GO8 if isGO8) at
+    // the vertex at the end of destination
+    void (*onCampusBuilt)(void *context, Game g, int player, 
+            int isGO8, const char *destination);
+
+    // player got the ARC at the end of destination
+    void (*onARCBuilt)(void *context, Game g, int player,
+            const char *destination);
+
+    // the dice came up diceScore and each uni was given
+    // produced[uni-1][discipline] students (before any 7 conversion)
+    void (*onStudentsProduced)(void *context, Game g, int diceScore,
+            int produced[NUM_UNIS][NUM_DISCIPLINES]);
+
+    // a 7 turned the player's mtv MTV and mmoney MMONEY students into
+    // THDs. Called for every uni on every 7, even if both are 0
+    void (*onSevenConversion)(void *context, Game g, int player,
+            int mtv, int mmoney);
+
+    // the award (MOST_ARCS_AWARD or MOST_PUBS_AWARD) went from one uni
+    // to another. from is NO_ONE the first time it is given out
+    void (*onPrestigeTransfer)(void *context, Game g, int award,
+            int from, int to);
+} gameObserver;
+
+// tell observer about everything that happens in g from now on, or
+// pass NULL to stop. The game only keeps the pointer, so the observer
+// must stay alive until it is removed or the game is disposed.
+// There is one observer per game; to feed several listeners, point
+// the observer at a callback that passes events on.
+// Compiling Game.c with -DNO_GAME_EVENTS leaves out every event so
+// the hot paths don't even test for an observer.
+void setGameObserver (Game g, const gameObserver *observer);
+
+
+// =====================================================================
+//   VERTEX/EDGE IDS AND THE UNCHECKED FAST PATH API
+// =====================================================================
+
+// every vertex and edge on the island has an integer ID, the same in
+// every game: vertices are 0..NUM_VERTICES-1, edges 0..NUM_EDGES-1
+#define NUM_VERTICES 54
+#define NUM_EDGES 72
+#define NO_VERTEX -1
+#define NO_EDGE -1
+
+// the ID of the vertex at the end of the path, or NO_VERTEX if the
+// path isn't legal (bad characters, too long, leaves the island)
+int vertexOfPath (const char *p);
+
+// the ID of the edge the path finishes along, or NO_EDGE if the path
+// isn't legal or is empty
+int edgeOfPath (const char *p);
+
+// The functions below are the unchecked fast path for trusted engine
+// code (search, rollouts) which has already made sure its arguments
+// are valid. They do no checking at all, not even asserts, and give
+// garbage or crash on bad arguments. Untrusted callers (player AIs)
+// should stick to Game.h, where every argument is checked.
+// Compiling Game.c with -DGAME_HARD_CHECKS makes the Game.h checks
+// hard errors even when NDEBUG turns asserts off.
+
+// the contents of a vertex (campus code or VACANT_VERTEX), by ID
+int getCampusAt (Game g, int vertex);
+
+// the contents of an edge (ARC code or VACANT_ARC), by ID
+int getARCAt (Game g, int edge);
+
+// getStudents(), getKPIpoints() and getExchangeRate() without the
+// checks. The exchange rate only depends on what is retrained from
+int getStudentsFast (Game g, int player, int discipline);
+int getKPIpointsFast (Game g, int player);
+int getExchangeRateFast (Game g, int player, int disciplineFrom);
+
+
+// =====================================================================
+//   THE BOARD AS A GRAPH
+// =====================================================================
+
+// sets of vertices and edges as bitsets, bit n is ID n
+typedef uint64_t vertexSet;
+typedef struct _edgeSet {
+    uint64_t bits[2];
+} edgeSet;
+
+#define VERTEX_BIT(v) ((vertexSet)1 << (v))
+
+// which vertices/edges are next to which, by ID. The same for every
+// game: vertices and edges in the sea aren't in the graph, so lists
+// that are short are padded with NO_VERTEX/NO_EDGE (or -1 regions)
+typedef struct _boardGraph {
+    // the vertices one edge away from each vertex, and the edge to
+    // each, so vertexEdges[v][i] joins v to vertexNeighbours[v][i]
+    int vertexNeighbours[NUM_VERTICES][3];
+    int vertexEdges[NUM_VERTICES][3];
+
+    // the two vertices at the ends of each edge
+    int edgeEnds[NUM_EDGES][2];
+
+    // the regions (as in newGame()) each vertex touches
+    int vertexRegions[NUM_VERTICES][3];
+
+    // the discipline each vertex has a retraining centre for, or -1
+    int vertexRetrain[NUM_VERTICES];
+
+    // the same adjacency again as bitsets
+    vertexSet neighbourSet[NUM_VERTICES];
+    edgeSet vertexEdgeSet[NUM_VERTICES];
+    vertexSet edgeEndSet[NUM_EDGES];
+} boardGraph;
+
+// the board graph (built once and shared, never changes)
+const boardGraph *getBoardGraph (void);
+
+// small helpers for edge sets
+static inline void edgeSetAdd (edgeSet *set, int e) {
+    set->bits[e >> 6] |= (uint64_t)1 << (e & 63);
+}
+
+static inline void edgeSetRemove (edgeSet *set, int e) {
+    set->bits[e >> 6] &= ~((uint64_t)1 << (e & 63));
+}
+
+static inline int edgeSetHas (const edgeSet *set, int e) {
+    return (set->bits[e >> 6] >> (e & 63)) & 1;
+}
+
+static inline int edgeSetCount (const edgeSet *set) {
+    return __builtin_popcountll(set->bits[0])
+        + __builtin_popcountll(set->bits[1]);
+}
+
+
+// =====================================================================
+//   CANONICAL PATHS
+// =====================================================================
+
+// the canonical path to a vertex/edge ID: the shortest path there,
+// taking L before R before B where there's a tie. They are all found
+// once, when the board is. The string belongs to the engine, copy it
+// into the action rather than changing it
+const char *pathOfVertex (int vertex);
+const char *pathOfEdge (int edge);
+
+// write the canonical path to the vertex (or edge) at the end of p
+// into out, so every path to the same place, loops and all, comes out
+// the same. returns FALSE and leaves out empty if p isn't legal (see
+// vertexOfPath() and edgeOfPath())
+int canonicalVertexPath (const char *p, path out);
+int canonicalEdgePath (const char *p, path out);
+
+
+// =====================================================================
+//   BATCHES OF ACTIONS
+// =====================================================================
+
+// what applyActions() returns when every action went through
+#define ALL_ACTIONS_APPLIED -1
+
+// make the n actions in acts for the current player, in order, as if
+// each was checked with isLegalAction() and then made. Spinoffs must
+// already be resolved: OBTAIN_PUBLICATION and OBTAIN_IP_PATENT are
+// checked as the START_SPINOFF they came from, and START_SPINOFF
+// itself is illegal. Either every action is made or none are:
+// returns ALL_ACTIONS_APPLIED, or the index of the first illegal
+// action with the game left exactly as it was before the call.
+// The observer (if any) only hears about a batch that went through
+int applyActions (Game g, const action *acts, int n);
+
+
+// =====================================================================
+//   COPIES AND SNAPSHOTS FOR OTHER THREADS
+// =====================================================================
+
+// a new game in exactly the same state as g, with no observer.
+// Dispose of it with disposeGame() like any other game
+Game cloneGame (Game g);
+
+// A publisher lets one game thread share a live game with any number
+// of reader threads without locks. The game thread publishes the game
+// whenever it wants readers to see it (eg after each makeAction() or
+// throwDice()) and never waits for readers. Readers copy the last
+// published state into a game of their own, and always get a whole
+// state from a single publishGame(), never a mix of two.
+// A game must never be read by one thread while another changes it,
+// so readers must only look at their own copy, never the live game.
+typedef struct _gamePublisher *GamePublisher;
+
+// make a publisher with g as the first published state
+GamePublisher newGamePublisher (Game g);
+void disposeGamePublisher (GamePublisher pub);
+
+// publish the state g is in now. Only one thread may publish to any
+// one publisher
+void publishGame (GamePublisher pub, Game g);
+
+// copy the last published state into out (eg a game from cloneGame()).
+// The copy has no observer. Safe to call from any number of threads
+// at once, retries if the game thread publishes in the middle
+void readPublishedGame (GamePublisher pub, Game out);
+
+
+// =====================================================================
+//   ARC NETWORKS
+// =====================================================================
+
+// A uni's network is every vertex its campuses, GO8s and ARCs touch.
+// The game keeps track of it (and which vertices are joined up by
+// ARCs into the same piece) as things are built, so these are all
+// quick however big the network gets.
+
+// TRUE if the vertex is on the player's network
+int isOnNetwork (Game g, int player, int vertex);
+
+// TRUE if either end of the edge is on the player's network, ie the
+// player could build an ARC there if it was free
+int isTouchingNetwork (Game g, int player, int edge);
+
+// which piece of the player's network the vertex is in, as the ID of
+// one vertex standing for the whole piece: two vertices are joined up
+// by the player's ARCs when they give the same piece. NO_VERTEX if the
+// vertex isn't on the network
+int getNetworkPiece (Game g, int player, int vertex);
+
+// how many vertices are in the piece the vertex is in, 0 if it isn't
+// on the player's network
+int getNetworkPieceSize (Game g, int player, int vertex);
+
+// every vertex on the player's network
+vertexSet getNetwork (Game g, int player);
+
+
+// =====================================================================
+//   FRONTIERS
+// =====================================================================
+
+// every vertex where the player could build a campus right now: free,
+// not next to any campus, and at the end of one of the player's ARCs.
+// Whether they can pay for it isn't taken into account
+vertexSet getCampusFrontier (Game g, int player);
+
+// every edge where the player could get an ARC right now: free and
+// touching the player's network. Whether they can pay for it isn't
+// taken into account
+edgeSet getARCFrontier (Game g, int player);
+
+// take the lowest vertex/edge out of a set and return it, or
+// NO_VERTEX/NO_EDGE if the set is empty. eg to try every campus spot
+//   vertexSet spots = getCampusFrontier(g, player);
+//   int v = popVertex(&spots);
+//   while (v != NO_VERTEX) {
+//       ... build at pathOfVertex(v) ...
+//       v = popVertex(&spots);
+//   }
+static inline int popVertex (vertexSet *set) {
+    int v = NO_VERTEX;
+    if (*set != 0) {
+        v = __builtin_ctzll(*set);
+        *set &= *set - 1;
+    }
+    return v;
+}
+
+static inline int popEdge (edgeSet *set) {
+    int e = NO_EDGE;
+    if (set->bits[0] != 0) {
+        e = __builtin_ctzll(set->bits[0]);
+        set->bits[0] &= set->bits[0] - 1;
+    } else if (set->bits[1] != 0) {
+        e = 64 + __builtin_ctzll(set->bits[1]);
+        set->bits[1] &= set->bits[1] - 1;
+    }
+    return e;
+}
+
+
+// =====================================================================
+//   PRODUCTION
+// =====================================================================
+
+// fill in how many students of each discipline the player is given
+// when the dice come up each score, production[diceScore][discipline],
+// before any 7 conversion. Rows 0 and 1 are always 0
+void getProduction (Game g, int player,
+        int production[NUM_DICE_SCORES][NUM_DISCIPLINES]);
+
+// the chance of the dice coming up diceScore, 0 unless 2..12
+double getDiceChance (int diceScore);
+
+// =====================================================================
+//   POSITION HASHES
+// =====================================================================
+
+// 64 bit hashes for telling positions apart, eg to key a table of
+// positions searched before. Two different positions sharing a hash
+// is unlikely enough (about 1 in 2^64) that callers needn't check.
+// The hashes are the same from one run (and build) to the next, so
+// they can be saved to disk
+
+// a hash of the board newGame() was given, by region: the same for
+// every game on that board
+uint64_t hashBoard (int discipline[], int dice[]);
+
+// a hash of the board and everything that can change during a game:
+// the turn number, every uni's students, KPI points, publications and
+// IP patents, who has the prestige awards and what is on every vertex
+// and edge. Games on the same board in the same state hash the same,
+// however they got there
+uint64_t hashGame (Game g);
+
+// =====================================================================
+//   FEATURES FOR LEARNED EVALUATION
+// =====================================================================
+
+// A game as a vector of floats, for evaluation functions that are
+// learned rather than written by hand. Every feature is at the same
+// index in every game. The blocks below come one after another in
+// this order, and counts are left as they are, not scaled:
+//
+//   vertices   VERTEX_STATES for each vertex by ID, one-hot on what is
+//              there (VACANT_VERTEX, CAMPUS_A..C then GO8_A..C)
+//   ARCs       ARC_STATES for each edge by ID, one-hot on what is there
+//              (VACANT_ARC, ARC_A..C)
+//   students   each uni's students [A, B, C] of each discipline
+//   KPI        each uni's KPI points
+//   prestige   one-hot on who has the most ARCs (NO_ONE, UNI_A..C),
+//              then the same for the most publications
+//   income     the students of each discipline each uni can expect
+//              per dice roll (see getProduction())
+//   exchange   each uni's exchange rate from each discipline
+//   padding    0s up to a multiple of FEATURE_LANES
+#define VERTEX_STATES 7
+#define ARC_STATES (NUM_UNIS + 1)
+#define PRESTIGE_STATES (NUM_UNIS + 1)
+
+#define FEATURE_VERTICES 0
+#define FEATURE_ARCS (FEATURE_VERTICES + NUM_VERTICES * VERTEX_STATES)
+#define FEATURE_STUDENTS (FEATURE_ARCS + NUM_EDGES * ARC_STATES)
+#define FEATURE_KPI (FEATURE_STUDENTS + NUM_UNIS * NUM_DISCIPLINES)
+#define FEATURE_MOST_ARCS (FEATURE_KPI + NUM_UNIS)
+#define FEATURE_MOST_PUBS (FEATURE_MOST_ARCS + PRESTIGE_STATES)
+#define FEATURE_INCOME (FEATURE_MOST_PUBS + PRESTIGE_STATES)
+#define FEATURE_EXCHANGE (FEATURE_INCOME + NUM_UNIS * NUM_DISCIPLINES)
+#define FEATURE_PADDING (FEATURE_EXCHANGE + NUM_UNIS * NUM_DISCIPLINES)
+
+// how many floats go through a vector unit at once (a 256 bit one)
+#define FEATURE_LANES 8
+
+#define NUM_FEATURES (((FEATURE_PADDING + FEATURE_LANES - 1) \
+        / FEATURE_LANES) * FEATURE_LANES)
+
+// write the features of g into features[NUM_FEATURES]
+void getFeatures (Game g, float features[]);
+
+// A batch of games is laid out feature by feature rather than game by
+// game: feature f of game i is at batch[f * stride + i], where stride
+// is FEATURE_BATCH_STRIDE(numGames). So a weight times a feature for
+// FEATURE_LANES games at once is a single vector multiply, and a
+// linear evaluation of the whole batch never has to gather. The games
+// past numGames in each row are 0
+#define FEATURE_BATCH_STRIDE(numGames) \
+    ((((numGames) + FEATURE_LANES - 1) / FEATURE_LANES) * FEATURE_LANES)
+
+// write the features of games[0..numGames-1] into batch, which has
+// room for NUM_FEATURES * FEATURE_BATCH_STRIDE(numGames) floats
+void getFeatureBatch (Game games[], int numGames, float batch[]);
+
+// the linear evaluation of every game in a batch from
+// getFeatureBatch(): scores[i] is the sum of weights[f] times game
+// i's feature f, over all NUM_FEATURES features
+void scoreFeatureBatch (const float batch[], int numGames,
+        const float weights[], float scores[]);
+
+#endif
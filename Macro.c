@@ -0,0 +1,293 @@
+/*
+ * Macro.c - buying something in one move, retraining included
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * See Macro.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+
+
+#define NO_SOURCE -1
+
+
+// how much of each discipline a vertex brings in each roll, on
+// average, and which disciplines it has a retraining centre for
+typedef struct _vertexValue {
+    double production[NUM_DISCIPLINES];
+    int retrainCentres;
+} vertexValue;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// add a move for every vertex in spots which isn't dominated by
+// another one of them, returns the new count
+static int addVertexMoves(const rollout *r, int actionCode,
+        vertexSet spots, int withCentres, rolloutMove builds[], int count);
+
+// the value of a campus on vertex
+static void valueVertex(const rollout *r, int vertex, vertexValue *value);
+
+// TRUE if a is no better than b in any way. With withCentres the
+// retraining centres count as well as the production
+static int isDominated(const vertexValue *a, const vertexValue *b,
+        int withCentres);
+
+// TRUE if the current player could pay for actionCode by retraining
+static int canRetrainFor(const rollout *r, int actionCode);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+// Two vertices which are exactly as good as each other keep the one
+// with the lower ID
+static int addVertexMoves(const rollout *r, int actionCode,
+        vertexSet spots, int withCentres, rolloutMove builds[], int count) {
+    vertexValue values[NUM_VERTICES];
+    int vertices[NUM_VERTICES];
+    int numSpots = 0;
+    vertexSet left = spots;
+    int vertex = popVertex(&left);
+    while (vertex != NO_VERTEX) {
+        vertices[numSpots] = vertex;
+        valueVertex(r, vertex, &values[numSpots]);
+        numSpots++;
+        vertex = popVertex(&left);
+    }
+
+    int i = 0;
+    while (i < numSpots) {
+        int dominated = FALSE;
+        int j = 0;
+        while (j < numSpots && !dominated) {
+            if (j != i && isDominated(&values[i], &values[j], withCentres)
+                    && (!isDominated(&values[j], &values[i], withCentres)
+                        || j < i)) {
+                dominated = TRUE;
+            }
+            j++;
+        }
+        if (!dominated) {
+            rolloutMove move = {.actionCode = actionCode,
+                .target = vertices[i], .disciplineFrom = -1,
+                .disciplineTo = -1};
+            builds[count] = move;
+            count++;
+        }
+        i++;
+    }
+    return count;
+}
+
+
+static void valueVertex(const rollout *r, int vertex, vertexValue *value) {
+    const rolloutBoard *board = r->board;
+    memset(value, 0, sizeof(vertexValue));
+    int score = 2;
+    while (score <= 12) {
+        int region = 0;
+        while (region < board->numProducing[score]) {
+            if (board->producingVertices[score][region]
+                    & VERTEX_BIT(vertex)) {
+                int discipline = board->producingDiscipline[score][region];
+                value->production[discipline] += getDiceChance(score);
+            }
+            region++;
+        }
+        score++;
+    }
+
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        if (board->retrainVertices[discipline] & VERTEX_BIT(vertex)) {
+            value->retrainCentres |= 1 << discipline;
+        }
+        discipline++;
+    }
+}
+
+
+// THD can't be spent or retrained, so making more of it is no better
+static int isDominated(const vertexValue *a, const vertexValue *b,
+        int withCentres) {
+    int dominated = TRUE;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        if (discipline != STUDENT_THD
+                && a->production[discipline] > b->production[discipline]) {
+            dominated = FALSE;
+        }
+        discipline++;
+    }
+    if (withCentres && (a->retrainCentres & ~b->retrainCentres)) {
+        dominated = FALSE;
+    }
+    return dominated;
+}
+
+
+static int canRetrainFor(const rollout *r, int actionCode) {
+    rolloutMove retrains[MAX_MACRO_RETRAINS];
+    return rolloutRetraining(r, actionCode, retrains) != CANT_RETRAIN;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   MACRO FUNCTIONS BEGIN
+// =====================================================================
+
+// the same places to build as rolloutListMoves()
+int rolloutMacroMoves (const rollout *r, rolloutMove builds[]) {
+    int player = rolloutWhoseTurn(r);
+    rolloutMove move = {.actionCode = PASS, .target = -1,
+        .disciplineFrom = -1, .disciplineTo = -1};
+    builds[0] = move;
+    int count = 1;
+
+    if (player != NO_ONE) {
+        if (canRetrainFor(r, BUILD_CAMPUS)) {
+            count = addVertexMoves(r, BUILD_CAMPUS,
+                    rolloutCampusSpots(r, player), TRUE, builds, count);
+        }
+        if (canRetrainFor(r, BUILD_GO8)) {
+            count = addVertexMoves(r, BUILD_GO8, r->campuses[player-1],
+                    FALSE, builds, count);
+        }
+        if (canRetrainFor(r, OBTAIN_ARC)) {
+            edgeSet spots = rolloutARCSpots(r, player);
+            move.actionCode = OBTAIN_ARC;
+            move.target = popEdge(&spots);
+            while (move.target != NO_EDGE) {
+                builds[count] = move;
+                count++;
+                move.target = popEdge(&spots);
+            }
+        }
+        if (canRetrainFor(r, START_SPINOFF)) {
+            move.actionCode = START_SPINOFF;
+            move.target = -1;
+            builds[count] = move;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+
+// Each student short is retrained from the discipline with the best
+// rate that has enough to spare, which is as cheap as it gets since
+// every retraining makes exactly one student. Ties go to whichever has
+// the most to spare
+int rolloutRetraining (const rollout *r, int actionCode,
+        rolloutMove retrains[]) {
+    int player = rolloutWhoseTurn(r);
+    int spare[NUM_DISCIPLINES];
+    int rate[NUM_DISCIPLINES];
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        spare[discipline] = r->students[player-1][discipline]
+            - actionCosts[actionCode][discipline];
+        rate[discipline] = rolloutExchangeRate(r, player, discipline);
+        discipline++;
+    }
+
+    int count = 0;
+    int to = 0;
+    while (to < NUM_DISCIPLINES && count != CANT_RETRAIN) {
+        while (spare[to] < 0 && count != CANT_RETRAIN) {
+            int from = NO_SOURCE;
+            discipline = STUDENT_BPS;
+            while (discipline <= STUDENT_MMONEY) {
+                if (spare[discipline] >= rate[discipline] && (from == NO_SOURCE
+                            || rate[discipline] < rate[from]
+                            || (rate[discipline] == rate[from]
+                                && spare[discipline] > spare[from]))) {
+                    from = discipline;
+                }
+                discipline++;
+            }
+
+            if (from == NO_SOURCE) {
+                count = CANT_RETRAIN;
+            } else {
+                rolloutMove move = {.actionCode = RETRAIN_STUDENTS,
+                    .target = -1, .disciplineFrom = from,
+                    .disciplineTo = to};
+                retrains[count] = move;
+                count++;
+                spare[from] -= rate[from];
+                spare[to]++;
+            }
+        }
+        to++;
+    }
+    return count;
+}
+
+
+void rolloutMakeMacro (rollout *r, rolloutMove *build) {
+    if (build->actionCode != PASS) {
+        rolloutMove retrains[MAX_MACRO_RETRAINS];
+        int count = rolloutRetraining(r, build->actionCode, retrains);
+        int i = 0;
+        while (i < count) {
+            rolloutMakeMove(r, &retrains[i]);
+            i++;
+        }
+        rolloutMakeMove(r, build);
+    }
+}
+
+
+void rolloutMacroAction (const rollout *r, const rolloutMove *build,
+        macroAction *macro) {
+    macro->numActions = 0;
+    if (build->actionCode != PASS) {
+        rolloutMove retrains[MAX_MACRO_RETRAINS];
+        int numRetrains = rolloutRetraining(r, build->actionCode, retrains);
+        while (macro->numActions < numRetrains) {
+            macro->actions[macro->numActions] =
+                rolloutMoveToAction(r, &retrains[macro->numActions]);
+            macro->numActions++;
+        }
+    }
+    macro->actions[macro->numActions] = rolloutMoveToAction(r, build);
+    macro->numActions++;
+}
+
+
+int getMacroActions (Game g, macroAction macros[]) {
+    rolloutBoard board;
+    rollout r;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&r, &board, g, 0);
+
+    rolloutMove builds[MAX_MACROS];
+    int count = rolloutMacroMoves(&r, builds);
+    int i = 0;
+    while (i < count) {
+        rolloutMacroAction(&r, &builds[i], &macros[i]);
+        i++;
+    }
+    return count;
+}
+
+
+int makeMacroAction (Game g, const macroAction *macro) {
+    return applyActions(g, macro->actions, macro->numActions);
+}
@@ -0,0 +1,72 @@
+/*
+ *  Macro.h - buying something in one move, retraining included
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Retraining is only ever worth doing to pay for something, but it
+ *  is most of the moves a player has: each of five disciplines can be
+ *  retrained to five others. A macro action is one purchase together
+ *  with the retraining it needs first, taken from wherever the
+ *  exchange rates make it cheapest, so a search chooses between
+ *  things to buy rather than ways to shuffle students around.
+ *
+ *  Purchases which are dominated are left out: a campus or GO8 on a
+ *  vertex which produces no more of any discipline than another one
+ *  on offer (and for a campus, has no retraining centre the other
+ *  hasn't). ARCs and spinoffs are all kept.
+ *
+ *  Include Game.h, GameEngine.h and Rollout.h before this file.
+ */
+
+#ifndef MACRO_H
+#define MACRO_H
+
+// the most students anything costs (a GO8), so the most retraining a
+// purchase can need
+#define MAX_MACRO_RETRAINS 5
+#define MAX_MACRO_ACTIONS (MAX_MACRO_RETRAINS + 1)
+
+// PASS, a campus or GO8 on every vertex, an ARC on every edge and a
+// spinoff
+#define MAX_MACROS (2 + 2 * NUM_VERTICES + NUM_EDGES)
+
+// what rolloutRetraining() returns when retraining can't pay
+#define CANT_RETRAIN -1
+
+// the retraining in order and then the purchase. Passing is a PASS on
+// its own
+typedef struct _macroAction {
+    int numActions;
+    action actions[MAX_MACRO_ACTIONS];
+} macroAction;
+
+// fill builds[] with PASS and every purchase the current player can
+// make once they've retrained, leaving out the dominated ones.
+// returns how many there are
+int rolloutMacroMoves (const rollout *r, rolloutMove builds[]);
+
+// fill retrains[] with the retraining the current player needs to pay
+// for actionCode, spending as few students as possible. returns how
+// many, or CANT_RETRAIN if no retraining would pay for it
+int rolloutRetraining (const rollout *r, int actionCode,
+        rolloutMove retrains[]);
+
+// make the retraining build needs and then build, which is resolved
+// like rolloutMakeMove() does. build has to be from
+// rolloutMacroMoves()
+void rolloutMakeMacro (rollout *r, rolloutMove *build);
+
+// fill in the macro action for build, one of rolloutMacroMoves(), as
+// Game.h actions
+void rolloutMacroAction (const rollout *r, const rolloutMove *build,
+        macroAction *macro);
+
+// the macro actions for whoever's turn it is in g, as Game.h actions
+int getMacroActions (Game g, macroAction macros[]);
+
+// make all of a macro's actions at once with applyActions(), which
+// says what it returns. A START_SPINOFF at the end has to be turned
+// into what it became first
+int makeMacroAction (Game g, const macroAction *macro);
+
+#endif
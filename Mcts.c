@@ -0,0 +1,612 @@
+/*
+ * Mcts.c - a Monte Carlo tree search player
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * The nodes are allocated from an arena (see Arena.h) and find each
+ * other by their index in it. Each node's children are allocated
+ * together, so a node only needs the index of its first child and how
+ * many there are. There are two arenas: keeping a subtree is copying
+ * it into the spare one a level at a time and resetting the other, so
+ * nothing in here goes to the heap after newMcts().
+ *
+ * The moves in the tree are macro actions (see Macro.h), so a move is
+ * the purchase and the retraining is worked out again each time it's
+ * made. See Mcts.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Arena.h"
+#include "Macro.h"
+#include "Mcts.h"
+
+
+// what happens at a node: the player whose turn it is picks a move,
+// the dice are thrown, or a spinoff turns into a publication or an IP
+#define DECISION_NODE 0
+#define DICE_NODE 1
+#define SPINOFF_NODE 2
+
+// how many children each kind of chance node has
+#define NUM_DICE_CHILDREN (NUM_DICE_SCORES - 2)
+#define NUM_SPINOFF_CHILDREN 2
+
+// a DICE_NODE's children are in order of score from 2, a
+// SPINOFF_NODE's are the publication and then the IP patent
+#define LOWEST_SCORE 2
+#define PUBLICATION_CHILD 0
+#define IP_PATENT_CHILD 1
+
+#define NO_CHILDREN -1
+
+// playouts stop going down the tree this deep
+#define MAX_TREE_DEPTH 512
+
+// how a move is packed into a node: the action code in the low bits,
+// then the vertex or edge ID, then the disciplines retrained from and to
+#define MOVE_CODE_BITS 4
+#define MOVE_TARGET_BITS 7
+#define MOVE_DISCIPLINE_BITS 3
+#define MOVE_TARGET_SHIFT MOVE_CODE_BITS
+#define MOVE_FROM_SHIFT (MOVE_TARGET_SHIFT + MOVE_TARGET_BITS)
+#define MOVE_TO_SHIFT (MOVE_FROM_SHIFT + MOVE_DISCIPLINE_BITS)
+#define FIELD(bits) ((1u << (bits)) - 1)
+
+
+// 24 bytes, so plenty of them fit in the cache
+typedef struct _mctsNode {
+    // the move which led here from a DECISION_NODE (see packMove())
+    uint32_t move;
+    int32_t firstChild;
+    uint32_t visits;
+    uint16_t numChildren;
+
+    // who made the move, the playouts won are counted for them
+    uint8_t player;
+    uint8_t kind;
+    double wins;
+} mctsNode;
+
+typedef struct _mcts {
+    rolloutBoard board;
+    rollout root;
+
+    // the tree is in arenas[active], and nodes is where that starts
+    Arena arenas[2];
+    int active;
+    mctsNode *nodes;
+    int numNodes;
+
+    uint64_t rng;
+} mcts;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// one playout from the root: down the tree, add to it, play out and
+// count the result on the way back up
+static void playout(mcts *m);
+
+// the child of a DECISION_NODE to go down, by UCB1. Children that
+// haven't been visited are tried first in a random order
+static int selectChild(mcts *m, int node);
+
+// give a node its children, or FALSE if there isn't room
+static int expand(mcts *m, int node, const rollout *r);
+
+// count new nodes next to each other in the tree's arena, returns the
+// index of the first or NO_CHILDREN if there isn't room
+static int allocNodes(mcts *m, int count);
+
+// fill in a node with no children
+static void setNode(mcts *m, int node, int kind, int player,
+        uint32_t move);
+
+// what kind of node a move from a DECISION_NODE leads to
+static int kindAfter(const rolloutMove *move);
+
+// how much of a playout ending in r each uni gets: all of it to the
+// winner, or shared between whoever has the most KPI points
+static void scorePlayout(const rollout *r, int winner,
+        double reward[NUM_UNIS]);
+
+// make the child of the root the new root, keeping only its subtree.
+// NO_CHILDREN starts a new tree
+static void reroot(mcts *m, int child);
+
+// the child of a node which made the move
+static int findChild(const mcts *m, int node, uint32_t move);
+
+// a move as one number, with only the fields its action code uses
+static uint32_t packMove(const rolloutMove *move);
+static rolloutMove unpackMove(uint32_t move);
+
+// the move for an action made in the game
+static rolloutMove moveOfAction(action a);
+
+static uint64_t nextRandom(mcts *m);
+
+// a random number from 0 to n-1
+static int randomBelow(mcts *m, int n);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+// A chance node picks its child by doing what it stands for to the
+// rollout. A leaf which has been visited before gets its children
+// now. One which hasn't (or has no room for them) is played out from,
+// after the dice or spinoff for a chance node
+static void playout(mcts *m) {
+    rollout r = m->root;
+    r.rng = nextRandom(m);
+    int path[MAX_TREE_DEPTH];
+    int depth = 0;
+    int winner = NO_ONE;
+    int node = 0;
+    int leaf = FALSE;
+
+    while (!leaf) {
+        path[depth] = node;
+        depth++;
+        mctsNode *n = &m->nodes[node];
+        if (n->numChildren == 0 && (n->visits == 0
+                    || depth == MAX_TREE_DEPTH || !expand(m, node, &r))) {
+            leaf = TRUE;
+        }
+        n = &m->nodes[node];
+
+        if (n->kind == DECISION_NODE && !leaf) {
+            int player = rolloutWhoseTurn(&r);
+            node = selectChild(m, node);
+            rolloutMove move = unpackMove(m->nodes[node].move);
+            if (move.actionCode != PASS && move.actionCode != START_SPINOFF) {
+                rolloutMakeMacro(&r, &move);
+                if (r.kpi[player-1] >= WINNING_KPI) {
+                    winner = player;
+                    path[depth] = node;
+                    depth++;
+                    leaf = TRUE;
+                }
+            }
+        } else if (n->kind == DICE_NODE) {
+            int score = rolloutRollDice(&r);
+            rolloutThrowDice(&r, score);
+            if (!leaf) {
+                node = n->firstChild + score - LOWEST_SCORE;
+            }
+        } else if (n->kind == SPINOFF_NODE) {
+            int player = rolloutWhoseTurn(&r);
+            rolloutMove move = {.actionCode = START_SPINOFF};
+            rolloutMakeMacro(&r, &move);
+            if (r.kpi[player-1] >= WINNING_KPI) {
+                winner = player;
+                leaf = TRUE;
+            } else if (!leaf) {
+                node = n->firstChild + PUBLICATION_CHILD;
+                if (move.actionCode == OBTAIN_IP_PATENT) {
+                    node = n->firstChild + IP_PATENT_CHILD;
+                }
+            }
+        }
+    }
+
+    if (winner == NO_ONE) {
+        winner = rolloutPlayout(&r, MCTS_PLAYOUT_TURNS);
+    }
+    double reward[NUM_UNIS];
+    scorePlayout(&r, winner, reward);
+
+    int i = 0;
+    while (i < depth) {
+        mctsNode *n = &m->nodes[path[i]];
+        n->visits++;
+        if (n->player != NO_ONE) {
+            n->wins += reward[n->player-1];
+        }
+        i++;
+    }
+}
+
+
+static int selectChild(mcts *m, int node) {
+    const mctsNode *n = &m->nodes[node];
+    int unvisited = 0;
+    int i = n->firstChild;
+    while (i < n->firstChild + n->numChildren) {
+        if (m->nodes[i].visits == 0) {
+            unvisited++;
+        }
+        i++;
+    }
+
+    int best = n->firstChild;
+    if (unvisited > 0) {
+        int pick = randomBelow(m, unvisited);
+        i = n->firstChild;
+        while (pick >= 0) {
+            if (m->nodes[i].visits == 0) {
+                best = i;
+                pick--;
+            }
+            i++;
+        }
+    } else {
+        double logVisits = log(n->visits);
+        double bestValue = -1;
+        i = n->firstChild;
+        while (i < n->firstChild + n->numChildren) {
+            const mctsNode *child = &m->nodes[i];
+            double value = child->wins / child->visits + MCTS_EXPLORATION
+                * sqrt(logVisits / child->visits);
+            if (value > bestValue) {
+                best = i;
+                bestValue = value;
+            }
+            i++;
+        }
+    }
+    return best;
+}
+
+
+static int expand(mcts *m, int node, const rollout *r) {
+    int kind = m->nodes[node].kind;
+    int player = rolloutWhoseTurn(r);
+    int added = FALSE;
+
+    if (kind == DECISION_NODE) {
+        rolloutMove moves[MAX_MACROS];
+        int count = rolloutMacroMoves(r, moves);
+        int first = allocNodes(m, count);
+        if (first != NO_CHILDREN) {
+            m->nodes[node].firstChild = first;
+            m->nodes[node].numChildren = count;
+            int i = 0;
+            while (i < count) {
+                setNode(m, first + i, kindAfter(&moves[i]), player,
+                        packMove(&moves[i]));
+                i++;
+            }
+            added = TRUE;
+        }
+    } else {
+        int count = NUM_DICE_CHILDREN;
+        if (kind == SPINOFF_NODE) {
+            count = NUM_SPINOFF_CHILDREN;
+        }
+        int first = allocNodes(m, count);
+        if (first != NO_CHILDREN) {
+            m->nodes[node].firstChild = first;
+            m->nodes[node].numChildren = count;
+            int i = 0;
+            while (i < count) {
+                setNode(m, first + i, DECISION_NODE, player, PASS);
+                i++;
+            }
+            added = TRUE;
+        }
+    }
+    return added;
+}
+
+
+// Every allocation is a whole number of nodes (which is a whole
+// number of ARENA_ALIGNMENTs), so they follow straight on from each
+// other and the index is the offset from the start
+static int allocNodes(mcts *m, int count) {
+    Arena a = m->arenas[m->active];
+    mctsNode *block = arenaAlloc(a, count * sizeof(mctsNode));
+    int first = NO_CHILDREN;
+    if (block != NULL) {
+        first = block - m->nodes;
+        m->numNodes += count;
+    }
+    return first;
+}
+
+
+static void setNode(mcts *m, int node, int kind, int player,
+        uint32_t move) {
+    mctsNode *n = &m->nodes[node];
+    memset(n, 0, sizeof(mctsNode));
+    n->move = move;
+    n->player = player;
+    n->kind = kind;
+    n->firstChild = NO_CHILDREN;
+}
+
+
+static int kindAfter(const rolloutMove *move) {
+    int kind = DECISION_NODE;
+    if (move->actionCode == PASS) {
+        kind = DICE_NODE;
+    } else if (move->actionCode == START_SPINOFF) {
+        kind = SPINOFF_NODE;
+    }
+    return kind;
+}
+
+
+static void scorePlayout(const rollout *r, int winner,
+        double reward[NUM_UNIS]) {
+    int most = 0;
+    int leaders = 0;
+    int i = 0;
+    while (i < NUM_UNIS) {
+        if (r->kpi[i] > most) {
+            most = r->kpi[i];
+            leaders = 0;
+        }
+        if (r->kpi[i] == most) {
+            leaders++;
+        }
+        i++;
+    }
+
+    i = 0;
+    while (i < NUM_UNIS) {
+        reward[i] = 0;
+        if (winner != NO_ONE) {
+            if (winner == i + 1) {
+                reward[i] = 1;
+            }
+        } else if (r->kpi[i] == most) {
+            reward[i] = 1.0 / leaders;
+        }
+        i++;
+    }
+}
+
+
+// Children are copied a whole family at a time after the copy of
+// their parent, so the new tree is in the same order as the old one
+// and the families stay together. A subtree always fits, since it
+// fitted in an arena the same size before
+static void reroot(mcts *m, int child) {
+    mctsNode *old = m->nodes;
+    Arena oldArena = m->arenas[m->active];
+    m->active = !m->active;
+    m->nodes = arenaStart(m->arenas[m->active]);
+    m->numNodes = 0;
+    arenaReset(m->arenas[m->active]);
+
+    if (child == NO_CHILDREN) {
+        int kind = DECISION_NODE;
+        if (rolloutWhoseTurn(&m->root) == NO_ONE) {
+            kind = DICE_NODE;
+        }
+        setNode(m, allocNodes(m, 1), kind, NO_ONE, PASS);
+    } else {
+        m->nodes[allocNodes(m, 1)] = old[child];
+        int node = 0;
+        while (node < m->numNodes) {
+            mctsNode *n = &m->nodes[node];
+            if (n->numChildren > 0) {
+                int first = allocNodes(m, n->numChildren);
+                memcpy(&m->nodes[first], &old[n->firstChild],
+                        n->numChildren * sizeof(mctsNode));
+                n->firstChild = first;
+            }
+            node++;
+        }
+    }
+
+    arenaReset(oldArena);
+}
+
+
+static int findChild(const mcts *m, int node, uint32_t move) {
+    const mctsNode *n = &m->nodes[node];
+    int found = NO_CHILDREN;
+    int i = n->firstChild;
+    while (i < n->firstChild + n->numChildren && found == NO_CHILDREN) {
+        if (m->nodes[i].move == move) {
+            found = i;
+        }
+        i++;
+    }
+    return found;
+}
+
+
+static uint32_t packMove(const rolloutMove *move) {
+    uint32_t packed = move->actionCode;
+    if (move->actionCode == BUILD_CAMPUS || move->actionCode == BUILD_GO8
+            || move->actionCode == OBTAIN_ARC) {
+        packed |= (uint32_t)move->target << MOVE_TARGET_SHIFT;
+    } else if (move->actionCode == RETRAIN_STUDENTS) {
+        packed |= (uint32_t)move->disciplineFrom << MOVE_FROM_SHIFT;
+        packed |= (uint32_t)move->disciplineTo << MOVE_TO_SHIFT;
+    }
+    return packed;
+}
+
+
+static rolloutMove unpackMove(uint32_t move) {
+    rolloutMove unpacked;
+    unpacked.actionCode = move & FIELD(MOVE_CODE_BITS);
+    unpacked.target = (move >> MOVE_TARGET_SHIFT) & FIELD(MOVE_TARGET_BITS);
+    unpacked.disciplineFrom =
+        (move >> MOVE_FROM_SHIFT) & FIELD(MOVE_DISCIPLINE_BITS);
+    unpacked.disciplineTo =
+        (move >> MOVE_TO_SHIFT) & FIELD(MOVE_DISCIPLINE_BITS);
+    return unpacked;
+}
+
+
+static rolloutMove moveOfAction(action a) {
+    rolloutMove move;
+    memset(&move, 0, sizeof(rolloutMove));
+    move.actionCode = a.actionCode;
+    if (a.actionCode == BUILD_CAMPUS || a.actionCode == BUILD_GO8) {
+        move.target = vertexOfPath(a.destination);
+    } else if (a.actionCode == OBTAIN_ARC) {
+        move.target = edgeOfPath(a.destination);
+    } else if (a.actionCode == RETRAIN_STUDENTS) {
+        move.disciplineFrom = a.disciplineFrom;
+        move.disciplineTo = a.disciplineTo;
+    }
+    return move;
+}
+
+
+static uint64_t nextRandom(mcts *m) {
+    m->rng ^= m->rng >> 12;
+    m->rng ^= m->rng << 25;
+    m->rng ^= m->rng >> 27;
+    return m->rng * 2685821657736338717ULL;
+}
+
+
+static int randomBelow(mcts *m, int n) {
+    uint64_t top = nextRandom(m) >> 32;
+    return (int)((top * (uint64_t)n) >> 32);
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   MCTS FUNCTIONS BEGIN
+// =====================================================================
+
+Mcts newMcts (Game g, int maxNodes, uint64_t seed) {
+    Mcts m = malloc(sizeof(mcts));
+    memset(m, 0, sizeof(mcts));
+    rolloutBoardFromGame(&m->board, g);
+    rolloutFromGame(&m->root, &m->board, g, seed);
+    m->arenas[0] = newArena(maxNodes * sizeof(mctsNode));
+    m->arenas[1] = newArena(maxNodes * sizeof(mctsNode));
+    m->nodes = arenaStart(m->arenas[0]);
+    m->rng = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (m->rng == 0) {
+        m->rng = 1;
+    }
+    reroot(m, NO_CHILDREN);
+    return m;
+}
+
+
+void disposeMcts (Mcts m) {
+    disposeArena(m->arenas[0]);
+    disposeArena(m->arenas[1]);
+    free(m);
+}
+
+
+// the most played move rather than the best scoring one, since a move
+// which only looks good from a few playouts hasn't been played much
+void mctsChooseMacro (Mcts m, int playouts, macroAction *macro) {
+    rolloutMove best = {.actionCode = PASS};
+    if (m->nodes[0].kind == DECISION_NODE) {
+        int i = 0;
+        while (i < playouts) {
+            playout(m);
+            i++;
+        }
+
+        const mctsNode *root = &m->nodes[0];
+        int mostVisits = -1;
+        i = root->firstChild;
+        while (i < root->firstChild + root->numChildren) {
+            if ((int)m->nodes[i].visits > mostVisits) {
+                best = unpackMove(m->nodes[i].move);
+                mostVisits = m->nodes[i].visits;
+            }
+            i++;
+        }
+    }
+
+    rolloutMacroAction(&m->root, &best, macro);
+}
+
+
+// A spinoff's outcome is the child of the START_SPINOFF's child
+void mctsMakeAction (Mcts m, action a) {
+    rolloutMove move = moveOfAction(a);
+    int child = NO_CHILDREN;
+    if (m->nodes[0].kind == DECISION_NODE) {
+        if (move.actionCode == OBTAIN_PUBLICATION
+                || move.actionCode == OBTAIN_IP_PATENT) {
+            int started = findChild(m, 0, START_SPINOFF);
+            if (started != NO_CHILDREN
+                    && m->nodes[started].numChildren > 0) {
+                child = m->nodes[started].firstChild + PUBLICATION_CHILD;
+                if (move.actionCode == OBTAIN_IP_PATENT) {
+                    child = m->nodes[started].firstChild + IP_PATENT_CHILD;
+                }
+            }
+        } else {
+            child = findChild(m, 0, packMove(&move));
+        }
+    }
+
+    if (move.actionCode != PASS) {
+        rolloutMakeMove(&m->root, &move);
+    }
+    reroot(m, child);
+}
+
+
+// The retraining isn't in the tree, only what it paid for
+void mctsMakeMacro (Mcts m, const macroAction *macro) {
+    int i = 0;
+    while (i < macro->numActions - 1) {
+        rolloutMove move = moveOfAction(macro->actions[i]);
+        rolloutMakeMove(&m->root, &move);
+        i++;
+    }
+    mctsMakeAction(m, macro->actions[macro->numActions-1]);
+}
+
+
+// From a DECISION_NODE the dice are thrown after its PASS
+void mctsThrowDice (Mcts m, int diceScore) {
+    int node = 0;
+    if (m->nodes[0].kind == DECISION_NODE) {
+        node = findChild(m, 0, PASS);
+    }
+
+    int child = NO_CHILDREN;
+    if (node != NO_CHILDREN && m->nodes[node].kind == DICE_NODE
+            && m->nodes[node].numChildren > 0) {
+        child = m->nodes[node].firstChild + diceScore - LOWEST_SCORE;
+    }
+
+    rolloutThrowDice(&m->root, diceScore);
+    reroot(m, child);
+}
+
+
+int mctsRootVisits (Mcts m) {
+    return m->nodes[0].visits;
+}
+
+
+int mctsNumNodes (Mcts m) {
+    return m->numNodes;
+}
+
+
+size_t mctsMemoryUsed (Mcts m) {
+    return arenaUsed(m->arenas[m->active]);
+}
+
+
+size_t mctsPeakMemory (Mcts m) {
+    size_t peak = arenaPeak(m->arenas[0]);
+    if (arenaPeak(m->arenas[1]) > peak) {
+        peak = arenaPeak(m->arenas[1]);
+    }
+    return peak;
+}
@@ -0,0 +1,72 @@
+/*
+ *  Mcts.h - a Monte Carlo tree search player
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Every playout walks down the tree picking moves by UCB1, rolls the
+ *  dice (and spinoffs) where it comes to them, adds a level to the
+ *  tree and then plays random moves on a rollout (see Rollout.h) for
+ *  at most MCTS_PLAYOUT_TURNS turns. A playout nobody has won by then
+ *  goes to whoever has the most KPI points.
+ *
+ *  The tree lives as long as the game: tell it every action made and
+ *  every dice roll, and the subtree for what happened becomes the new
+ *  root with all the playouts already under it. Everything else is
+ *  thrown away at once, so the next decision starts from the work the
+ *  last one did instead of from nothing. All the tree's memory is
+ *  allocated when the player is made, it never grows past maxNodes.
+ *
+ *  The moves it searches are macro actions (see Macro.h): something to
+ *  buy along with the retraining to pay for it.
+ *
+ *  Include Game.h, GameEngine.h, Rollout.h and Macro.h before this
+ *  file.
+ */
+
+#ifndef MCTS_H
+#define MCTS_H
+
+// playouts stop after this many turns
+#define MCTS_PLAYOUT_TURNS 60
+
+// how much UCB1 favours moves that haven't been tried much
+#define MCTS_EXPLORATION 1.0
+
+typedef struct _mcts *Mcts;
+
+// a player for the game g as it is now, which keeps a tree of at most
+// maxNodes nodes. seed picks the dice and moves of its playouts
+Mcts newMcts (Game g, int maxNodes, uint64_t seed);
+void disposeMcts (Mcts m);
+
+// run playouts from the current position and fill in the macro action
+// played the most for whoever's turn it is, a PASS if it isn't anyone's
+// turn. A START_SPINOFF at the end has to be turned into the
+// publication or IP patent it becomes before it's made
+void mctsChooseMacro (Mcts m, int playouts, macroAction *macro);
+
+// the macro action was made in the game, with any spinoff turned into
+// what it became
+void mctsMakeMacro (Mcts m, const macroAction *macro);
+
+// the action a (any legal one, not only the tree's) was made in the
+// game. For a spinoff, a is the OBTAIN_PUBLICATION or OBTAIN_IP_PATENT
+// it became. Retraining on its own isn't in the tree, so it starts a
+// new one
+void mctsMakeAction (Mcts m, action a);
+
+// the dice were thrown in the game and came up diceScore
+void mctsThrowDice (Mcts m, int diceScore);
+
+// how many playouts have gone through the current position, including
+// ones kept from earlier decisions
+int mctsRootVisits (Mcts m);
+
+// how many nodes the tree has
+int mctsNumNodes (Mcts m);
+
+// how many bytes the tree uses now, and the most it has used at once
+size_t mctsMemoryUsed (Mcts m);
+size_t mctsPeakMemory (Mcts m);
+
+#endif
@@ -0,0 +1,688 @@
+/*
+ * Planner.c - the best plan for the rest of a turn
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * A depth first search over what the player could buy and where, with
+ * a table of positions already worked out. Only the current player's
+ * students, pieces and spinoffs change during their turn, so those are
+ * all a position needs to be told apart. See Planner.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+
+
+// the position table has 1 << PLAN_TABLE_BITS entries
+#define PLAN_TABLE_BITS 14
+#define PLAN_TABLE_SIZE (1 << PLAN_TABLE_BITS)
+
+// how a 64 bit hash is spread, the golden ratio in fixed point
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// what a campus and an ARC cost in students, for how far away a
+// campus spot the player can still get to
+#define CAMPUS_STUDENTS 4
+#define ARC_STUDENTS 2
+
+// the stage of a turn once the search has stopped building campuses
+// and is closing the turn out (see searchPlan())
+#define CLOSING_TURN -2
+
+// the most students one purchase costs (a GO8), so the most it can
+// leave the player owing
+#define MAX_BUY_STUDENTS 5
+
+
+// what can change during the player's turn: the students (less what
+// the player owes), where they have built (which also sets the
+// exchange rates), and the spinoffs. The KPI points and prestige follow from these, and stage
+// is where the search is in the turn (see searchPlan())
+typedef struct _planKey {
+    edgeSet arcs;
+    vertexSet campuses;
+    vertexSet go8s;
+    int students[NUM_DISCIPLINES];
+    int rates[NUM_DISCIPLINES];
+    int numPubs;
+    int numIPs;
+    int stage;
+} planKey;
+
+// a purchase and, if it lowers a rate, the retraining just before it
+// that pays off what is owed. sources[d] is how many times discipline
+// d is retrained, and stage is the stage of the turn after it
+typedef struct _planStep {
+    rolloutMove buy;
+    int sources[NUM_DISCIPLINES];
+    int stage;
+} planStep;
+
+typedef struct _planEntry {
+    planKey key;
+    // the plan the entry was made for, entries from older plans are
+    // treated as empty
+    unsigned int generation;
+    // the best the player can expect from here and the step to get it
+    // (a PASS buy to stop)
+    double value;
+    planStep best;
+} planEntry;
+
+typedef struct _planner {
+    unsigned int generation;
+
+    // who is planning and how
+    int player;
+    planScore score;
+    void *data;
+    int positions;
+
+    planEntry table[PLAN_TABLE_SIZE];
+} planner;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// the best expected score from r, filling in the table on the way.
+// depth is how many steps have been taken this turn already
+static double searchPlan(planner *p, const rollout *r, int stage,
+        int depth);
+
+// buy in r if what the player owes after it can still be paid, going
+// on to stage next, and keep the best step in best if it beats value
+static void searchBuy(planner *p, const rollout *r, rolloutMove buy,
+        int next, int depth, double *value, planStep *best);
+
+// fill in step->sources from discipline from onwards with left
+// retrainings, no more than spare[] of each, and search each way
+static void searchSources(planner *p, const rollout *r, planStep *step,
+        const int spare[], int from, int left, int depth,
+        double *value, planStep *best);
+
+// the score of taking step (a spinoff is averaged over its outcomes)
+static double searchStep(planner *p, const rollout *r,
+        const planStep *step, int depth);
+
+// make the retraining in step and then its buy, listing the retrains
+// in retrains[] if it isn't NULL. returns how many there were
+static int makeStep(rollout *r, const planStep *step,
+        rolloutMove retrains[]);
+
+// TRUE if buy is a campus on a retraining centre the player doesn't
+// have the discount for yet
+static int lowersRate(const rollout *r, int player, rolloutMove buy);
+
+// pay off what the player owes in r by retraining their spare students,
+// listing the retrainings in retrains[] if it isn't NULL. returns how
+// many there were
+static int settle(rollout *r, int player, rolloutMove retrains[]);
+
+// the ARCs the player could build now that a campus later in the turn
+// might need, out from the vertex from or anywhere if it's NO_VERTEX
+static edgeSet leadingARCs(const rollout *r, int player, int from);
+
+// the end of edge that isn't on the player's network yet
+static int farEnd(const rollout *r, int player, int edge);
+
+// the table entry for r if it has been worked out this plan
+static planEntry *findPosition(planner *p, const rollout *r,
+        int stage);
+
+// the entry r would go in, and its key
+static planEntry *positionEntry(planner *p, const rollout *r,
+        int stage, planKey *key);
+
+// add move to the end of plan, making it in replay
+static void addToPlan(turnPlan *plan, rollout *replay, rolloutMove move);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+// Buying something later is never dearer, and for KPI points it
+// doesn't matter when or where anything other than a campus and the
+// ARCs up to it is bought. So the search builds campuses one at a
+// time, each after the ARCs out to it (stage is the vertex they have
+// got to so far, or NO_VERTEX between campuses), then closes the turn
+// out with the rest: spinoffs, GO8s on the lowest campus and ARCs on
+// the lowest free edge.
+//
+// Stopping (PASS) is an option except partway to a campus, where the
+// same ARCs could have closed the turn out instead, so start from the
+// score once what's owed is paid and see if buying anything beats it
+static double searchPlan(planner *p, const rollout *r, int stage,
+        int depth) {
+    planEntry *entry = findPosition(p, r, stage);
+    double value;
+
+    if (entry != NULL) {
+        value = entry->value;
+    } else {
+        p->positions++;
+        value = -HUGE_VAL;
+        if (stage == NO_VERTEX || stage == CLOSING_TURN) {
+            rollout settled = *r;
+            settle(&settled, p->player, NULL);
+            value = p->score(&settled, p->player, p->data);
+        }
+        planStep best;
+        memset(&best, 0, sizeof(best));
+        best.buy = (rolloutMove){.actionCode = PASS, .target = -1,
+            .disciplineFrom = -1, .disciplineTo = -1};
+
+        if (depth < MAX_PLAN_MOVES) {
+            int i = p->player - 1;
+            rolloutMove buy = best.buy;
+            if (stage != CLOSING_TURN) {
+                vertexSet campusSpots = rolloutCampusSpots(r, p->player);
+                if (stage != NO_VERTEX) {
+                    campusSpots &= VERTEX_BIT(stage);
+                }
+                buy.actionCode = BUILD_CAMPUS;
+                buy.target = popVertex(&campusSpots);
+                while (buy.target != NO_VERTEX) {
+                    searchBuy(p, r, buy, NO_VERTEX, depth, &value, &best);
+                    buy.target = popVertex(&campusSpots);
+                }
+
+                edgeSet arcSpots = leadingARCs(r, p->player, stage);
+                buy.actionCode = OBTAIN_ARC;
+                buy.target = popEdge(&arcSpots);
+                while (buy.target != NO_EDGE) {
+                    searchBuy(p, r, buy, farEnd(r, p->player, buy.target),
+                            depth, &value, &best);
+                    buy.target = popEdge(&arcSpots);
+                }
+            }
+
+            if (stage == NO_VERTEX || stage == CLOSING_TURN) {
+                buy.actionCode = START_SPINOFF;
+                buy.target = -1;
+                searchBuy(p, r, buy, CLOSING_TURN, depth, &value, &best);
+
+                edgeSet arcSpots = rolloutARCSpots(r, p->player);
+                buy.actionCode = OBTAIN_ARC;
+                buy.target = popEdge(&arcSpots);
+                if (buy.target != NO_EDGE) {
+                    searchBuy(p, r, buy, CLOSING_TURN, depth, &value,
+                            &best);
+                }
+
+                vertexSet go8Spots = r->campuses[i];
+                buy.actionCode = BUILD_GO8;
+                buy.target = popVertex(&go8Spots);
+                if (buy.target != NO_VERTEX) {
+                    searchBuy(p, r, buy, CLOSING_TURN, depth, &value,
+                            &best);
+                }
+            }
+        }
+
+        // the children may have taken the slot since it was looked up
+        planKey key;
+        entry = positionEntry(p, r, stage, &key);
+        entry->key = key;
+        entry->generation = p->generation;
+        entry->value = value;
+        entry->best = best;
+    }
+
+    return value;
+}
+
+
+// Retraining only ever gets cheaper during a turn, so it never hurts
+// to leave it until the rates are about to change. Until then it only
+// matters that what's owed can be paid, not which students pay it, so
+// the students are left owing. A campus that lowers a rate has to be
+// paid for first, and which students pay then matters to what comes
+// after, so try every way the spare ones can cover it
+static void searchBuy(planner *p, const rollout *r, rolloutMove buy,
+        int next, int depth, double *value, planStep *best) {
+    const int *students = r->students[p->player-1];
+    const short *cost = actionCosts[buy.actionCode];
+    int spare[NUM_DISCIPLINES];
+    int owed = 0;
+    int canRetrain = 0;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        spare[discipline] = 0;
+        if (students[discipline] < cost[discipline]) {
+            owed += cost[discipline] - students[discipline];
+        } else if (discipline != STUDENT_THD) {
+            spare[discipline] = (students[discipline] - cost[discipline])
+                / rolloutExchangeRate(r, p->player, discipline);
+            canRetrain += spare[discipline];
+        }
+        discipline++;
+    }
+
+    if (owed <= canRetrain) {
+        planStep step;
+        memset(&step, 0, sizeof(step));
+        step.buy = buy;
+        step.stage = next;
+        if (lowersRate(r, p->player, buy)) {
+            searchSources(p, r, &step, spare, STUDENT_BPS, owed, depth,
+                    value, best);
+        } else {
+            double stepValue = searchStep(p, r, &step, depth);
+            if (stepValue > *value) {
+                *value = stepValue;
+                *best = step;
+            }
+        }
+    }
+}
+
+
+// the last discipline takes whatever is left
+static void searchSources(planner *p, const rollout *r, planStep *step,
+        const int spare[], int from, int left, int depth,
+        double *value, planStep *best) {
+    if (from == STUDENT_MMONEY) {
+        if (left <= spare[from]) {
+            step->sources[from] = left;
+            double stepValue = searchStep(p, r, step, depth);
+            if (stepValue > *value) {
+                *value = stepValue;
+                *best = *step;
+            }
+        }
+    } else {
+        int count = 0;
+        while (count <= left && count <= spare[from]) {
+            step->sources[from] = count;
+            searchSources(p, r, step, spare, from + 1, left - count,
+                    depth, value, best);
+            count++;
+        }
+    }
+}
+
+
+static double searchStep(planner *p, const rollout *r,
+        const planStep *step, int depth) {
+    double value;
+    rollout next = *r;
+    if (step->buy.actionCode == START_SPINOFF) {
+        planStep outcome = *step;
+        outcome.buy.actionCode = OBTAIN_IP_PATENT;
+        makeStep(&next, &outcome, NULL);
+        value = searchPlan(p, &next, step->stage, depth + 1)
+            / IP_PATENT_ODDS;
+
+        next = *r;
+        outcome.buy.actionCode = OBTAIN_PUBLICATION;
+        makeStep(&next, &outcome, NULL);
+        value += searchPlan(p, &next, step->stage, depth + 1)
+            * (IP_PATENT_ODDS - 1) / IP_PATENT_ODDS;
+    } else {
+        makeStep(&next, step, NULL);
+        value = searchPlan(p, &next, step->stage, depth + 1);
+    }
+    return value;
+}
+
+
+// Pair each retraining off with the next discipline still short
+static int makeStep(rollout *r, const planStep *step,
+        rolloutMove retrains[]) {
+    const int *students = r->students[rolloutWhoseTurn(r)-1];
+    const short *cost = actionCosts[step->buy.actionCode];
+    rolloutMove retrain = {.actionCode = RETRAIN_STUDENTS, .target = -1,
+        .disciplineFrom = -1, .disciplineTo = 0};
+    int count = 0;
+    int from = STUDENT_BPS;
+    while (from <= STUDENT_MMONEY) {
+        retrain.disciplineFrom = from;
+        int n = 0;
+        while (n < step->sources[from]) {
+            while (students[retrain.disciplineTo]
+                    >= cost[retrain.disciplineTo]) {
+                retrain.disciplineTo++;
+            }
+            rolloutMakeMove(r, &retrain);
+            if (retrains != NULL) {
+                retrains[count] = retrain;
+            }
+            count++;
+            n++;
+        }
+        from++;
+    }
+    rolloutMove buy = step->buy;
+    rolloutMakeMove(r, &buy);
+    return count;
+}
+
+
+static int lowersRate(const rollout *r, int player, rolloutMove buy) {
+    vertexSet owned = r->campuses[player-1] | r->go8s[player-1];
+    int lowers = FALSE;
+    if (buy.actionCode == BUILD_CAMPUS) {
+        int discipline = STUDENT_BPS;
+        while (discipline <= STUDENT_MMONEY) {
+            vertexSet centre = r->board->retrainVertices[discipline];
+            if ((centre & VERTEX_BIT(buy.target)) && !(centre & owned)) {
+                lowers = TRUE;
+            }
+            discipline++;
+        }
+    }
+    return lowers;
+}
+
+
+// Take each student owed from whichever discipline has the most
+// retrainings to spare
+static int settle(rollout *r, int player, rolloutMove retrains[]) {
+    int *students = r->students[player-1];
+    int rates[NUM_DISCIPLINES];
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        rates[discipline] = rolloutExchangeRate(r, player, discipline);
+        discipline++;
+    }
+
+    int count = 0;
+    int owed = 0;
+    while (owed < NUM_DISCIPLINES) {
+        while (students[owed] < 0) {
+            int from = STUDENT_BPS;
+            int most = -1;
+            discipline = STUDENT_BPS;
+            while (discipline <= STUDENT_MMONEY) {
+                int spare = students[discipline] / rates[discipline];
+                if (spare > most) {
+                    from = discipline;
+                    most = spare;
+                }
+                discipline++;
+            }
+            students[from] -= rates[from];
+            students[owed]++;
+            if (retrains != NULL) {
+                retrains[count] = (rolloutMove){
+                    .actionCode = RETRAIN_STUDENTS, .target = -1,
+                    .disciplineFrom = from, .disciplineTo = owed};
+            }
+            count++;
+        }
+        owed++;
+    }
+    return count;
+}
+
+
+// A campus can only need an ARC whose far end is new to the network,
+// with a way on from there to a free campus spot that doesn't come
+// back through the network and that the player has the students for.
+// A breadth first search out from the spots finds those ends
+static edgeSet leadingARCs(const rollout *r, int player, int from) {
+    const boardGraph *graph = r->board->graph;
+    int i = player - 1;
+    vertexSet network = r->arcEnds[i] | r->campuses[i] | r->go8s[i];
+    int spendable = 0;
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        spendable += r->students[i][discipline];
+        discipline++;
+    }
+    // how many more ARCs past the next one could lead to a campus
+    int reach = (spendable - CAMPUS_STUDENTS) / ARC_STUDENTS - 1;
+
+    int distance[NUM_VERTICES];
+    int queue[NUM_VERTICES];
+    int head = 0;
+    int tail = 0;
+    vertexSet near = 0;
+    vertexSet spots = ~(network | r->occupied | r->blocked);
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        if (reach >= 0 && (spots & VERTEX_BIT(v))) {
+            near |= VERTEX_BIT(v);
+            distance[v] = 0;
+            queue[tail] = v;
+            tail++;
+        }
+        v++;
+    }
+    while (head < tail) {
+        v = queue[head];
+        head++;
+        int n = 0;
+        while (n < 3 && distance[v] < reach) {
+            int next = graph->vertexNeighbours[v][n];
+            int edge = graph->vertexEdges[v][n];
+            if (next != NO_VERTEX && !(near & VERTEX_BIT(next))
+                    && !(network & VERTEX_BIT(next))
+                    && !edgeSetHas(&r->arcsTaken, edge)) {
+                near |= VERTEX_BIT(next);
+                distance[next] = distance[v] + 1;
+                queue[tail] = next;
+                tail++;
+            }
+            n++;
+        }
+    }
+
+    edgeSet frontier = rolloutARCSpots(r, player);
+    if (from != NO_VERTEX) {
+        edgeSet around = {{0, 0}};
+        int n = 0;
+        while (n < 3) {
+            int edge = graph->vertexEdges[from][n];
+            if (edge != NO_EDGE && edgeSetHas(&frontier, edge)) {
+                edgeSetAdd(&around, edge);
+            }
+            n++;
+        }
+        frontier = around;
+    }
+
+    edgeSet leading = {{0, 0}};
+    int edge = popEdge(&frontier);
+    while (edge != NO_EDGE) {
+        if (near & ~network & VERTEX_BIT(farEnd(r, player, edge))) {
+            edgeSetAdd(&leading, edge);
+        }
+        edge = popEdge(&frontier);
+    }
+    return leading;
+}
+
+
+// an edge on the frontier has at least one end on the network
+static int farEnd(const rollout *r, int player, int edge) {
+    const boardGraph *graph = r->board->graph;
+    vertexSet network = r->arcEnds[player-1] | r->campuses[player-1]
+        | r->go8s[player-1];
+    int end = graph->edgeEnds[edge][0];
+    if (network & VERTEX_BIT(end)) {
+        end = graph->edgeEnds[edge][1];
+    }
+    return end;
+}
+
+
+static planEntry *findPosition(planner *p, const rollout *r,
+        int stage) {
+    planKey key;
+    planEntry *entry = positionEntry(p, r, stage, &key);
+    if (entry->generation != p->generation
+            || memcmp(&entry->key, &key, sizeof(planKey)) != 0) {
+        entry = NULL;
+    }
+    return entry;
+}
+
+
+// mix the key in an int at a time and use the top bits
+static planEntry *positionEntry(planner *p, const rollout *r,
+        int stage, planKey *key) {
+    int i = p->player - 1;
+    memset(key, 0, sizeof(planKey));
+    key->arcs = r->arcs[i];
+    key->campuses = r->campuses[i];
+    key->go8s = r->go8s[i];
+    memcpy(key->students, r->students[i], sizeof(key->students));
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        key->rates[discipline] = 0;
+        if (discipline != STUDENT_THD) {
+            key->rates[discipline] =
+                rolloutExchangeRate(r, p->player, discipline);
+        }
+        discipline++;
+    }
+    key->numPubs = r->numPubs[i];
+    key->numIPs = r->numIPs[i];
+    key->stage = stage;
+
+    const int *words = (const int *)key;
+    uint64_t hash = 0;
+    int w = 0;
+    while (w < (int)(sizeof(planKey) / sizeof(int))) {
+        hash = (hash ^ (uint32_t)words[w]) * HASH_MULTIPLIER;
+        hash ^= hash >> 29;
+        w++;
+    }
+    return &p->table[(hash * HASH_MULTIPLIER) >> (64 - PLAN_TABLE_BITS)];
+}
+
+
+static void addToPlan(turnPlan *plan, rollout *replay, rolloutMove move) {
+    if (plan->numMoves < MAX_PLAN_MOVES) {
+        plan->moves[plan->numMoves] = move;
+        plan->actions[plan->numMoves] = rolloutMoveToAction(replay, &move);
+        plan->numMoves++;
+        if (move.actionCode == START_SPINOFF) {
+            move.actionCode = OBTAIN_PUBLICATION;
+        }
+        rolloutMakeMove(replay, &move);
+    }
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   PLANNER FUNCTIONS BEGIN
+// =====================================================================
+
+Planner newPlanner (void) {
+    Planner p = malloc(sizeof(planner));
+    memset(p, 0, sizeof(planner));
+    return p;
+}
+
+
+void disposePlanner (Planner p) {
+    free(p);
+}
+
+
+double kpiScore (const rollout *r, int player, void *data) {
+    return r->kpi[player-1];
+}
+
+
+// Search from the start, then follow the best step out of each
+// position. A position the search worked out can have been pushed out
+// of the table by a later one, so work it out again if so. The
+// purchases between one change of rates and the next are listed once
+// it's known what retraining pays for them, which all goes first
+void planTurn (Planner p, const rollout *r, planScore score, void *data,
+        turnPlan *plan) {
+    p->generation++;
+    p->player = rolloutWhoseTurn(r);
+    p->score = score;
+    if (score == NULL) {
+        p->score = kpiScore;
+    }
+    p->data = data;
+    p->positions = 0;
+
+    plan->numMoves = 0;
+    plan->score = 0;
+    if (p->player != NO_ONE) {
+        plan->score = searchPlan(p, r, NO_VERTEX, 0);
+
+        rollout at = *r;
+        rollout replay = *r;
+        rolloutMove retrains[MAX_PLAN_MOVES * MAX_BUY_STUDENTS];
+        int numRetrains = 0;
+        rolloutMove buys[MAX_PLAN_MOVES];
+        int numBuys = 0;
+        int stage = NO_VERTEX;
+        int steps = 0;
+        int done = FALSE;
+        while (!done && steps < MAX_PLAN_MOVES) {
+            planEntry *entry = findPosition(p, &at, stage);
+            if (entry == NULL) {
+                searchPlan(p, &at, stage, steps);
+                entry = findPosition(p, &at, stage);
+            }
+            planStep step = entry->best;
+            if (step.buy.actionCode == PASS) {
+                done = TRUE;
+            } else {
+                buys[numBuys] = step.buy;
+                numBuys++;
+                if (step.buy.actionCode == START_SPINOFF) {
+                    step.buy.actionCode = OBTAIN_PUBLICATION;
+                }
+                int settles = lowersRate(&at, p->player, step.buy);
+                numRetrains = makeStep(&at, &step, retrains);
+                if (settles) {
+                    int n = 0;
+                    while (n < numRetrains) {
+                        addToPlan(plan, &replay, retrains[n]);
+                        n++;
+                    }
+                    n = 0;
+                    while (n < numBuys) {
+                        addToPlan(plan, &replay, buys[n]);
+                        n++;
+                    }
+                    numBuys = 0;
+                }
+                stage = step.stage;
+                steps++;
+            }
+        }
+
+        numRetrains = settle(&at, p->player, retrains);
+        int n = 0;
+        while (n < numRetrains) {
+            addToPlan(plan, &replay, retrains[n]);
+            n++;
+        }
+        n = 0;
+        while (n < numBuys) {
+            addToPlan(plan, &replay, buys[n]);
+            n++;
+        }
+    }
+    plan->positions = p->positions;
+}
+
+
+void planGameTurn (Planner p, Game g, turnPlan *plan) {
+    rolloutBoard board;
+    rollout r;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&r, &board, g, 0);
+    planTurn(p, &r, NULL, NULL, plan);
+}
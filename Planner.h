@@ -0,0 +1,78 @@
+/*
+ *  Planner.h - the best plan for the rest of a turn
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Within a turn a player can retrain, then build with what they
+ *  retrained, then retrain again, and a campus on a retraining centre
+ *  makes the retraining after it cheaper. Exchange rates only ever
+ *  fall during a turn, so the planner leaves retraining until a rate
+ *  is about to change, or the end, and only checks until then that
+ *  what the player owes can be paid. It searches a rollout (see
+ *  Rollout.h) over every campus the player could build, each with
+ *  every way of getting the ARCs out to it, then the spinoffs, GO8s
+ *  and other ARCs they could close the turn out with. Positions are
+ *  remembered by the students, where the player has built and their
+ *  spinoffs, since many orders of the same purchases end up in the
+ *  same place.
+ *
+ *  For KPI points that makes the plan as good as any order of moves,
+ *  which testPlanner.c checks against brute force. GO8s and the ARCs
+ *  that don't lead to a campus go on the lowest spots they can, and
+ *  nothing is retrained that isn't needed, so a score that cares
+ *  where those go or what students are left can miss a better plan.
+ *
+ *  A spinoff is scored as the chance of each outcome times the best
+ *  that can be done after it. Plans are scored by the KPI points the
+ *  player ends the turn with unless a different score is given.
+ *
+ *  Include Game.h, GameEngine.h and Rollout.h before this file.
+ */
+
+#ifndef PLANNER_H
+#define PLANNER_H
+
+// plans are cut off after this many moves
+#define MAX_PLAN_MOVES 64
+
+// how good the position in r is for player at the end of their turn.
+// data is passed through from planTurn() untouched
+typedef double (*planScore)(const rollout *r, int player, void *data);
+
+typedef struct _turnPlan {
+    // the moves to make in order, not counting the PASS at the end.
+    // The moves after a START_SPINOFF are the best ones if it becomes
+    // a publication, plan again after one that becomes an IP patent
+    int numMoves;
+    rolloutMove moves[MAX_PLAN_MOVES];
+
+    // the same moves as actions for a Game, with paths filled in
+    action actions[MAX_PLAN_MOVES];
+
+    // the score the plan expects to end the turn with (0 during Terra
+    // Nullis, when nobody can plan)
+    double score;
+
+    // how many positions the search worked out
+    int positions;
+} turnPlan;
+
+typedef struct _planner *Planner;
+
+// a planner keeps a table of the positions it has worked out, so make
+// one and reuse it for every plan
+Planner newPlanner (void);
+void disposePlanner (Planner p);
+
+// the default score: the player's KPI points
+double kpiScore (const rollout *r, int player, void *data);
+
+// plan the rest of the turn for whoever's turn it is in r. score may
+// be NULL for kpiScore()
+void planTurn (Planner p, const rollout *r, planScore score, void *data,
+        turnPlan *plan);
+
+// plan the rest of the turn for whoever's turn it is in g, by KPI
+void planGameTurn (Planner p, Game g, turnPlan *plan);
+
+#endif
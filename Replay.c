@@ -0,0 +1,329 @@
+/*
+ * Replay.c - recording a game so it can be played back
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * The events are kept in a growing array. Files are read a line at a
+ * time, and anything that isn't exactly what saveReplay() writes
+ * makes the whole file fail to load. See Replay.h
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Replay.h"
+
+
+// how many events a new replay has room for
+#define START_EVENTS 256
+
+// the longest line in a replay file: the board and dice lines, or an
+// action, with room for the newline and the 0
+#define MAX_LINE (MAX_ACTION_TEXT + 4 * NUM_REGIONS + 16)
+
+#define NO_DESTINATION "-"
+
+// parseAction() reads the destination into this much room, more than
+// any legal path needs (the width in its format has to match)
+#define DESTINATION_TEXT 256
+
+typedef struct _replay {
+    int discipline[NUM_REGIONS];
+    int dice[NUM_REGIONS];
+
+    int numEvents;
+    int capacity;
+    replayEvent *events;
+} replay;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// add an event to the end
+static void addEvent(replay *r, const replayEvent *event);
+
+// TRUE if the event can be made in g, where the last event left it
+static int canReplay(Game g, const replayEvent *event);
+
+// read NUM_REGIONS numbers from text into values, each from min to
+// max. returns FALSE if there aren't exactly that many
+static int parseRegions(const char *text, int values[], int min,
+        int max);
+
+// read a line of the file into line. returns FALSE at the end of the
+// file or if the line is too long
+static int readLine(FILE *file, char line[]);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static void addEvent(replay *r, const replayEvent *event) {
+    if (r->numEvents == r->capacity) {
+        r->capacity = 2 * r->capacity + START_EVENTS;
+        r->events = realloc(r->events,
+                r->capacity * sizeof(replayEvent));
+    }
+    r->events[r->numEvents] = *event;
+    r->numEvents++;
+}
+
+
+// Players can't ask for a publication or IP patent outright, so what
+// a spinoff became is legal wherever the spinoff would have been
+static int canReplay(Game g, const replayEvent *event) {
+    int legal = TRUE;
+    if (event->type == REPLAY_ROLL) {
+        legal = event->diceScore >= 2 && event->diceScore <= 12;
+    } else {
+        action a = event->a;
+        if (a.actionCode == OBTAIN_PUBLICATION
+                || a.actionCode == OBTAIN_IP_PATENT) {
+            a.actionCode = START_SPINOFF;
+        }
+        legal = (getTurnNumber(g) != -1) && isLegalAction(g, a);
+    }
+    return legal;
+}
+
+
+static int parseRegions(const char *text, int values[], int min,
+        int max) {
+    int valid = TRUE;
+    int region = 0;
+    while (region < NUM_REGIONS && valid) {
+        int used = 0;
+        valid = sscanf(text, "%d%n", &values[region], &used) == 1
+            && values[region] >= min && values[region] <= max;
+        text += used;
+        region++;
+    }
+    char extra;
+    return valid && sscanf(text, " %c", &extra) != 1;
+}
+
+
+static int readLine(FILE *file, char line[]) {
+    int read = fgets(line, MAX_LINE, file) != NULL;
+    if (read) {
+        size_t length = strlen(line);
+        if (length > 0 && line[length-1] == '\n') {
+            line[length-1] = 0;
+        } else if (!feof(file)) {
+            read = FALSE;
+        }
+    }
+    return read;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   REPLAY FUNCTIONS BEGIN
+// =====================================================================
+
+Replay newReplay (int discipline[], int dice[]) {
+    Replay r = malloc(sizeof(replay));
+    memset(r, 0, sizeof(replay));
+    memcpy(r->discipline, discipline, sizeof(r->discipline));
+    memcpy(r->dice, dice, sizeof(r->dice));
+    return r;
+}
+
+
+void disposeReplay (Replay r) {
+    free(r->events);
+    free(r);
+}
+
+
+void replayBoard (Replay r, int discipline[], int dice[]) {
+    memcpy(discipline, r->discipline, sizeof(r->discipline));
+    memcpy(dice, r->dice, sizeof(r->dice));
+}
+
+
+void recordThrow (Replay r, int diceScore) {
+    replayEvent event;
+    memset(&event, 0, sizeof(replayEvent));
+    event.type = REPLAY_ROLL;
+    event.diceScore = diceScore;
+    addEvent(r, &event);
+}
+
+
+void recordAction (Replay r, action a) {
+    replayEvent event;
+    memset(&event, 0, sizeof(replayEvent));
+    event.type = REPLAY_ACTION;
+    event.a = a;
+    addEvent(r, &event);
+}
+
+
+int replayLength (Replay r) {
+    return r->numEvents;
+}
+
+
+replayEvent replayEventAt (Replay r, int n) {
+    return r->events[n];
+}
+
+
+Game replayGame (Replay r, int numEvents) {
+    Game g = newGame(r->discipline, r->dice);
+    int n = 0;
+    while (n < numEvents && g != NULL) {
+        if (!replayStep(r, g, n)) {
+            disposeGame(g);
+            g = NULL;
+        }
+        n++;
+    }
+    return g;
+}
+
+
+int replayStep (Replay r, Game g, int n) {
+    const replayEvent *event = &r->events[n];
+    int legal = canReplay(g, event);
+    if (legal && event->type == REPLAY_ROLL) {
+        throwDice(g, event->diceScore);
+    } else if (legal) {
+        makeAction(g, event->a);
+    }
+    return legal;
+}
+
+
+int saveReplay (Replay r, const char *fileName) {
+    int saved = FALSE;
+    FILE *file = fopen(fileName, "w");
+    if (file != NULL) {
+        fprintf(file, "replay %d\nboard", REPLAY_VERSION);
+        int region = 0;
+        while (region < NUM_REGIONS) {
+            fprintf(file, " %d", r->discipline[region]);
+            region++;
+        }
+        fprintf(file, "\ndice");
+        region = 0;
+        while (region < NUM_REGIONS) {
+            fprintf(file, " %d", r->dice[region]);
+            region++;
+        }
+        fprintf(file, "\n");
+
+        int n = 0;
+        while (n < r->numEvents) {
+            const replayEvent *event = &r->events[n];
+            if (event->type == REPLAY_ROLL) {
+                fprintf(file, "roll %d\n", event->diceScore);
+            } else {
+                char text[MAX_ACTION_TEXT];
+                formatAction(event->a, text);
+                fprintf(file, "act %s\n", text);
+            }
+            n++;
+        }
+
+        saved = !ferror(file);
+        if (fclose(file) != 0) {
+            saved = FALSE;
+        }
+    }
+    return saved;
+}
+
+
+// Only the form of each line is checked here, whether the events
+// could really happen is up to replayGame()
+Replay loadReplay (const char *fileName) {
+    Replay r = NULL;
+    FILE *file = fopen(fileName, "r");
+    if (file != NULL) {
+        char line[MAX_LINE];
+        int version = 0;
+        int discipline[NUM_REGIONS];
+        int dice[NUM_REGIONS];
+        int valid = readLine(file, line)
+            && sscanf(line, "replay %d", &version) == 1
+            && version == REPLAY_VERSION
+            && readLine(file, line)
+            && strncmp(line, "board ", 6) == 0
+            && parseRegions(line + 6, discipline, STUDENT_THD,
+                    STUDENT_MMONEY)
+            && readLine(file, line)
+            && strncmp(line, "dice ", 5) == 0
+            && parseRegions(line + 5, dice, 2, 12);
+
+        if (valid) {
+            r = newReplay(discipline, dice);
+        }
+        while (valid && readLine(file, line)) {
+            int diceScore;
+            char extra;
+            action a;
+            if (sscanf(line, "roll %d %c", &diceScore, &extra) == 1) {
+                recordThrow(r, diceScore);
+            } else if (strncmp(line, "act ", 4) == 0
+                    && parseAction(line + 4, &a)) {
+                recordAction(r, a);
+            } else {
+                valid = FALSE;
+            }
+        }
+        if (!valid || ferror(file)) {
+            if (r != NULL) {
+                disposeReplay(r);
+            }
+            r = NULL;
+        }
+        fclose(file);
+    }
+    return r;
+}
+
+
+void formatAction (action a, char *text) {
+    const char *destination = a.destination;
+    if (destination[0] == 0) {
+        destination = NO_DESTINATION;
+    }
+    snprintf(text, MAX_ACTION_TEXT, "%d %s %d %d", a.actionCode,
+            destination, a.disciplineFrom, a.disciplineTo);
+}
+
+
+// The destination is read into more room than a path can take, so a
+// path that's too long is caught rather than cut short
+int parseAction (const char *text, action *a) {
+    memset(a, 0, sizeof(action));
+    char destination[DESTINATION_TEXT];
+    char extra;
+    int valid = sscanf(text, "%d %255s %d %d %c", &a->actionCode,
+            destination, &a->disciplineFrom, &a->disciplineTo,
+            &extra) == 4
+        && a->actionCode >= PASS && a->actionCode < NUM_ACTION_CODES
+        && a->disciplineFrom >= STUDENT_THD
+        && a->disciplineFrom <= STUDENT_MMONEY
+        && a->disciplineTo >= STUDENT_THD
+        && a->disciplineTo <= STUDENT_MMONEY;
+
+    if (valid && strcmp(destination, NO_DESTINATION) != 0) {
+        valid = strlen(destination) < PATH_LIMIT
+            && strspn(destination, "LRB") == strlen(destination);
+        if (valid) {
+            strcpy(a->destination, destination);
+        }
+    }
+    return valid;
+}
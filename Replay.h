@@ -0,0 +1,88 @@
+/*
+ *  Replay.h - recording a game so it can be played back
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  A replay is the board a game was played on and everything that
+ *  happened in it in order: each throw of the dice and each action. A
+ *  spinoff is recorded as the publication or IP patent it became, so
+ *  the game can be played back through makeAction() exactly as it
+ *  went. Whoever runs a game records it alongside throwDice() and
+ *  makeAction() (the game observer doesn't hear about every action).
+ *
+ *  Replay files are text, one event to a line, so they can be read
+ *  and written by other tools and checked by eye:
+ *
+ *      replay 1
+ *      board <the 19 disciplines given to newGame()>
+ *      dice <the 19 dice numbers given to newGame()>
+ *      roll <diceScore>
+ *      act <action>
+ *
+ *  with each action written as by formatAction().
+ *
+ *  Include Game.h before this file.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#define REPLAY_VERSION 1
+
+// the kinds of event
+#define REPLAY_ROLL 0
+#define REPLAY_ACTION 1
+
+typedef struct _replayEvent {
+    int type;
+
+    // the dice score of a REPLAY_ROLL, the action of a REPLAY_ACTION
+    int diceScore;
+    action a;
+} replayEvent;
+
+typedef struct _replay *Replay;
+
+// an empty replay of a game on the board given to newGame()
+Replay newReplay (int discipline[], int dice[]);
+void disposeReplay (Replay r);
+
+// copy out the board the game was played on
+void replayBoard (Replay r, int discipline[], int dice[]);
+
+// add the dice coming up diceScore, or the action a, to the end
+void recordThrow (Replay r, int diceScore);
+void recordAction (Replay r, action a);
+
+// how many events there are, and the nth of them from 0
+int replayLength (Replay r);
+replayEvent replayEventAt (Replay r, int n);
+
+// a new game with the first numEvents events played, or NULL if one
+// of them isn't legal where it was made
+Game replayGame (Replay r, int numEvents);
+
+// play the nth event in g, which has had the events before it played.
+// returns FALSE, leaving g alone, if it isn't legal there
+int replayStep (Replay r, Game g, int n);
+
+// write the replay to the file. returns FALSE if it couldn't
+int saveReplay (Replay r, const char *fileName);
+
+// read a replay saved by saveReplay(), or NULL if the file can't be
+// read or isn't a replay of this version
+Replay loadReplay (const char *fileName);
+
+// actions in replays (and elsewhere) are written as their code, their
+// destination ("-" for none) and the disciplines from and to, with
+// spaces between, eg "3 RL 0 0". The longest one takes this much room
+#define MAX_ACTION_TEXT (PATH_LIMIT + 32)
+
+// write a into text, which has room for MAX_ACTION_TEXT
+void formatAction (action a, char *text);
+
+// read an action written by formatAction() from the start of text.
+// returns FALSE if it isn't one
+int parseAction (const char *text, action *a);
+
+#endif
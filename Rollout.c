@@ -0,0 +1,747 @@
+/*
+ * Rollout.c - light copy of the game for random playouts
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Plays the same rules as Game.c, but on vertex/edge IDs and bitsets
+ * with no paths and no checking. See Rollout.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+
+
+#define DISCOUNT_EXCHANGE_RATE 2
+#define DEFAULT_EXCHANGE_RATE 3
+
+// the retraining choices for each discipline retrained from: any
+// discipline other than the one you started with
+#define RETRAIN_TARGETS (NUM_DISCIPLINES - 1)
+
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// put a campus/ARC on the board for player, keeping every set that
+// depends on it up to date. Doesn't touch students or KPI
+static void placeCampus(rollout *r, int player, int vertex);
+static void placeGO8(rollout *r, int player, int vertex);
+static void placeARC(rollout *r, int player, int edge);
+
+// TRUE if the player has the students for a fixed cost action
+static int canAfford(const rollout *r, int player, int actionCode);
+
+
+// the same prestige rules as awardPrestige() in Game.c
+static void rolloutPrestige(rollout *r, int player, int newCount,
+        int *holder, int *holderCount);
+static void rolloutPublicationPrestige(rollout *r, int player,
+        int newCount);
+
+// the position of the nth (from 0) set bit
+static int selectBit(uint64_t bits, int n);
+static int selectEdge(const edgeSet *set, int n);
+
+// start the rollout's random numbers from seed
+static void seedRandom(rollout *r, uint64_t seed);
+
+// the next random number, xorshift64*
+static uint64_t nextRandom(rollout *r);
+
+// a random number from 0 to n-1
+static int randomBelow(rollout *r, int n);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static void placeCampus(rollout *r, int player, int vertex) {
+    const boardGraph *graph = r->board->graph;
+    int i = player - 1;
+    r->campuses[i] |= VERTEX_BIT(vertex);
+    r->occupied |= VERTEX_BIT(vertex);
+    r->blocked |= graph->neighbourSet[vertex];
+    r->arcReach[i].bits[0] |= graph->vertexEdgeSet[vertex].bits[0];
+    r->arcReach[i].bits[1] |= graph->vertexEdgeSet[vertex].bits[1];
+}
+
+
+// the campus is already there, so nothing else changes
+static void placeGO8(rollout *r, int player, int vertex) {
+    r->campuses[player-1] &= ~VERTEX_BIT(vertex);
+    r->go8s[player-1] |= VERTEX_BIT(vertex);
+}
+
+
+static void placeARC(rollout *r, int player, int edge) {
+    const boardGraph *graph = r->board->graph;
+    int i = player - 1;
+    edgeSetAdd(&r->arcs[i], edge);
+    edgeSetAdd(&r->arcsTaken, edge);
+    r->arcEnds[i] |= graph->edgeEndSet[edge];
+
+    int end = 0;
+    while (end < 2) {
+        const edgeSet *touching
+            = &graph->vertexEdgeSet[graph->edgeEnds[edge][end]];
+        r->arcReach[i].bits[0] |= touching->bits[0];
+        r->arcReach[i].bits[1] |= touching->bits[1];
+        end++;
+    }
+}
+
+
+// a campus has to be next to one of the player's ARCs and can't be on
+// or next to any other campus (see isCampusConnected() and
+// campusBlocked in Game.c)
+static int canAfford(const rollout *r, int player, int actionCode) {
+    int enough = TRUE;
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        if (r->students[player-1][discipline]
+                < actionCosts[actionCode][discipline]) {
+            enough = FALSE;
+        }
+        discipline++;
+    }
+    return enough;
+}
+
+
+// The holder keeps the award and just records their new count,
+// anyone else takes it (and the bonus) with strictly more
+static void rolloutPrestige(rollout *r, int player, int newCount,
+        int *holder, int *holderCount) {
+    if (*holder == player) {
+        *holderCount = newCount;
+    } else if (newCount > *holderCount) {
+        if (*holder != NO_ONE) {
+            r->kpi[*holder-1] -= PRESTIGE_BONUS;
+        }
+        r->kpi[player-1] += PRESTIGE_BONUS;
+        *holder = player;
+        *holderCount = newCount;
+    }
+}
+
+
+// The holder gets the bonus again for each publication past their own
+// count, like awardPublicationPrestige() in Game.c
+static void rolloutPublicationPrestige(rollout *r, int player,
+        int newCount) {
+    if (newCount > r->mostPubsCount) {
+        if (r->mostPubs != NO_ONE && r->mostPubs != player) {
+            r->kpi[r->mostPubs-1] -= PRESTIGE_BONUS;
+        }
+        r->kpi[player-1] += PRESTIGE_BONUS;
+        r->mostPubs = player;
+        r->mostPubsCount = newCount;
+    }
+}
+
+
+// narrow down to the right byte by halves, then step through it
+static int selectBit(uint64_t bits, int n) {
+    int base = 0;
+    int width = 32;
+    while (width >= 8) {
+        uint64_t low = bits & (((uint64_t)1 << width) - 1);
+        int count = __builtin_popcountll(low);
+        if (n >= count) {
+            n -= count;
+            bits >>= width;
+            base += width;
+        } else {
+            bits = low;
+        }
+        width /= 2;
+    }
+    while (n > 0) {
+        bits &= bits - 1;
+        n--;
+    }
+    return base + __builtin_ctzll(bits);
+}
+
+
+static int selectEdge(const edgeSet *set, int n) {
+    int edge;
+    int lowCount = __builtin_popcountll(set->bits[0]);
+    if (n < lowCount) {
+        edge = selectBit(set->bits[0], n);
+    } else {
+        edge = 64 + selectBit(set->bits[1], n - lowCount);
+    }
+    return edge;
+}
+
+
+// xorshift gets stuck on 0
+static void seedRandom(rollout *r, uint64_t seed) {
+    r->rng = seed ^ 0x9E3779B97F4A7C15ULL;
+    if (r->rng == 0) {
+        r->rng = 1;
+    }
+}
+
+
+static uint64_t nextRandom(rollout *r) {
+    r->rng ^= r->rng >> 12;
+    r->rng ^= r->rng << 25;
+    r->rng ^= r->rng >> 27;
+    return r->rng * 2685821657736338717ULL;
+}
+
+
+// scale the top 32 bits rather than using % so every number is
+// (near enough) equally likely
+static int randomBelow(rollout *r, int n) {
+    uint64_t top = nextRandom(r) >> 32;
+    return (int)((top * (uint64_t)n) >> 32);
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   ROLLOUT FUNCTIONS BEGIN
+// =====================================================================
+
+// group the regions by dice score and find the vertices around each
+void rolloutBoardFromGame (rolloutBoard *board, Game g) {
+    const boardGraph *graph = getBoardGraph();
+    memset(board, 0, sizeof(rolloutBoard));
+    board->graph = graph;
+
+    int region = 0;
+    while (region < NUM_REGIONS) {
+        int score = getDiceValue(g, region);
+        vertexSet around = 0;
+        int v = 0;
+        while (v < NUM_VERTICES) {
+            if (graph->vertexRegions[v][0] == region
+                    || graph->vertexRegions[v][1] == region
+                    || graph->vertexRegions[v][2] == region) {
+                around |= VERTEX_BIT(v);
+            }
+            v++;
+        }
+
+        if (score >= 2 && score <= 12) {
+            int n = board->numProducing[score];
+            board->producingVertices[score][n] = around;
+            board->producingDiscipline[score][n]
+                = getDiscipline(g, region);
+            board->numProducing[score]++;
+        }
+        region++;
+    }
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        if (graph->vertexRetrain[v] != -1) {
+            board->retrainVertices[graph->vertexRetrain[v]]
+                |= VERTEX_BIT(v);
+        }
+        v++;
+    }
+}
+
+
+// rebuild the sets from what is on each vertex and edge, then copy
+// the numbers across
+void rolloutFromGame (rollout *r, const rolloutBoard *board, Game g,
+        uint64_t seed) {
+    memset(r, 0, sizeof(rollout));
+    r->board = board;
+    r->turnNumber = getTurnNumber(g);
+
+    seedRandom(r, seed);
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        int contents = getCampusAt(g, v);
+        if (contents >= CAMPUS_A && contents <= CAMPUS_C) {
+            placeCampus(r, contents - CAMPUS_A + UNI_A, v);
+        } else if (contents >= GO8_A && contents <= GO8_C) {
+            placeCampus(r, contents - GO8_A + UNI_A, v);
+            placeGO8(r, contents - GO8_A + UNI_A, v);
+        }
+        v++;
+    }
+
+    int e = 0;
+    while (e < NUM_EDGES) {
+        int contents = getARCAt(g, e);
+        if (contents != VACANT_ARC) {
+            placeARC(r, contents - ARC_A + UNI_A, e);
+        }
+        e++;
+    }
+
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        int i = player - 1;
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            r->students[i][discipline]
+                = getStudentsFast(g, player, discipline);
+            discipline++;
+        }
+        r->kpi[i] = getKPIpointsFast(g, player);
+        r->numARCs[i] = getARCs(g, player);
+        r->numCampuses[i] = getCampuses(g, player);
+        r->numGO8s[i] = getGO8s(g, player);
+        r->numIPs[i] = getIPs(g, player);
+        r->numPubs[i] = getPublications(g, player);
+        player++;
+    }
+
+    // counts only go up, so the holder's count is still the one they
+    // took the award with
+    r->mostARCs = getMostARCs(g);
+    if (r->mostARCs != NO_ONE) {
+        r->mostARCsCount = r->numARCs[r->mostARCs-1];
+    }
+    r->mostPubs = getMostPublications(g);
+    if (r->mostPubs != NO_ONE) {
+        r->mostPubsCount = r->numPubs[r->mostPubs-1];
+    }
+}
+
+
+int rolloutWhoseTurn (const rollout *r) {
+    int player = NO_ONE;
+    if (r->turnNumber != -1) {
+        player = r->turnNumber % NUM_UNIS + 1;
+    }
+    return player;
+}
+
+
+int rolloutExchangeRate (const rollout *r, int player,
+        int disciplineFrom) {
+    vertexSet owned = r->campuses[player-1] | r->go8s[player-1];
+    int rate = DEFAULT_EXCHANGE_RATE;
+    if (owned & r->board->retrainVertices[disciplineFrom]) {
+        rate = DISCOUNT_EXCHANGE_RATE;
+    }
+    return rate;
+}
+
+
+vertexSet rolloutCampusSpots (const rollout *r, int player) {
+    return r->arcEnds[player-1] & ~(r->occupied | r->blocked);
+}
+
+
+// an ARC has to touch one of the player's ARCs, campuses or GO8s
+// (see isARCConnected() in Game.c)
+edgeSet rolloutARCSpots (const rollout *r, int player) {
+    edgeSet spots;
+    spots.bits[0] = r->arcReach[player-1].bits[0]
+        & ~r->arcsTaken.bits[0];
+    spots.bits[1] = r->arcReach[player-1].bits[1]
+        & ~r->arcsTaken.bits[1];
+    return spots;
+}
+
+
+// PASS, then each kind of move the player can pay for
+int rolloutCountMoves (const rollout *r) {
+    int player = rolloutWhoseTurn(r);
+    int count = 1;
+
+    if (player != NO_ONE) {
+        if (canAfford(r, player, BUILD_CAMPUS)) {
+            count += __builtin_popcountll(rolloutCampusSpots(r, player));
+        }
+        if (canAfford(r, player, BUILD_GO8)) {
+            count += __builtin_popcountll(r->campuses[player-1]);
+        }
+        if (canAfford(r, player, OBTAIN_ARC)) {
+            edgeSet spots = rolloutARCSpots(r, player);
+            count += edgeSetCount(&spots);
+        }
+        if (canAfford(r, player, START_SPINOFF)) {
+            count++;
+        }
+        int from = STUDENT_BPS;
+        while (from <= STUDENT_MMONEY) {
+            if (r->students[player-1][from]
+                    >= rolloutExchangeRate(r, player, from)) {
+                count += RETRAIN_TARGETS;
+            }
+            from++;
+        }
+    }
+
+    return count;
+}
+
+
+// Number the moves the same way rolloutCountMoves() counts them, pick
+// a number, then walk down the kinds of move until it lands in one.
+// Each kind is a set, so finding the move in it is a bit select
+rolloutMove rolloutRandomMove (rollout *r) {
+    int player = rolloutWhoseTurn(r);
+    rolloutMove move = {.actionCode = PASS, .target = -1,
+        .disciplineFrom = -1, .disciplineTo = -1};
+
+    int n = randomBelow(r, rolloutCountMoves(r)) - 1;
+    if (n >= 0 && canAfford(r, player, BUILD_CAMPUS)) {
+        vertexSet spots = rolloutCampusSpots(r, player);
+        int count = __builtin_popcountll(spots);
+        if (n < count) {
+            move.actionCode = BUILD_CAMPUS;
+            move.target = selectBit(spots, n);
+        }
+        n -= count;
+    }
+    if (n >= 0 && canAfford(r, player, BUILD_GO8)) {
+        int count = __builtin_popcountll(r->campuses[player-1]);
+        if (n < count) {
+            move.actionCode = BUILD_GO8;
+            move.target = selectBit(r->campuses[player-1], n);
+        }
+        n -= count;
+    }
+    if (n >= 0 && canAfford(r, player, OBTAIN_ARC)) {
+        edgeSet spots = rolloutARCSpots(r, player);
+        int count = edgeSetCount(&spots);
+        if (n < count) {
+            move.actionCode = OBTAIN_ARC;
+            move.target = selectEdge(&spots, n);
+        }
+        n -= count;
+    }
+    if (n >= 0 && canAfford(r, player, START_SPINOFF)) {
+        if (n == 0) {
+            move.actionCode = START_SPINOFF;
+        }
+        n--;
+    }
+    int from = STUDENT_BPS;
+    while (n >= 0 && from <= STUDENT_MMONEY) {
+        if (r->students[player-1][from]
+                >= rolloutExchangeRate(r, player, from)) {
+            if (n < RETRAIN_TARGETS) {
+                move.actionCode = RETRAIN_STUDENTS;
+                move.disciplineFrom = from;
+                // skip over retraining to the same discipline
+                move.disciplineTo = n < from ? n : n + 1;
+            }
+            n -= RETRAIN_TARGETS;
+        }
+        from++;
+    }
+
+    return move;
+}
+
+
+int rolloutListMoves (const rollout *r, rolloutMove moves[]) {
+    int player = rolloutWhoseTurn(r);
+    rolloutMove move = {.actionCode = PASS, .target = -1,
+        .disciplineFrom = -1, .disciplineTo = -1};
+    moves[0] = move;
+    int count = 1;
+
+    if (player != NO_ONE) {
+        if (canAfford(r, player, BUILD_CAMPUS)) {
+            vertexSet spots = rolloutCampusSpots(r, player);
+            move.actionCode = BUILD_CAMPUS;
+            move.target = popVertex(&spots);
+            while (move.target != NO_VERTEX) {
+                moves[count] = move;
+                count++;
+                move.target = popVertex(&spots);
+            }
+        }
+        if (canAfford(r, player, BUILD_GO8)) {
+            vertexSet spots = r->campuses[player-1];
+            move.actionCode = BUILD_GO8;
+            move.target = popVertex(&spots);
+            while (move.target != NO_VERTEX) {
+                moves[count] = move;
+                count++;
+                move.target = popVertex(&spots);
+            }
+        }
+        if (canAfford(r, player, OBTAIN_ARC)) {
+            edgeSet spots = rolloutARCSpots(r, player);
+            move.actionCode = OBTAIN_ARC;
+            move.target = popEdge(&spots);
+            while (move.target != NO_EDGE) {
+                moves[count] = move;
+                count++;
+                move.target = popEdge(&spots);
+            }
+        }
+        move.target = -1;
+        if (canAfford(r, player, START_SPINOFF)) {
+            move.actionCode = START_SPINOFF;
+            moves[count] = move;
+            count++;
+        }
+        move.actionCode = RETRAIN_STUDENTS;
+        int from = STUDENT_BPS;
+        while (from <= STUDENT_MMONEY) {
+            if (r->students[player-1][from]
+                    >= rolloutExchangeRate(r, player, from)) {
+                move.disciplineFrom = from;
+                int to = 0;
+                while (to < NUM_DISCIPLINES) {
+                    if (to != from) {
+                        move.disciplineTo = to;
+                        moves[count] = move;
+                        count++;
+                    }
+                    to++;
+                }
+            }
+            from++;
+        }
+    }
+
+    return count;
+}
+
+
+// same as makeAction() in Game.c
+void rolloutMakeMove (rollout *r, rolloutMove *move) {
+    int player = rolloutWhoseTurn(r);
+    int i = player - 1;
+    int code = move->actionCode;
+
+    if (code == START_SPINOFF) {
+        if (randomBelow(r, IP_PATENT_ODDS) == 0) {
+            code = OBTAIN_IP_PATENT;
+        } else {
+            code = OBTAIN_PUBLICATION;
+        }
+        move->actionCode = code;
+    }
+
+    if (code == RETRAIN_STUDENTS) {
+        r->students[i][move->disciplineFrom]
+            -= rolloutExchangeRate(r, player, move->disciplineFrom);
+        r->students[i][move->disciplineTo]++;
+    } else {
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            r->students[i][discipline] -= actionCosts[code][discipline];
+            discipline++;
+        }
+    }
+
+    if (code == BUILD_CAMPUS) {
+        placeCampus(r, player, move->target);
+        r->numCampuses[i]++;
+        r->kpi[i] += CAMPUS_KPI;
+    } else if (code == BUILD_GO8) {
+        placeGO8(r, player, move->target);
+        r->numCampuses[i]--;
+        r->numGO8s[i]++;
+        r->kpi[i] += GO8_KPI - CAMPUS_KPI;
+    } else if (code == OBTAIN_ARC) {
+        placeARC(r, player, move->target);
+        r->numARCs[i]++;
+        r->kpi[i] += ARC_KPI;
+        rolloutPrestige(r, player, r->numARCs[i], &r->mostARCs,
+                &r->mostARCsCount);
+    } else if (code == OBTAIN_PUBLICATION) {
+        r->numPubs[i]++;
+        rolloutPublicationPrestige(r, player, r->numPubs[i]);
+    } else if (code == OBTAIN_IP_PATENT) {
+        r->numIPs[i]++;
+        r->kpi[i] += IP_KPI;
+    }
+}
+
+
+// same as throwDice() in Game.c: a campus gets one student from each
+// region it touches, a GO8 two, then a 7 turns MTVs and MMONEYs into
+// THDs
+void rolloutThrowDice (rollout *r, int diceScore) {
+    const rolloutBoard *board = r->board;
+    r->turnNumber++;
+
+    int region = 0;
+    while (region < board->numProducing[diceScore]) {
+        vertexSet around = board->producingVertices[diceScore][region];
+        int discipline = board->producingDiscipline[diceScore][region];
+        int i = 0;
+        while (i < NUM_UNIS) {
+            r->students[i][discipline]
+                += __builtin_popcountll(r->campuses[i] & around)
+                + 2 * __builtin_popcountll(r->go8s[i] & around);
+            i++;
+        }
+        region++;
+    }
+
+    if (diceScore == 7) {
+        int i = 0;
+        while (i < NUM_UNIS) {
+            r->students[i][STUDENT_THD] += r->students[i][STUDENT_MTV]
+                + r->students[i][STUDENT_MMONEY];
+            r->students[i][STUDENT_MTV] = 0;
+            r->students[i][STUDENT_MMONEY] = 0;
+            i++;
+        }
+    }
+}
+
+
+int rolloutRollDice (rollout *r) {
+    return randomBelow(r, 6) + randomBelow(r, 6) + 2;
+}
+
+
+// each player keeps making random moves until they pick PASS
+int rolloutPlayout (rollout *r, int maxTurns) {
+    int winner = NO_ONE;
+    int turns = 0;
+    if (r->turnNumber == -1) {
+        rolloutThrowDice(r, rolloutRollDice(r));
+    }
+
+    while (winner == NO_ONE && turns < maxTurns) {
+        int player = rolloutWhoseTurn(r);
+        rolloutMove move = rolloutRandomMove(r);
+        if (move.actionCode == PASS) {
+            rolloutThrowDice(r, rolloutRollDice(r));
+            turns++;
+        } else {
+            rolloutMakeMove(r, &move);
+            if (r->kpi[player-1] >= WINNING_KPI) {
+                winner = player;
+            }
+        }
+    }
+
+    return winner;
+}
+
+
+action rolloutMoveToAction (const rollout *r, const rolloutMove *move) {
+    action a;
+    memset(&a, 0, sizeof(action));
+    a.actionCode = move->actionCode;
+
+    if (move->actionCode == BUILD_CAMPUS
+            || move->actionCode == BUILD_GO8) {
+        strcpy(a.destination, pathOfVertex(move->target));
+    } else if (move->actionCode == OBTAIN_ARC) {
+        strcpy(a.destination, pathOfEdge(move->target));
+    } else if (move->actionCode == RETRAIN_STUDENTS) {
+        a.disciplineFrom = move->disciplineFrom;
+        a.disciplineTo = move->disciplineTo;
+    }
+
+    return a;
+}
+
+
+void rolloutPack (const rollout *r, packedPosition *p) {
+    memset(p, 0, sizeof(packedPosition));
+    p->turnNumber = r->turnNumber;
+    p->mostARCs = r->mostARCs;
+    p->mostPubs = r->mostPubs;
+
+    int i = 0;
+    while (i < NUM_UNIS) {
+        p->kpi[i] = r->kpi[i];
+        p->numIPs[i] = r->numIPs[i];
+        p->numPubs[i] = r->numPubs[i];
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            p->students[i][discipline] = r->students[i][discipline];
+            discipline++;
+        }
+
+        int v = 0;
+        while (v < NUM_VERTICES) {
+            int contents = VACANT_VERTEX;
+            if (r->campuses[i] & VERTEX_BIT(v)) {
+                contents = CAMPUS_A + i;
+            } else if (r->go8s[i] & VERTEX_BIT(v)) {
+                contents = GO8_A + i;
+            }
+            p->vertices[v / 2] |= contents << (4 * (v % 2));
+            v++;
+        }
+        int e = 0;
+        while (e < NUM_EDGES) {
+            if (edgeSetHas(&r->arcs[i], e)) {
+                p->edges[e / 4] |= (ARC_A + i) << (2 * (e % 4));
+            }
+            e++;
+        }
+        i++;
+    }
+}
+
+
+// The board is put back the way rolloutFromGame() does it, and the
+// counts are read off the board
+void rolloutUnpack (rollout *r, const rolloutBoard *board,
+        const packedPosition *p, uint64_t seed) {
+    memset(r, 0, sizeof(rollout));
+    r->board = board;
+    r->turnNumber = p->turnNumber;
+    seedRandom(r, seed);
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        int contents = (p->vertices[v / 2] >> (4 * (v % 2))) & 0xF;
+        if (contents >= CAMPUS_A && contents <= CAMPUS_C) {
+            placeCampus(r, contents - CAMPUS_A + UNI_A, v);
+        } else if (contents >= GO8_A && contents <= GO8_C) {
+            placeCampus(r, contents - GO8_A + UNI_A, v);
+            placeGO8(r, contents - GO8_A + UNI_A, v);
+        }
+        v++;
+    }
+    int e = 0;
+    while (e < NUM_EDGES) {
+        int contents = (p->edges[e / 4] >> (2 * (e % 4))) & 0x3;
+        if (contents != VACANT_ARC) {
+            placeARC(r, contents - ARC_A + UNI_A, e);
+        }
+        e++;
+    }
+
+    int i = 0;
+    while (i < NUM_UNIS) {
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            r->students[i][discipline] = p->students[i][discipline];
+            discipline++;
+        }
+        r->kpi[i] = p->kpi[i];
+        r->numARCs[i] = edgeSetCount(&r->arcs[i]);
+        r->numCampuses[i] = __builtin_popcountll(r->campuses[i]);
+        r->numGO8s[i] = __builtin_popcountll(r->go8s[i]);
+        r->numIPs[i] = p->numIPs[i];
+        r->numPubs[i] = p->numPubs[i];
+        i++;
+    }
+
+    r->mostARCs = p->mostARCs;
+    if (r->mostARCs != NO_ONE) {
+        r->mostARCsCount = r->numARCs[r->mostARCs-1];
+    }
+    r->mostPubs = p->mostPubs;
+    if (r->mostPubs != NO_ONE) {
+        r->mostPubsCount = r->numPubs[r->mostPubs-1];
+    }
+}
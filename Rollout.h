@@ -0,0 +1,184 @@
+/*
+ *  Rollout.h - a light copy of the game for random playouts
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Playing random games through Game.h spends nearly all its time
+ *  building path strings and walking them. A rollout keeps only what
+ *  the rules need, with every vertex and edge as its integer ID (see
+ *  GameEngine.h) and every set of them as a bitset, so the legal moves
+ *  are a few ANDs away and a random one can be picked without trying
+ *  them all.
+ *
+ *  The rules are the same as Game.c's and testRollout.c plays seeded
+ *  games through both to keep it that way. Nothing in here is checked,
+ *  only ever hand it moves that came out of rolloutRandomMove() (or
+ *  are otherwise known to be legal).
+ *
+ *  Include Game.h and GameEngine.h before this file.
+ */
+
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+#include <stdint.h>
+
+// what the board produces on each dice score. Only depends on the
+// layout, so one of these is shared by every rollout of a game
+typedef struct _rolloutBoard {
+    // the regions which produce on each score: the vertices around
+    // each of them and the discipline it produces
+    int numProducing[NUM_DICE_SCORES];
+    vertexSet producingVertices[NUM_DICE_SCORES][NUM_REGIONS];
+    int producingDiscipline[NUM_DICE_SCORES][NUM_REGIONS];
+
+    // the vertices with a retraining centre for each discipline
+    vertexSet retrainVertices[NUM_DISCIPLINES];
+
+    const boardGraph *graph;
+} rolloutBoard;
+
+// one move in a rollout. target is the vertex ID for BUILD_CAMPUS and
+// BUILD_GO8 and the edge ID for OBTAIN_ARC, the disciplines are only
+// used by RETRAIN_STUDENTS
+typedef struct _rolloutMove {
+    int actionCode;
+    int target;
+    int disciplineFrom;
+    int disciplineTo;
+} rolloutMove;
+
+// the game being played out. Players are indexed player-1 like Game.c
+typedef struct _rollout {
+    const rolloutBoard *board;
+    int turnNumber;
+
+    int students[NUM_UNIS][NUM_DISCIPLINES];
+    int kpi[NUM_UNIS];
+    int numARCs[NUM_UNIS];
+    int numCampuses[NUM_UNIS];
+    int numGO8s[NUM_UNIS];
+    int numIPs[NUM_UNIS];
+    int numPubs[NUM_UNIS];
+
+    // prestige holders and the count they got it with, as in Game.c
+    int mostARCs;
+    int mostARCsCount;
+    int mostPubs;
+    int mostPubsCount;
+
+    // what is on the board
+    vertexSet campuses[NUM_UNIS];
+    vertexSet go8s[NUM_UNIS];
+    edgeSet arcs[NUM_UNIS];
+
+    // every vertex with a campus or GO8, and every vertex next to one
+    // (nobody may build on either)
+    vertexSet occupied;
+    vertexSet blocked;
+    edgeSet arcsTaken;
+
+    // the vertices at the ends of each uni's ARCs (where it may build
+    // campuses) and the edges touching its ARCs and campuses (where it
+    // may build ARCs). Both are only ever added to
+    vertexSet arcEnds[NUM_UNIS];
+    edgeSet arcReach[NUM_UNIS];
+
+    // xorshift state for the dice and spinoffs
+    uint64_t rng;
+} rollout;
+
+// work out what the board in g produces
+void rolloutBoardFromGame (rolloutBoard *board, Game g);
+
+// copy the game g into r so it can be played out. seed picks the dice
+// and moves, the same seed plays out the same way
+void rolloutFromGame (rollout *r, const rolloutBoard *board, Game g,
+        uint64_t seed);
+
+// whose turn it is, NO_ONE during Terra Nullis
+int rolloutWhoseTurn (const rollout *r);
+
+// how many students of disciplineFrom it takes the player to retrain
+// to one of another discipline
+int rolloutExchangeRate (const rollout *r, int player,
+        int disciplineFrom);
+
+// the places the player could build a campus or an ARC right now,
+// whether or not they can pay for it
+vertexSet rolloutCampusSpots (const rollout *r, int player);
+edgeSet rolloutARCSpots (const rollout *r, int player);
+
+// how many moves the current player may make right now, counting
+// PASS. Retraining to the discipline you started with isn't counted
+int rolloutCountMoves (const rollout *r);
+
+// pick one of the current player's legal moves, all equally likely
+rolloutMove rolloutRandomMove (rollout *r);
+
+// the most moves a player can have at once: PASS, a campus or GO8 on
+// every vertex, an ARC on every edge, a spinoff and every retraining
+#define MAX_ROLLOUT_MOVES (2 + 2 * NUM_VERTICES + NUM_EDGES \
+        + (NUM_DISCIPLINES - 1) * (NUM_DISCIPLINES - 1))
+
+// fill moves[] with every move rolloutCountMoves() counts, in the
+// order rolloutRandomMove() numbers them (PASS first). returns how
+// many there are
+int rolloutListMoves (const rollout *r, rolloutMove moves[]);
+
+// make a legal move for the current player. A START_SPINOFF is turned
+// into a publication or IP patent here (1 in IP_PATENT_ODDS is an IP)
+// and move->actionCode says which it was. PASS does nothing, throw
+// the dice to end the turn
+void rolloutMakeMove (rollout *r, rolloutMove *move);
+
+// the dice came up diceScore, move on to the next turn
+void rolloutThrowDice (rollout *r, int diceScore);
+
+// roll two dice from the rollout's random numbers
+int rolloutRollDice (rollout *r);
+
+// play random moves and dice until someone has WINNING_KPI or
+// maxTurns more turns have gone. returns the winner or NO_ONE
+int rolloutPlayout (rollout *r, int maxTurns);
+
+// the Game.h action for a move, with a shortest path to its target
+action rolloutMoveToAction (const rollout *r, const rolloutMove *move);
+
+// =====================================================================
+//   PACKED POSITIONS
+// =====================================================================
+
+// A rollout packed down to PACKED_POSITION_BYTES, for keeping millions
+// of positions (see SelfPlay.h). Everything that follows from what is
+// on the board is left out and worked out again when it's unpacked,
+// and so is the board itself, which has to be kept alongside
+#define PACKED_VERTEX_BYTES ((NUM_VERTICES + 1) / 2)
+#define PACKED_EDGE_BYTES ((NUM_EDGES + 3) / 4)
+#define PACKED_POSITION_BYTES 104
+
+typedef struct _packedPosition {
+    int16_t turnNumber;
+    uint8_t mostARCs;
+    uint8_t mostPubs;
+    uint16_t kpi[NUM_UNIS];
+    uint16_t numIPs[NUM_UNIS];
+    uint16_t numPubs[NUM_UNIS];
+    uint16_t students[NUM_UNIS][NUM_DISCIPLINES];
+
+    // each vertex's contents (as getCampusAt()) in 4 bits, and each
+    // edge's (as getARCAt()) in 2, the lowest bits first
+    uint8_t vertices[PACKED_VERTEX_BYTES];
+    uint8_t edges[PACKED_EDGE_BYTES];
+} packedPosition;
+
+// pack r into p
+void rolloutPack (const rollout *r, packedPosition *p);
+
+// unpack p into r, which is then the same as the rollout it was packed
+// from except for its random numbers, which come from seed as they do
+// for rolloutFromGame()
+void rolloutUnpack (rollout *r, const rolloutBoard *board,
+        const packedPosition *p, uint64_t seed);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Routes.c - planning ARC routes across the board
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Every ARC costs the same, so the cheapest route is the one with the
+ * fewest ARCs and a breadth first search over the vertices finds it.
+ * See Routes.h
+ */
+
+
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Routes.h"
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// Search out from every vertex on the player's network at once,
+// filling in the ARCs to each vertex and the edge each was reached
+// along (NO_EDGE for the network itself). Stops early once target is
+// reached, or searches the whole board if target is NO_VERTEX
+static void searchRoutes(Game g, int player, int target,
+        int distance[], int reachedBy[]);
+
+// TRUE if nobody has a campus on or next to the vertex
+static int isCampusSpot(Game g, const boardGraph *graph, int vertex);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+// The player's own ARCs join vertices which are all on its network, so
+// they are free without treating them specially. Other unis' ARCs are
+// never crossed and every free edge is one more ARC
+static void searchRoutes(Game g, int player, int target,
+        int distance[], int reachedBy[]) {
+    const boardGraph *graph = getBoardGraph();
+    int queue[NUM_VERTICES];
+    int head = 0;
+    int tail = 0;
+
+    vertexSet network = getNetwork(g, player);
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        distance[v] = NO_ROUTE;
+        reachedBy[v] = NO_EDGE;
+        if (network & VERTEX_BIT(v)) {
+            distance[v] = 0;
+            queue[tail] = v;
+            tail++;
+        }
+        v++;
+    }
+
+    while (head < tail && (target == NO_VERTEX
+                || distance[target] == NO_ROUTE)) {
+        v = queue[head];
+        head++;
+        int i = 0;
+        while (i < 3) {
+            int next = graph->vertexNeighbours[v][i];
+            int edge = graph->vertexEdges[v][i];
+            if (next != NO_VERTEX && distance[next] == NO_ROUTE
+                    && getARCAt(g, edge) == VACANT_ARC) {
+                distance[next] = distance[v] + 1;
+                reachedBy[next] = edge;
+                queue[tail] = next;
+                tail++;
+            }
+            i++;
+        }
+    }
+}
+
+
+static int isCampusSpot(Game g, const boardGraph *graph, int vertex) {
+    int free = (getCampusAt(g, vertex) == VACANT_VERTEX);
+    int i = 0;
+    while (i < 3) {
+        int next = graph->vertexNeighbours[vertex][i];
+        if (next != NO_VERTEX && getCampusAt(g, next) != VACANT_VERTEX) {
+            free = FALSE;
+        }
+        i++;
+    }
+    return free;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   ROUTE FUNCTIONS BEGIN
+// =====================================================================
+
+// walk back along the edges each vertex was reached by, then turn the
+// list around so it starts at the network
+int planARCRoute (Game g, int player, int vertex, arcRoute *route) {
+    const boardGraph *graph = getBoardGraph();
+    int distance[NUM_VERTICES];
+    int reachedBy[NUM_VERTICES];
+    searchRoutes(g, player, vertex, distance, reachedBy);
+
+    memset(route, 0, sizeof(arcRoute));
+    if (distance[vertex] != NO_ROUTE) {
+        route->numARCs = distance[vertex];
+        int at = vertex;
+        int i = route->numARCs - 1;
+        while (i >= 0) {
+            int edge = reachedBy[at];
+            route->edges[i] = edge;
+            if (graph->edgeEnds[edge][0] == at) {
+                at = graph->edgeEnds[edge][1];
+            } else {
+                at = graph->edgeEnds[edge][0];
+            }
+            i--;
+        }
+
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            route->students[discipline] = route->numARCs
+                * actionCosts[OBTAIN_ARC][discipline];
+            discipline++;
+        }
+        route->campusSpot = isCampusSpot(g, graph, vertex);
+    }
+
+    return distance[vertex];
+}
+
+
+void getARCDistances (Game g, int player, int distance[NUM_VERTICES]) {
+    int reachedBy[NUM_VERTICES];
+    searchRoutes(g, player, NO_VERTEX, distance, reachedBy);
+}
@@ -0,0 +1,45 @@
+/*
+ *  Routes.h - planning ARC routes across the board
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  How many ARCs (and which ones) a uni needs to get from its network
+ *  out to a vertex. A route can only go along free edges and the uni's
+ *  own ARCs, never another uni's ARC. Like isLegalAction(), a route
+ *  may run past another uni's campus, but a campus can't then be built
+ *  at the end of it if the vertex is on or next to a campus.
+ *
+ *  Include Game.h and GameEngine.h before this file.
+ */
+
+#ifndef ROUTES_H
+#define ROUTES_H
+
+// a vertex the uni can't reach at all
+#define NO_ROUTE -1
+
+// the ARCs to get from a uni's network to a vertex, see planARCRoute()
+typedef struct _arcRoute {
+    // how many ARCs, and their edge IDs in the order to build them (so
+    // each is legal once the ones before it are built)
+    int numARCs;
+    int edges[NUM_EDGES];
+
+    // the students all those ARCs cost
+    int students[NUM_DISCIPLINES];
+
+    // TRUE if a campus could go at the end once the ARCs are built
+    int campusSpot;
+} arcRoute;
+
+// find a route with the fewest ARCs from the player's network to the
+// vertex. returns the number of ARCs (0 if it is already on the
+// network) or NO_ROUTE if other unis' ARCs cut it off, in which case
+// route has 0 ARCs
+int planARCRoute (Game g, int player, int vertex, arcRoute *route);
+
+// the fewest ARCs from the player's network to every vertex at once,
+// NO_ROUTE where it can't get to
+void getARCDistances (Game g, int player, int distance[NUM_VERTICES]);
+
+#endif
@@ -0,0 +1,449 @@
+/*
+ * Search.c - searching for as long as there is time, and how long
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Iterative deepening over the player's macro actions: each depth is
+ * a depth first search of every sequence of at most that many, with
+ * the search giving up wherever it is when the clock runs out. See
+ * Search.h
+ */
+
+
+// for clock_gettime() and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+#include "Forecast.h"
+#include "Endgame.h"
+#include "Macro.h"
+#include "Search.h"
+
+
+#define NANOSECONDS 1e9
+
+// the sum of a uni's students that STUDENTS_PER_ACTION counts, which
+// leaves out THD since it can't be spent
+#define FIRST_SPENDABLE STUDENT_BPS
+
+// allotTime() hasn't been asked about any turn yet
+#define NO_TURN -2
+
+
+typedef struct _search {
+    struct timespec start;
+    double seconds;
+    long nodes;
+
+    // only look at the clock once the first depth is done, and stop as
+    // soon as it says time is up
+    int checkClock;
+    int outOfTime;
+
+    // TRUE if a position at the bottom of the depth could have gone on
+    int cutOff;
+
+    int player;
+} search;
+
+typedef struct _timeManager {
+    double secondsPerTurn;
+    double bank;
+
+    // what turns with a share under 1 saved, kept for the ones over 1
+    double reserve;
+
+    // the turn the manager last gave time for and how much of that
+    // turn's time is left
+    int turn;
+    double turnLeft;
+} timeManager;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// search one more depth from the root, trying the builds in order[].
+// value[] is filled in with what each build is worth (for the ones it
+// finished), returns which finished build is best
+static int searchRoot(search *s, const rollout *r,
+        const rolloutMove builds[], int order[], double value[],
+        int count, int depth);
+
+// the player's chance of winning from partway through their turn in
+// r, making at most depth more macro actions
+static double searchNode(search *s, const rollout *r, int depth);
+
+// the chance after making build and at most depth more macro actions
+static double searchBuild(search *s, const rollout *r,
+        const rolloutMove *build, int depth);
+
+// the player's chance of winning if they pass now
+static double passValue(search *s, const rollout *r);
+
+// count a node, and every SEARCH_CHECK_NODES of them see if time's up
+static void spendNode(search *s);
+
+static double secondsSince(const struct timespec *start);
+
+// sort order[] by value[], best first, keeping ties in their order
+static void rankBuilds(int order[], const double value[], int count);
+
+// the share of secondsPerTurn the player's turn in g gets
+static double phaseShare(Game g);
+
+// how many more decisions the player is likely to make this turn
+static int expectedActions(Game g);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+// A build the clock stopped partway through keeps the value it had
+// from the depth before
+static int searchRoot(search *s, const rollout *r,
+        const rolloutMove builds[], int order[], double value[],
+        int count, int depth) {
+    int best = order[0];
+    int i = 0;
+    while (i < count && !s->outOfTime) {
+        int build = order[i];
+        double v = searchBuild(s, r, &builds[build], depth - 1);
+        if (!s->outOfTime) {
+            value[build] = v;
+            if (i == 0 || v > value[best]) {
+                best = build;
+            }
+        }
+        i++;
+    }
+    return best;
+}
+
+
+static double searchNode(search *s, const rollout *r, int depth) {
+    spendNode(s);
+    double best = passValue(s, r);
+
+    if (r->kpi[s->player-1] < WINNING_KPI) {
+        rolloutMove builds[MAX_MACROS];
+        if (depth > 0) {
+            int count = rolloutMacroMoves(r, builds);
+            // builds[0] is the PASS already scored
+            int i = 1;
+            while (i < count && !s->outOfTime) {
+                double v = searchBuild(s, r, &builds[i], depth - 1);
+                if (v > best) {
+                    best = v;
+                }
+                i++;
+            }
+        } else if (!s->cutOff && rolloutMacroMoves(r, builds) > 1) {
+            s->cutOff = TRUE;
+        }
+    }
+
+    return best;
+}
+
+
+// A spinoff is retrained for once and then becomes each of the things
+// it could
+static double searchBuild(search *s, const rollout *r,
+        const rolloutMove *build, int depth) {
+    double value = 0;
+    if (build->actionCode == PASS) {
+        spendNode(s);
+        value = passValue(s, r);
+    } else if (build->actionCode == START_SPINOFF) {
+        rollout retrained = *r;
+        rolloutMove retrains[MAX_MACRO_RETRAINS];
+        int count = rolloutRetraining(r, START_SPINOFF, retrains);
+        int i = 0;
+        while (i < count) {
+            rolloutMakeMove(&retrained, &retrains[i]);
+            i++;
+        }
+
+        rollout made = retrained;
+        rolloutMove outcome = *build;
+        outcome.actionCode = OBTAIN_IP_PATENT;
+        rolloutMakeMove(&made, &outcome);
+        value = searchNode(s, &made, depth) / IP_PATENT_ODDS;
+
+        made = retrained;
+        outcome.actionCode = OBTAIN_PUBLICATION;
+        rolloutMakeMove(&made, &outcome);
+        value += searchNode(s, &made, depth)
+            * (IP_PATENT_ODDS - 1) / IP_PATENT_ODDS;
+    } else {
+        rollout made = *r;
+        rolloutMove move = *build;
+        rolloutMakeMacro(&made, &move);
+        value = searchNode(s, &made, depth);
+    }
+    return value;
+}
+
+
+// Once the player passes nobody is playing, and the next uni is the
+// first to go
+static double passValue(search *s, const rollout *r) {
+    double value = 1;
+    if (r->kpi[s->player-1] < WINNING_KPI) {
+        winEstimate estimates[NUM_UNIS];
+        double chance[NUM_UNIS];
+        int player = UNI_A;
+        while (player <= UNI_C) {
+            kpiOutlook outlook;
+            rolloutKPIOutlook(r, player, &outlook);
+            outlook.playingNow = FALSE;
+            estimates[player-1] = estimateWin(&outlook);
+            player++;
+        }
+        winChancesFrom(estimates, s->player % NUM_UNIS + 1, chance);
+        value = chance[s->player-1];
+    }
+    return value;
+}
+
+
+static void spendNode(search *s) {
+    s->nodes++;
+    if (s->checkClock && (s->nodes & (SEARCH_CHECK_NODES - 1)) == 0
+            && secondsSince(&s->start) >= s->seconds) {
+        s->outOfTime = TRUE;
+    }
+}
+
+
+static double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec)
+        + (now.tv_nsec - start->tv_nsec) / NANOSECONDS;
+}
+
+
+static void rankBuilds(int order[], const double value[], int count) {
+    int i = 1;
+    while (i < count) {
+        int build = order[i];
+        int j = i;
+        while (j > 0 && value[order[j-1]] < value[build]) {
+            order[j] = order[j-1];
+            j--;
+        }
+        order[j] = build;
+        i++;
+    }
+}
+
+
+static double phaseShare(Game g) {
+    double shares[NUM_PHASES] = {OPENING_SHARE, MIDDLE_SHARE,
+        ENDGAME_SHARE};
+    return shares[gamePhase(g)];
+}
+
+
+static int expectedActions(Game g) {
+    int player = getWhoseTurn(g);
+    int students = 0;
+    int discipline = FIRST_SPENDABLE;
+    while (discipline < NUM_DISCIPLINES) {
+        students += getStudents(g, player, discipline);
+        discipline++;
+    }
+
+    int actions = 1 + students / STUDENTS_PER_ACTION;
+    if (actions > MAX_EXPECTED_ACTIONS) {
+        actions = MAX_EXPECTED_ACTIONS;
+    }
+    return actions;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   SEARCH FUNCTIONS BEGIN
+// =====================================================================
+
+Search newSearch (void) {
+    Search s = malloc(sizeof(search));
+    memset(s, 0, sizeof(search));
+    return s;
+}
+
+
+void disposeSearch (Search s) {
+    free(s);
+}
+
+
+// Every depth's values are at least the ones before, since passing
+// early is still one of the choices, so a build finished at a new
+// depth can be compared with the best from the depth before
+void searchMacro (Search s, const rollout *r, double seconds,
+        int maxDepth, searchResult *result) {
+    clock_gettime(CLOCK_MONOTONIC, &s->start);
+    s->seconds = seconds;
+    s->nodes = 0;
+    s->checkClock = FALSE;
+    s->outOfTime = FALSE;
+    s->player = rolloutWhoseTurn(r);
+    if (maxDepth > MAX_SEARCH_DEPTH) {
+        maxDepth = MAX_SEARCH_DEPTH;
+    }
+
+    rolloutMove builds[MAX_MACROS];
+    int count = rolloutMacroMoves(r, builds);
+    memset(result, 0, sizeof(searchResult));
+    int best = 0;
+
+    if (s->player != NO_ONE) {
+        int order[MAX_MACROS];
+        double value[MAX_MACROS];
+        int i = 0;
+        while (i < count) {
+            order[i] = i;
+            value[i] = 0;
+            i++;
+        }
+
+        s->cutOff = TRUE;
+        int depth = 1;
+        while (depth <= maxDepth && s->cutOff && !s->outOfTime) {
+            s->cutOff = FALSE;
+            int found = searchRoot(s, r, builds, order, value, count,
+                    depth);
+            if (!s->outOfTime) {
+                best = found;
+                result->depth = depth;
+                result->complete = !s->cutOff;
+            } else if (value[found] > value[best]) {
+                best = found;
+            }
+            rankBuilds(order, value, count);
+            s->checkClock = TRUE;
+            depth++;
+        }
+        result->winChance = value[best];
+    }
+
+    result->build = builds[best];
+    rolloutMacroAction(r, &builds[best], &result->macro);
+    result->nodes = s->nodes;
+    result->seconds = secondsSince(&s->start);
+}
+
+
+void searchGameMacro (Search s, Game g, double seconds,
+        searchResult *result) {
+    rolloutBoard board;
+    rollout r;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&r, &board, g, 0);
+    searchMacro(s, &r, seconds, MAX_SEARCH_DEPTH, result);
+}
+
+
+double searchBuildValue (Search s, const rollout *r,
+        const rolloutMove *build, int depth) {
+    clock_gettime(CLOCK_MONOTONIC, &s->start);
+    s->nodes = 0;
+    s->checkClock = FALSE;
+    s->outOfTime = FALSE;
+    s->cutOff = FALSE;
+    s->player = rolloutWhoseTurn(r);
+    if (depth > MAX_SEARCH_DEPTH) {
+        depth = MAX_SEARCH_DEPTH;
+    }
+    return searchBuild(s, r, build, depth - 1);
+}
+
+
+// =====================================================================
+//   SEARCH FUNCTIONS END
+//   TIME MANAGER FUNCTIONS BEGIN
+// =====================================================================
+
+TimeManager newTimeManager (double secondsPerTurn) {
+    TimeManager t = malloc(sizeof(timeManager));
+    memset(t, 0, sizeof(timeManager));
+    t->secondsPerTurn = secondsPerTurn;
+    t->turn = NO_TURN;
+    return t;
+}
+
+
+void disposeTimeManager (TimeManager t) {
+    free(t);
+}
+
+
+// The endgame is when anyone is close to winning, not just the player
+int gamePhase (Game g) {
+    int phase = MIDDLE_PHASE;
+    if (getTurnNumber(g) < OPENING_TURNS) {
+        phase = OPENING_PHASE;
+    }
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        if (getKPIpoints(g, player) >= WINNING_KPI - ENDGAME_KPI) {
+            phase = ENDGAME_PHASE;
+        }
+        player++;
+    }
+    return phase;
+}
+
+
+// A new turn banks what the last one didn't use (or pays back what it
+// went over) before taking its share of the bank. The phase then moves
+// time between the turn and the reserve: a share under 1 puts the rest
+// in, and a share over 1 takes out what is there and no more. The
+// reserve isn't dripped out like the bank, so what the opening saves
+// is still there for the endgame
+double allotTime (TimeManager t, Game g) {
+    if (getTurnNumber(g) != t->turn) {
+        if (t->turn != NO_TURN) {
+            t->bank += t->turnLeft;
+        }
+        t->turn = getTurnNumber(g);
+        double fromBank = t->bank / BANK_TURNS;
+        t->bank -= fromBank;
+
+        double extra = t->secondsPerTurn * (phaseShare(g) - 1);
+        if (extra > t->reserve) {
+            extra = t->reserve;
+        }
+        t->reserve -= extra;
+        t->turnLeft = t->secondsPerTurn + extra + fromBank;
+    }
+
+    double seconds = 0;
+    if (t->turnLeft > 0) {
+        seconds = t->turnLeft / expectedActions(g);
+    }
+    return seconds;
+}
+
+
+void spendTime (TimeManager t, double seconds) {
+    t->turnLeft -= seconds;
+}
+
+
+double bankedTime (TimeManager t) {
+    return t->bank + t->reserve;
+}
@@ -0,0 +1,141 @@
+/*
+ *  Search.h - searching for as long as there is time, and how long
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  A bot has so many seconds for each decision, so its search has to
+ *  stop when they're up and still have an answer. This one searches
+ *  the macro actions (see Macro.h) the player could make in the rest
+ *  of their turn: one of them, then up to two in a row, and so on,
+ *  scoring every way the turn could end by the player's chance of
+ *  winning from there (see winChancesFrom() in Forecast.h). A spinoff
+ *  is scored as both of the things it could become.
+ *
+ *  Each depth tries the macros in the order the one before ranked
+ *  them, so when time runs out partway through a depth the macros it
+ *  has finished are the most promising ones, and it answers with the
+ *  best of those. The first depth is always finished whatever the
+ *  time, so there is always an answer. It stops early when a depth
+ *  covers everything the player could afford this turn.
+ *
+ *  The time manager decides how long each decision gets. Turns get
+ *  more time later in the game, where decisions matter more, out of
+ *  time saved by the opening, and time a turn doesn't use is saved up
+ *  for the turns after. Within a
+ *  turn the time is shared between the decisions it is likely to
+ *  take, going by how many students the player has to spend.
+ *
+ *  Include Game.h, GameEngine.h, Rollout.h, Planner.h, Forecast.h,
+ *  Endgame.h and Macro.h before this file.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+// the most macro actions in a row the search looks at
+#define MAX_SEARCH_DEPTH 16
+
+// the search only looks at the clock once every SEARCH_CHECK_NODES
+// positions (a power of 2)
+#define SEARCH_CHECK_NODES 16
+
+typedef struct _searchResult {
+    // the best macro action found for whoever's turn it is, and their
+    // chance of winning if they make it and then play the rest of the
+    // turn as well as the search could see
+    macroAction macro;
+    double winChance;
+
+    // the purchase the macro ends with, as a move for rolloutMakeMacro()
+    rolloutMove build;
+
+    // how many macro actions ahead the deepest finished depth looked.
+    // 0 if nobody can play
+    int depth;
+
+    // TRUE if the search saw every way the turn could go, so more time
+    // wouldn't change the answer
+    int complete;
+
+    // how many positions it scored and how long it took
+    long nodes;
+    double seconds;
+} searchResult;
+
+typedef struct _search *Search;
+
+Search newSearch (void);
+void disposeSearch (Search s);
+
+// search for the best macro action for whoever's turn it is in r for
+// at most seconds (but see above), looking at most maxDepth (up to
+// MAX_SEARCH_DEPTH) macro actions ahead. A START_SPINOFF at the end of
+// the macro has to be turned into what it became before it's made
+void searchMacro (Search s, const rollout *r, double seconds,
+        int maxDepth, searchResult *result);
+
+// searchMacro() for whoever's turn it is in g, as deep as there's time
+void searchGameMacro (Search s, Game g, double seconds,
+        searchResult *result);
+
+// whoever's turn it is in r's chance of winning if they make build
+// (PASS, or any purchase they can pay for once they've retrained) and
+// then at most depth-1 more macro actions, scored as searchMacro()
+// scores each of its choices at that depth. There's no deadline, so
+// it always finishes the depth. A START_SPINOFF is scored as both of
+// the things it could become
+double searchBuildValue (Search s, const rollout *r,
+        const rolloutMove *build, int depth);
+
+
+// =====================================================================
+//   TIME MANAGER
+// =====================================================================
+
+// the parts of a game, which get different shares of the time
+#define OPENING_PHASE 0
+#define MIDDLE_PHASE 1
+#define ENDGAME_PHASE 2
+#define NUM_PHASES 3
+
+// the opening lasts this many turns (counting every uni's)
+#define OPENING_TURNS (4 * NUM_UNIS)
+
+// how much of the time for a turn each phase's turns get. Every turn
+// has secondsPerTurn: a share under 1 saves the rest, and a share over
+// 1 is paid for out of what was saved that way, as far as it goes
+#define OPENING_SHARE 0.5
+#define MIDDLE_SHARE 1.0
+#define ENDGAME_SHARE 2.0
+
+// a turn spends 1 / BANK_TURNS of the time saved up
+#define BANK_TURNS 4
+
+// within a turn, a decision is expected for every STUDENTS_PER_ACTION
+// students the player could spend, and one more to pass
+#define STUDENTS_PER_ACTION 4
+#define MAX_EXPECTED_ACTIONS 8
+
+typedef struct _timeManager *TimeManager;
+
+// a manager for one player giving them secondsPerTurn for each of
+// their turns on average. As long as they spend no more than they're
+// allotted, n turns never take more than n * secondsPerTurn
+TimeManager newTimeManager (double secondsPerTurn);
+void disposeTimeManager (TimeManager t);
+
+// which phase the game is in
+int gamePhase (Game g);
+
+// how many seconds to spend on the decision the player is making now
+// in g. 0 once the turn's time has run out
+double allotTime (TimeManager t, Game g);
+
+// the decision took seconds, whatever allotTime() said
+void spendTime (TimeManager t, double seconds);
+
+// the seconds saved up from earlier turns (including what the phase
+// shares saved), less than 0 if they went over
+double bankedTime (TimeManager t);
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * SelfPlay.c - greedy bots playing each other, and what they leave
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * Games are played on a rollout a macro action at a time. The dice,
+ * spinoffs and exploring each have their own xorshift numbers, so one
+ * bot choosing differently never changes the dice. See SelfPlay.h
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "SelfPlay.h"
+
+
+// which random numbers a seed is turned into
+#define DICE_STREAM 1
+#define SPINOFF_STREAM 2
+#define EXPLORE_STREAM 3
+
+// how many records a game starts with room for
+#define START_RECORDS 256
+
+
+typedef struct _shard {
+    FILE *file;
+    shardHeader header;
+    long bytes;
+    int failed;
+} shard;
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// the students a roll is expected to give a campus on the vertex
+static double vertexIncome(const rolloutBoard *board, int vertex);
+
+// keep the position in r as the game's next record
+static void addRecord(selfPlayResult *result, const rollout *r);
+
+// fill in the winner and margins of every record once the game is over
+static void finishRecords(selfPlayResult *result);
+
+// the start of the random numbers for one use of a seed, never 0
+static uint64_t streamSeed(uint64_t seed, int stream);
+
+// the next random number, xorshift64*
+static uint64_t nextRandom(uint64_t *state);
+
+// a random number from 0 to n-1, and from 0 up to (but not) 1
+static int randomBelow(uint64_t *state, int n);
+static double randomUnit(uint64_t *state);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static double vertexIncome(const rolloutBoard *board, int vertex) {
+    double income = 0;
+    int score = 2;
+    while (score <= 12) {
+        int region = 0;
+        while (region < board->numProducing[score]) {
+            if (board->producingVertices[score][region]
+                    & VERTEX_BIT(vertex)) {
+                income += getDiceChance(score);
+            }
+            region++;
+        }
+        score++;
+    }
+    return income;
+}
+
+
+static void addRecord(selfPlayResult *result, const rollout *r) {
+    if (result->numRecords == result->capacity) {
+        result->capacity = 2 * result->capacity + START_RECORDS;
+        result->records = realloc(result->records,
+                result->capacity * sizeof(trainingRecord));
+    }
+    trainingRecord *record = &result->records[result->numRecords];
+    memset(record, 0, sizeof(trainingRecord));
+    rolloutPack(r, &record->position);
+    result->numRecords++;
+}
+
+
+static void finishRecords(selfPlayResult *result) {
+    int16_t margins[NUM_UNIS];
+    int i = 0;
+    while (i < NUM_UNIS) {
+        int best = 0;
+        int other = 0;
+        while (other < NUM_UNIS) {
+            if (other != i && result->kpi[other] > best) {
+                best = result->kpi[other];
+            }
+            other++;
+        }
+        margins[i] = result->kpi[i] - best;
+        i++;
+    }
+
+    int n = 0;
+    while (n < result->numRecords) {
+        trainingRecord *record = &result->records[n];
+        record->winner = result->winner;
+        memcpy(record->margins, margins, sizeof(margins));
+        n++;
+    }
+}
+
+
+// splitmix64 spreads out seeds which are close together
+static uint64_t streamSeed(uint64_t seed, int stream) {
+    uint64_t z = seed + stream * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    if (z == 0) {
+        z = 1;
+    }
+    return z;
+}
+
+
+static uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+
+static int randomBelow(uint64_t *state, int n) {
+    uint64_t top = nextRandom(state) >> 32;
+    return (int)((top * (uint64_t)n) >> 32);
+}
+
+
+static double randomUnit(uint64_t *state) {
+    return (nextRandom(state) >> 11) * (1.0 / (1ULL << 53));
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   SELF-PLAY FUNCTIONS BEGIN
+// =====================================================================
+
+void defaultGreedyWeights (double weights[]) {
+    weights[GREEDY_CAMPUS] = 10;
+    weights[GREEDY_GO8] = 12;
+    weights[GREEDY_ARC] = 3;
+    weights[GREEDY_SPINOFF] = 4;
+    weights[GREEDY_INCOME] = 20;
+    weights[GREEDY_RETRAIN] = -1;
+}
+
+
+rolloutMove greedyMacroMove (const rollout *r, const double weights[]) {
+    rolloutMove builds[MAX_MACROS];
+    int count = rolloutMacroMoves(r, builds);
+
+    int best = 0;
+    double bestScore = 0;
+    int i = 1;
+    while (i < count) {
+        int code = builds[i].actionCode;
+        double score = 0;
+        if (code == BUILD_CAMPUS) {
+            score = weights[GREEDY_CAMPUS] + weights[GREEDY_INCOME]
+                * vertexIncome(r->board, builds[i].target);
+        } else if (code == BUILD_GO8) {
+            score = weights[GREEDY_GO8] + weights[GREEDY_INCOME]
+                * vertexIncome(r->board, builds[i].target);
+        } else if (code == OBTAIN_ARC) {
+            score = weights[GREEDY_ARC];
+        } else if (code == START_SPINOFF) {
+            score = weights[GREEDY_SPINOFF];
+        }
+
+        rolloutMove retrains[MAX_MACRO_RETRAINS];
+        int numRetrains = rolloutRetraining(r, code, retrains);
+        if (numRetrains != CANT_RETRAIN) {
+            score += weights[GREEDY_RETRAIN] * numRetrains;
+            if (score > bestScore) {
+                best = i;
+                bestScore = score;
+            }
+        }
+        i++;
+    }
+    return builds[best];
+}
+
+
+// Every decision is recorded before it's made, so the last record of
+// a turn is the one where the player passed
+void selfPlayGame (const rollout *start, const double *weights[],
+        double explore, uint64_t seed, int record,
+        selfPlayResult *result) {
+    memset(result, 0, sizeof(selfPlayResult));
+    uint64_t dice = streamSeed(seed, DICE_STREAM);
+    uint64_t exploring = streamSeed(seed, EXPLORE_STREAM);
+    rollout r = *start;
+    r.rng = streamSeed(seed, SPINOFF_STREAM);
+    if (r.turnNumber == -1) {
+        rolloutThrowDice(&r, randomBelow(&dice, 6)
+                + randomBelow(&dice, 6) + 2);
+    }
+
+    int winner = NO_ONE;
+    int turns = 0;
+    while (winner == NO_ONE && turns < SELF_PLAY_MAX_TURNS) {
+        int player = rolloutWhoseTurn(&r);
+        if (record) {
+            addRecord(result, &r);
+        }
+
+        rolloutMove build;
+        if (explore > 0 && randomUnit(&exploring) < explore) {
+            rolloutMove builds[MAX_MACROS];
+            int count = rolloutMacroMoves(&r, builds);
+            build = builds[randomBelow(&exploring, count)];
+        } else {
+            build = greedyMacroMove(&r, weights[player-1]);
+        }
+
+        if (build.actionCode == PASS) {
+            rolloutThrowDice(&r, randomBelow(&dice, 6)
+                    + randomBelow(&dice, 6) + 2);
+            turns++;
+        } else {
+            rolloutMakeMacro(&r, &build);
+            if (r.kpi[player-1] >= WINNING_KPI) {
+                winner = player;
+            }
+        }
+    }
+
+    result->winner = winner;
+    result->turns = turns;
+    memcpy(result->kpi, r.kpi, sizeof(r.kpi));
+    finishRecords(result);
+}
+
+
+void disposeSelfPlayRecords (selfPlayResult *result) {
+    free(result->records);
+    result->records = NULL;
+    result->numRecords = 0;
+    result->capacity = 0;
+}
+
+
+// =====================================================================
+//   SELF-PLAY FUNCTIONS END
+//   SHARD FUNCTIONS BEGIN
+// =====================================================================
+
+// The header goes in first with no records, and is written again with
+// the count when the shard is closed
+Shard newShard (const char *fileName, int discipline[], int dice[]) {
+    Shard s = NULL;
+    FILE *file = fopen(fileName, "wb");
+    if (file != NULL) {
+        s = malloc(sizeof(shard));
+        memset(s, 0, sizeof(shard));
+        s->file = file;
+        s->header.magic = SHARD_MAGIC;
+        s->header.version = SHARD_VERSION;
+        s->header.recordBytes = sizeof(trainingRecord);
+        int region = 0;
+        while (region < NUM_REGIONS) {
+            s->header.discipline[region] = discipline[region];
+            s->header.dice[region] = dice[region];
+            region++;
+        }
+        s->failed = fwrite(&s->header, sizeof(shardHeader), 1, file) != 1;
+        s->bytes = sizeof(shardHeader);
+    }
+    return s;
+}
+
+
+int shardWrite (Shard s, const trainingRecord records[], int count) {
+    int written = fwrite(records, sizeof(trainingRecord), count, s->file);
+    s->header.numRecords += written;
+    s->bytes += written * sizeof(trainingRecord);
+    if (written != count) {
+        s->failed = TRUE;
+    }
+    return written == count;
+}
+
+
+long shardBytes (Shard s) {
+    return s->bytes;
+}
+
+
+int closeShard (Shard s) {
+    int saved = !s->failed
+        && fseek(s->file, 0, SEEK_SET) == 0
+        && fwrite(&s->header, sizeof(shardHeader), 1, s->file) == 1;
+    if (fclose(s->file) != 0) {
+        saved = FALSE;
+    }
+    free(s);
+    return saved;
+}
+
+
+// As with loadBook() the header and the file's size are checked
+// before anything is allocated
+trainingRecord *loadShard (const char *fileName, shardHeader *header) {
+    trainingRecord *records = NULL;
+    FILE *file = fopen(fileName, "rb");
+    if (file != NULL) {
+        if (fread(header, sizeof(shardHeader), 1, file) == 1
+                && header->magic == SHARD_MAGIC
+                && header->version == SHARD_VERSION
+                && header->recordBytes == sizeof(trainingRecord)
+                && fseek(file, 0, SEEK_END) == 0
+                && ftell(file) == (long)(sizeof(shardHeader)
+                    + (uint64_t)header->numRecords
+                    * sizeof(trainingRecord))
+                && fseek(file, sizeof(shardHeader), SEEK_SET) == 0) {
+            // malloc(0) may be NULL, which would look like a bad file
+            records = malloc((header->numRecords + 1)
+                    * sizeof(trainingRecord));
+            if (fread(records, sizeof(trainingRecord), header->numRecords,
+                        file) != header->numRecords) {
+                free(records);
+                records = NULL;
+            }
+        }
+        fclose(file);
+    }
+    return records;
+}
@@ -0,0 +1,146 @@
+/*
+ *  SelfPlay.h - greedy bots playing each other, and what they leave
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  Learning how good a position is takes a great many positions whose
+ *  outcome is known. These play whole games on a rollout (see
+ *  Rollout.h) between greedy bots, which buy whichever macro action
+ *  (see Macro.h) their weights score highest and now and then explore
+ *  a random one instead, and keep every decision's position together
+ *  with how the game ended.
+ *
+ *  The positions are written out in shard files: a header with the
+ *  board, then fixed size records one after another, so a shard can be
+ *  read in one go or mapped and indexed. A game is never split between
+ *  two shards. Like a book (see Book.h), a shard is only meant to be
+ *  read on the same kind of machine that wrote it.
+ *
+ *  Include Game.h, GameEngine.h, Rollout.h and Macro.h before this
+ *  file.
+ */
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// =====================================================================
+//   GREEDY BOTS
+// =====================================================================
+
+// what a greedy bot's weights are for. A purchase scores the weight for
+// what it is, plus GREEDY_INCOME for each student a roll is expected
+// to give the campus or GO8 (see getDiceChance()), plus GREEDY_RETRAIN
+// for each retraining it needs. PASS scores 0, so a purchase that
+// scores less is never made
+#define GREEDY_CAMPUS 0
+#define GREEDY_GO8 1
+#define GREEDY_ARC 2
+#define GREEDY_SPINOFF 3
+#define GREEDY_INCOME 4
+#define GREEDY_RETRAIN 5
+#define NUM_GREEDY_WEIGHTS 6
+
+// fill in the weights the bots start with
+void defaultGreedyWeights (double weights[]);
+
+// the purchase (one of rolloutMacroMoves()) a greedy bot with the
+// weights makes in r, or PASS. The first of any tied is chosen
+rolloutMove greedyMacroMove (const rollout *r, const double weights[]);
+
+
+// =====================================================================
+//   SELF-PLAY GAMES
+// =====================================================================
+
+// a game nobody has won after this many turns is a draw
+#define SELF_PLAY_MAX_TURNS 600
+
+// how often a bot explores a random macro action for training data
+#define SELF_PLAY_EXPLORE 0.1
+
+// a position a bot had to decide in, and how the game ended. Margins
+// are each uni's final KPI points less the most any other uni had, so
+// only the winner's is above 0
+#define TRAINING_RECORD_BYTES 112
+
+typedef struct _trainingRecord {
+    packedPosition position;
+    uint8_t winner;
+    uint8_t unused;
+    int16_t margins[NUM_UNIS];
+} trainingRecord;
+
+typedef struct _selfPlayResult {
+    // the winner (NO_ONE for a draw), how many turns it took and
+    // everybody's KPI points at the end
+    int winner;
+    int turns;
+    int kpi[NUM_UNIS];
+
+    // every decision's position in order, if they were recorded
+    int numRecords;
+    int capacity;
+    trainingRecord *records;
+} selfPlayResult;
+
+// play a game from start to the end, each uni choosing with its own
+// weights (weights[player-1]) and exploring with the chance explore.
+// seed picks the dice, the spinoffs and the exploring, each from its
+// own random numbers: the dice only depend on the seed, so games with
+// the same seed roll the same dice whoever plays them. If record is
+// TRUE the positions are kept in the result, which has to be freed
+// with disposeSelfPlayRecords()
+void selfPlayGame (const rollout *start, const double *weights[],
+        double explore, uint64_t seed, int record,
+        selfPlayResult *result);
+
+void disposeSelfPlayRecords (selfPlayResult *result);
+
+
+// =====================================================================
+//   SHARD FILES
+// =====================================================================
+
+// the first bytes of every shard file ("SHRD"), and the version of the
+// format after them
+#define SHARD_MAGIC 0x44524853
+#define SHARD_VERSION 1
+
+typedef struct _shardHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordBytes;
+    uint32_t numRecords;
+
+    // the board, as given to newGame()
+    int8_t discipline[NUM_REGIONS];
+    int8_t dice[NUM_REGIONS];
+    uint8_t unused[2];
+} shardHeader;
+
+typedef struct _shard *Shard;
+
+// start writing a shard of positions on the board to the file, or
+// NULL if it can't be created
+Shard newShard (const char *fileName, int discipline[], int dice[]);
+
+// add the records to the end of the shard. returns FALSE if they
+// couldn't all be written
+int shardWrite (Shard s, const trainingRecord records[], int count);
+
+// how many bytes the shard's file holds so far
+long shardBytes (Shard s);
+
+// finish the shard's file. returns FALSE if anything written to it
+// was lost
+int closeShard (Shard s);
+
+// read a whole shard file into header and a malloced array of its
+// records, or NULL if it can't be read or isn't a shard of this
+// version
+trainingRecord *loadShard (const char *fileName, shardHeader *header);
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Tune.c - tuning weights against a noisy score with SPSA
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * The signs of the nudges come from xorshift numbers, so a run with
+ * the same seed nudges the same way. See Tune.h
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "Tune.h"
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS BEGIN
+// =====================================================================
+
+// the next random number, xorshift64*
+static uint64_t nextRandom(uint64_t *state);
+
+
+// =====================================================================
+//   STATIC FUNCTION DECLARATIONS END
+//   STATIC FUNCTIONS BEGIN
+// =====================================================================
+
+static uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+
+// =====================================================================
+//   STATIC FUNCTIONS END
+//   TUNING FUNCTIONS BEGIN
+// =====================================================================
+
+// xorshift never leaves 0, so the seed is spread out and kept off it
+void spsaStart (spsa *s, const double weights[], int numWeights,
+        int iterations, uint64_t seed) {
+    assert(numWeights > 0 && numWeights <= SPSA_MAX_WEIGHTS);
+    memset(s, 0, sizeof(spsa));
+    s->numWeights = numWeights;
+    s->iterations = iterations;
+    s->gain = SPSA_GAIN;
+    s->random = (seed + 1) * 0x9E3779B97F4A7C15ULL;
+    if (s->random == 0) {
+        s->random = 1;
+    }
+    int w = 0;
+    while (w < numWeights) {
+        s->weights[w] = weights[w];
+        s->scale[w] = fmax(fabs(weights[w]) * SPSA_SCALE_FRACTION,
+                SPSA_MIN_SCALE);
+        w++;
+    }
+}
+
+
+void spsaCandidates (spsa *s, double plus[], double minus[]) {
+    s->perturb = SPSA_PERTURB / pow(s->k + 1, SPSA_PERTURB_DECAY);
+    int w = 0;
+    while (w < s->numWeights) {
+        if (nextRandom(&s->random) >> 63) {
+            s->signs[w] = 1;
+        } else {
+            s->signs[w] = -1;
+        }
+        double nudge = s->perturb * s->signs[w] * s->scale[w];
+        plus[w] = s->weights[w] + nudge;
+        minus[w] = s->weights[w] - nudge;
+        w++;
+    }
+}
+
+
+// The first step moves a weight gain / (1+A)^SPSA_GAIN_DECAY times
+// difference / (2 * perturb) scales, which is one perturb for the
+// average size of difference
+void spsaCalibrate (spsa *s, const double differences[], int n) {
+    double total = 0;
+    int i = 0;
+    while (i < n) {
+        total += fabs(differences[i]);
+        i++;
+    }
+    if (total > 0) {
+        double perturb = SPSA_PERTURB;
+        double stability = SPSA_STABILITY * s->iterations;
+        s->gain = 2 * perturb * perturb * pow(1 + stability,
+                SPSA_GAIN_DECAY) / (total / n);
+    }
+}
+
+
+void spsaStep (spsa *s, double plus, double minus) {
+    double gain = s->gain / pow(s->k + 1 + SPSA_STABILITY * s->iterations,
+            SPSA_GAIN_DECAY);
+    double limit = SPSA_MAX_STEP * s->perturb;
+    int w = 0;
+    while (w < s->numWeights) {
+        double gradient = (plus - minus) / (2 * s->perturb * s->signs[w]);
+        double step = fmax(-limit, fmin(limit, gain * gradient));
+        s->weights[w] += step * s->scale[w];
+        w++;
+    }
+    s->k++;
+}
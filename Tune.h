@@ -0,0 +1,79 @@
+/*
+ *  Tune.h - tuning weights against a noisy score with SPSA
+ *
+ *  By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ *  SPSA (simultaneous perturbation stochastic approximation) tunes
+ *  weights to score better at something only measured with noise, like
+ *  how often a bot with them wins. Each iteration nudges every weight
+ *  up or down at random at once, scores the weights nudged each way
+ *  and moves the weights towards whichever did better, so only two
+ *  candidates are scored per iteration however many weights there
+ *  are. Weights are nudged and moved in units of their scale, a
+ *  fraction of their size to start with, so the small ones move as
+ *  readily as the large ones.
+ *
+ *  The tuner never scores anything itself: the caller plays whatever
+ *  the candidates are for and hands back the scores.
+ */
+
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdint.h>
+
+// the most weights one tuner can tune
+#define SPSA_MAX_WEIGHTS 16
+
+// Iteration k nudges by SPSA_PERTURB / (k+1)^SPSA_PERTURB_DECAY scales
+// and steps by gain / (k+1+A)^SPSA_GAIN_DECAY times the estimated
+// gradient, where A is SPSA_STABILITY of the iterations (Spall's
+// choices of decay). No step moves a weight more than SPSA_MAX_STEP
+// nudges
+#define SPSA_PERTURB 1.0
+#define SPSA_PERTURB_DECAY 0.101
+#define SPSA_GAIN 0.5
+#define SPSA_GAIN_DECAY 0.602
+#define SPSA_STABILITY 0.1
+#define SPSA_MAX_STEP 3.0
+
+// a weight's scale is this fraction of where it starts, but at least 1
+// so a weight that starts at 0 can still move
+#define SPSA_SCALE_FRACTION 0.5
+#define SPSA_MIN_SCALE 1.0
+
+typedef struct _spsa {
+    int numWeights;
+    int iterations;
+    int k;
+    double gain;
+    double weights[SPSA_MAX_WEIGHTS];
+    double scale[SPSA_MAX_WEIGHTS];
+
+    // the last candidates' nudge and signs, and the random numbers the
+    // signs come from
+    double perturb;
+    int signs[SPSA_MAX_WEIGHTS];
+    uint64_t random;
+} spsa;
+
+// start tuning numWeights weights over the number of iterations, with
+// the signs of the nudges coming from seed
+void spsaStart (spsa *s, const double weights[], int numWeights,
+        int iterations, uint64_t seed);
+
+// nudge the weights for the next iteration, filling in the candidates
+// nudged up and down
+void spsaCandidates (spsa *s, double plus[], double minus[]);
+
+// set the gain from how much the candidates' scores differed (plus
+// less minus) in n trial nudges before the first iteration, so that
+// the first step moves a weight about one nudge. The gain stays at
+// SPSA_GAIN if they never differed
+void spsaCalibrate (spsa *s, const double differences[], int n);
+
+// move the weights by how the candidates spsaCandidates() last gave
+// scored, and go on to the next iteration
+void spsaStep (spsa *s, double plus, double minus);
+
+#endif
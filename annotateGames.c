@@ -0,0 +1,355 @@
+/*
+ * annotateGames.c - scores every decision in recorded games
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * usage: annotateGames outFile depth replayFile...
+ *
+ * Every replay (see Replay.h) is played back, and each decision in it
+ * is searched depth macro actions deep (see Search.h) on all the
+ * processors at once. A decision is a purchase or PASS together with
+ * the retraining made just before it. The depth is always finished,
+ * so the annotations come out the same on any machine.
+ *
+ * outFile gets a line for each decision, in the order they were made,
+ * with tabs between:
+ *
+ *   the replay file, the event the decision starts at (from 0), the
+ *   turn, the player, what they played (see formatAction()) and their
+ *   chance of winning after it, the best purchase the search found and
+ *   the chance after that, and how much chance the player gave up
+ *
+ * What they played is the purchase, so a spinoff is shown as what it
+ * became, but it is scored as the spinoff it was. A turn that ended
+ * without a PASS (straight to the dice) ends with a PASS.
+ */
+
+// for clock_gettime() and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+#include "Forecast.h"
+#include "Endgame.h"
+#include "Macro.h"
+#include "Search.h"
+#include "Replay.h"
+
+
+#define MAX_THREADS 64
+
+// the search never runs out of time
+#define NO_DEADLINE 1e9
+
+// a decision that gives up more than this chance of winning is counted
+// as a blunder in the summary
+#define BLUNDER_CHANCE 0.1
+
+
+// a decision found in a replay, and what the search made of it
+typedef struct _decision {
+    int replay;
+    int event;
+    int turn;
+    int player;
+
+    // the position before the decision, and after the retraining the
+    // player made but before what they bought with it
+    rollout before;
+    rollout retrained;
+
+    // what they bought, as it was made and as a move to score
+    action played;
+    rolloutMove build;
+
+    double playedChance;
+    double bestChance;
+    action best;
+} decision;
+
+// a growing list of decisions
+typedef struct _decisionList {
+    decision *decisions;
+    int count;
+    int capacity;
+} decisionList;
+
+// what the threads annotating share
+typedef struct _annotation {
+    decisionList *list;
+    int depth;
+
+    // the next decision nobody has taken yet
+    int next;
+    pthread_mutex_t lock;
+} annotation;
+
+
+// play the replay back and add each of its decisions to the list.
+// board has to last as long as the decisions do. returns FALSE if the
+// replay has an event that isn't legal
+int findDecisions(Replay r, int replay, rolloutBoard *board,
+        decisionList *list);
+
+// add a decision to the list, and the move for what was bought
+decision *addDecision(decisionList *list);
+rolloutMove moveOfAction(action a);
+
+// search every decision with threads threads
+void annotate(decisionList *list, int depth, int threads);
+
+// what each thread runs, taking decisions until there are none left
+void *searchDecisions(void *arg);
+
+// write every decision to the file. returns FALSE if it couldn't
+int writeAnnotations(const char *fileName, const decisionList *list,
+        char *replayFiles[]);
+
+double secondsSince(const struct timespec *start);
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s outFile depth replayFile...\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    int depth = atoi(argv[2]);
+    if (depth < 1 || depth > MAX_SEARCH_DEPTH) {
+        fprintf(stderr, "depth must be from 1 to %d\n",
+                MAX_SEARCH_DEPTH);
+        return EXIT_FAILURE;
+    }
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    char **replayFiles = &argv[3];
+    int numReplays = argc - 3;
+    rolloutBoard *boards = malloc(numReplays * sizeof(rolloutBoard));
+    decisionList list = {NULL, 0, 0};
+    int failed = FALSE;
+    int i = 0;
+    while (i < numReplays) {
+        Replay r = loadReplay(replayFiles[i]);
+        if (r == NULL) {
+            fprintf(stderr, "couldn't read %s\n", replayFiles[i]);
+            failed = TRUE;
+        } else {
+            if (!findDecisions(r, i, &boards[i], &list)) {
+                fprintf(stderr, "%s has an illegal event, only the "
+                        "decisions before it are annotated\n",
+                        replayFiles[i]);
+                failed = TRUE;
+            }
+            disposeReplay(r);
+        }
+        i++;
+    }
+
+    struct timespec began;
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    annotate(&list, depth, threads);
+    double seconds = secondsSince(&began);
+
+    int blunders = 0;
+    i = 0;
+    while (i < list.count) {
+        decision *d = &list.decisions[i];
+        if (d->bestChance - d->playedChance > BLUNDER_CHANCE) {
+            blunders++;
+        }
+        i++;
+    }
+    printf("%d decisions in %d replays, %.1f seconds (%.1f decisions/sec)"
+            ", %d blunders\n", list.count, numReplays, seconds,
+            list.count / seconds, blunders);
+
+    if (!writeAnnotations(argv[1], &list, replayFiles)) {
+        fprintf(stderr, "couldn't write %s\n", argv[1]);
+        failed = TRUE;
+    }
+    free(list.decisions);
+    free(boards);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// The position is taken before every action of a decision, so the
+// last one taken is the one after the retraining
+int findDecisions(Replay r, int replay, rolloutBoard *board,
+        decisionList *list) {
+    int discipline[NUM_REGIONS];
+    int dice[NUM_REGIONS];
+    replayBoard(r, discipline, dice);
+    Game g = newGame(discipline, dice);
+    rolloutBoardFromGame(board, g);
+
+    decision *open = NULL;
+    int legal = TRUE;
+    int n = 0;
+    while (n < replayLength(r) && legal) {
+        replayEvent event = replayEventAt(r, n);
+        if (event.type == REPLAY_ACTION) {
+            if (open == NULL) {
+                open = addDecision(list);
+                open->replay = replay;
+                open->event = n;
+                open->turn = getTurnNumber(g);
+                open->player = getWhoseTurn(g);
+                rolloutFromGame(&open->before, board, g, 0);
+            }
+            rolloutFromGame(&open->retrained, board, g, 0);
+            if (event.a.actionCode != RETRAIN_STUDENTS) {
+                open->played = event.a;
+                open->build = moveOfAction(event.a);
+                open = NULL;
+            }
+        } else if (open != NULL) {
+            rolloutFromGame(&open->retrained, board, g, 0);
+            memset(&open->played, 0, sizeof(action));
+            open->played.actionCode = PASS;
+            open->build = moveOfAction(open->played);
+            open = NULL;
+        }
+
+        legal = replayStep(r, g, n);
+        n++;
+    }
+
+    // a decision the illegal event was part of can't be scored
+    if (open != NULL) {
+        list->count--;
+    }
+    disposeGame(g);
+    return legal;
+}
+
+
+decision *addDecision(decisionList *list) {
+    if (list->count == list->capacity) {
+        list->capacity = 2 * list->capacity + 1;
+        list->decisions = realloc(list->decisions,
+                list->capacity * sizeof(decision));
+    }
+    decision *d = &list->decisions[list->count];
+    memset(d, 0, sizeof(decision));
+    list->count++;
+    return d;
+}
+
+
+rolloutMove moveOfAction(action a) {
+    rolloutMove move = {.actionCode = a.actionCode, .target = -1,
+        .disciplineFrom = -1, .disciplineTo = -1};
+    if (a.actionCode == OBTAIN_PUBLICATION
+            || a.actionCode == OBTAIN_IP_PATENT) {
+        move.actionCode = START_SPINOFF;
+    } else if (a.actionCode == BUILD_CAMPUS
+            || a.actionCode == BUILD_GO8) {
+        move.target = vertexOfPath(a.destination);
+    } else if (a.actionCode == OBTAIN_ARC) {
+        move.target = edgeOfPath(a.destination);
+    }
+    return move;
+}
+
+
+void annotate(decisionList *list, int depth, int threads) {
+    annotation a;
+    a.list = list;
+    a.depth = depth;
+    a.next = 0;
+    pthread_mutex_init(&a.lock, NULL);
+
+    pthread_t ids[MAX_THREADS];
+    int i = 0;
+    while (i < threads) {
+        pthread_create(&ids[i], NULL, searchDecisions, &a);
+        i++;
+    }
+    i = 0;
+    while (i < threads) {
+        pthread_join(ids[i], NULL);
+        i++;
+    }
+    pthread_mutex_destroy(&a.lock);
+}
+
+
+// Each thread has a search of its own and only writes to the decisions
+// it took, so only taking the next one needs the lock
+void *searchDecisions(void *arg) {
+    annotation *a = arg;
+    Search s = newSearch();
+    int taken = TRUE;
+    while (taken) {
+        pthread_mutex_lock(&a->lock);
+        int i = a->next;
+        a->next++;
+        pthread_mutex_unlock(&a->lock);
+
+        taken = (i < a->list->count);
+        if (taken) {
+            decision *d = &a->list->decisions[i];
+            searchResult result;
+            searchMacro(s, &d->before, NO_DEADLINE, a->depth, &result);
+            d->bestChance = result.winChance;
+            d->best = result.macro.actions[result.macro.numActions-1];
+            d->playedChance = searchBuildValue(s, &d->retrained,
+                    &d->build, a->depth);
+        }
+    }
+    disposeSearch(s);
+    return NULL;
+}
+
+
+int writeAnnotations(const char *fileName, const decisionList *list,
+        char *replayFiles[]) {
+    int saved = FALSE;
+    FILE *file = fopen(fileName, "w");
+    if (file != NULL) {
+        fprintf(file, "# replay\tevent\tturn\tplayer\tplayed\tchance"
+                "\tbest\tchance\tloss\n");
+        int i = 0;
+        while (i < list->count) {
+            const decision *d = &list->decisions[i];
+            char played[MAX_ACTION_TEXT];
+            char best[MAX_ACTION_TEXT];
+            formatAction(d->played, played);
+            formatAction(d->best, best);
+            fprintf(file, "%s\t%d\t%d\t%d\t%s\t%.4f\t%s\t%.4f\t%.4f\n",
+                    replayFiles[d->replay], d->event, d->turn, d->player,
+                    played, d->playedChance, best, d->bestChance,
+                    d->bestChance - d->playedChance);
+            i++;
+        }
+        saved = !ferror(file);
+        if (fclose(file) != 0) {
+            saved = FALSE;
+        }
+    }
+    return saved;
+}
+
+
+double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec)
+        + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
@@ -0,0 +1,360 @@
+/*
+ * buildBook.c - searches the opening ahead of time and saves a book
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * usage: buildBook bookFile [turns] [playouts] [threads] [boardFile]
+ *
+ * threads defaults to one for each processor. boardFile has the board
+ * to build the book for, the disciplines and dice numbers given to
+ * newGame() on two lines written as in a replay file (see Replay.h):
+ *
+ *   board <the 19 disciplines>
+ *   dice <the 19 dice numbers>
+ *
+ * Without one the book is for the default board.
+ *
+ * Every position in the first turns turns (counting every uni's) on
+ * the board is searched with playouts MCTS playouts (see
+ * Mcts.h), as long as every uni plays what the book says. After a
+ * purchase the next decision is searched, after a PASS every roll of
+ * the dice is, and after a spinoff both things it could become are.
+ *
+ * The positions are searched a wave at a time: each decision in a
+ * wave is shared out between the threads, which have a search each,
+ * and the positions they lead to make up the next wave. Each search
+ * is seeded with the position's hash, so the book comes out the same
+ * however many threads build it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "Mcts.h"
+#include "Book.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define DEFAULT_TURNS 3
+#define DEFAULT_PLAYOUTS 2000
+#define MAX_THREADS 64
+
+// each search's tree has room for this many nodes
+#define BOOK_TREE_NODES (1 << 18)
+
+
+// a position to search and its key in the book
+typedef struct _position {
+    uint64_t key;
+    Game g;
+} position;
+
+// a growing list of positions
+typedef struct _positionList {
+    position *positions;
+    int count;
+    int capacity;
+} positionList;
+
+// what the threads searching a wave share
+typedef struct _wave {
+    const positionList *list;
+    macroAction *macros;
+    int playouts;
+
+    // the next position nobody has taken yet
+    int next;
+    pthread_mutex_t lock;
+} wave;
+
+
+// search every position in the list with threads threads, filling in
+// macros[] with what each one chose
+void searchWave(const positionList *list, macroAction macros[],
+        int playouts, int threads);
+
+// what each thread runs, taking positions until there are none left
+void *searchPositions(void *arg);
+
+// add a position to the list, which keeps g
+void addPosition(positionList *list, Game g);
+
+// sort the list by key and throw away positions which are in it twice
+// or are already in the book
+void removeRepeats(positionList *list, Book b);
+int compareKeys(const void *a, const void *b);
+
+// add to next every position macro leads to from g: the next decision
+// in the turn, or the first of every uni's next turn up to turns
+void followMacro(Game g, const macroAction *macro, int turns,
+        positionList *next);
+
+// read the board in the file into disciplines[] and dice[]. returns
+// FALSE if it can't be read or isn't a board
+int readBoard(const char *fileName, int disciplines[], int dice[]);
+
+// read NUM_REGIONS numbers from min to max after the word label
+int readRegions(FILE *file, const char *label, int values[], int min,
+        int max);
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 6) {
+        fprintf(stderr, "usage: %s bookFile [turns] [playouts] "
+                "[threads] [boardFile]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int turns = DEFAULT_TURNS;
+    int playouts = DEFAULT_PLAYOUTS;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 2) {
+        turns = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        playouts = atoi(argv[3]);
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (argc > 4) {
+        threads = atoi(argv[4]);
+    }
+    if (turns < 1 || playouts < 1 || threads < 1
+            || threads > MAX_THREADS) {
+        fprintf(stderr, "turns, playouts and threads must be at least "
+                "1 (and at most %d threads)\n", MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    if (argc > 5 && !readBoard(argv[5], disciplines, dice)) {
+        fprintf(stderr, "%s isn't a board\n", argv[5]);
+        return EXIT_FAILURE;
+    }
+    Game start = newGame(disciplines, dice);
+    Book b = newBook(hashBoard(disciplines, dice));
+
+    // the first wave is every first roll of the dice
+    positionList list = {NULL, 0, 0};
+    int score = 2;
+    while (score <= 12) {
+        Game g = cloneGame(start);
+        throwDice(g, score);
+        addPosition(&list, g);
+        score++;
+    }
+    removeRepeats(&list, b);
+
+    int waves = 0;
+    while (list.count > 0) {
+        printf("wave %d: %d positions\n", waves, list.count);
+        fflush(stdout);
+        macroAction *macros = malloc(list.count * sizeof(macroAction));
+        searchWave(&list, macros, playouts, threads);
+
+        positionList next = {NULL, 0, 0};
+        int i = 0;
+        while (i < list.count) {
+            bookAdd(b, list.positions[i].key, &macros[i], playouts);
+            followMacro(list.positions[i].g, &macros[i], turns, &next);
+            disposeGame(list.positions[i].g);
+            i++;
+        }
+        free(macros);
+        free(list.positions);
+
+        removeRepeats(&next, b);
+        list = next;
+        waves++;
+    }
+    free(list.positions);
+    disposeGame(start);
+
+    int saved = saveBook(b, argv[1]);
+    if (saved) {
+        printf("%d positions saved to %s\n", bookSize(b), argv[1]);
+    } else {
+        fprintf(stderr, "couldn't write %s\n", argv[1]);
+    }
+    disposeBook(b);
+
+    return saved ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+void searchWave(const positionList *list, macroAction macros[],
+        int playouts, int threads) {
+    wave w;
+    w.list = list;
+    w.macros = macros;
+    w.playouts = playouts;
+    w.next = 0;
+    pthread_mutex_init(&w.lock, NULL);
+
+    pthread_t ids[MAX_THREADS];
+    int i = 0;
+    while (i < threads) {
+        pthread_create(&ids[i], NULL, searchPositions, &w);
+        i++;
+    }
+    i = 0;
+    while (i < threads) {
+        pthread_join(ids[i], NULL);
+        i++;
+    }
+    pthread_mutex_destroy(&w.lock);
+}
+
+
+// Each thread only reads its own positions and writes its own
+// macros, so only taking the next position needs the lock
+void *searchPositions(void *arg) {
+    wave *w = arg;
+    int taken = TRUE;
+    while (taken) {
+        pthread_mutex_lock(&w->lock);
+        int i = w->next;
+        w->next++;
+        pthread_mutex_unlock(&w->lock);
+
+        taken = (i < w->list->count);
+        if (taken) {
+            const position *p = &w->list->positions[i];
+            Mcts m = newMcts(p->g, BOOK_TREE_NODES, p->key);
+            mctsChooseMacro(m, w->playouts, &w->macros[i]);
+            disposeMcts(m);
+        }
+    }
+    return NULL;
+}
+
+
+void addPosition(positionList *list, Game g) {
+    if (list->count == list->capacity) {
+        list->capacity = 2 * list->capacity + 1;
+        list->positions = realloc(list->positions,
+                list->capacity * sizeof(position));
+    }
+    list->positions[list->count].key = hashGame(g);
+    list->positions[list->count].g = g;
+    list->count++;
+}
+
+
+// Dice that give nobody anything lead to the same position, so
+// repeats are common
+void removeRepeats(positionList *list, Book b) {
+    qsort(list->positions, list->count, sizeof(position), compareKeys);
+    int kept = 0;
+    int i = 0;
+    while (i < list->count) {
+        position *p = &list->positions[i];
+        rolloutMove build;
+        if ((kept > 0 && list->positions[kept-1].key == p->key)
+                || bookLookup(b, p->key, &build, NULL)) {
+            disposeGame(p->g);
+        } else {
+            list->positions[kept] = *p;
+            kept++;
+        }
+        i++;
+    }
+    list->count = kept;
+}
+
+
+int compareKeys(const void *a, const void *b) {
+    uint64_t keyA = ((const position *)a)->key;
+    uint64_t keyB = ((const position *)b)->key;
+    return (keyA > keyB) - (keyA < keyB);
+}
+
+
+void followMacro(Game g, const macroAction *macro, int turns,
+        positionList *next) {
+    int last = macro->numActions - 1;
+    int actionCode = macro->actions[last].actionCode;
+    if (actionCode == PASS) {
+        if (getTurnNumber(g) + 1 < turns) {
+            int score = 2;
+            while (score <= 12) {
+                Game thrown = cloneGame(g);
+                throwDice(thrown, score);
+                addPosition(next, thrown);
+                score++;
+            }
+        }
+    } else {
+        int outcomes[] = {actionCode, -1};
+        if (actionCode == START_SPINOFF) {
+            outcomes[0] = OBTAIN_PUBLICATION;
+            outcomes[1] = OBTAIN_IP_PATENT;
+        }
+        int i = 0;
+        while (i < 2 && outcomes[i] != -1) {
+            macroAction made = *macro;
+            made.actions[last].actionCode = outcomes[i];
+            Game after = cloneGame(g);
+            if (makeMacroAction(after, &made) == ALL_ACTIONS_APPLIED) {
+                addPosition(next, after);
+            } else {
+                fprintf(stderr, "the search chose an illegal action in "
+                        "position %016llx\n",
+                        (unsigned long long)hashGame(g));
+                disposeGame(after);
+            }
+            i++;
+        }
+    }
+}
+
+
+int readBoard(const char *fileName, int disciplines[], int dice[]) {
+    int read = FALSE;
+    FILE *file = fopen(fileName, "r");
+    if (file != NULL) {
+        char extra;
+        read = readRegions(file, "board", disciplines, STUDENT_THD,
+                STUDENT_MMONEY)
+            && readRegions(file, "dice", dice, 2, 12)
+            && fscanf(file, " %c", &extra) != 1;
+        fclose(file);
+    }
+    return read;
+}
+
+
+int readRegions(FILE *file, const char *label, int values[], int min,
+        int max) {
+    char word[8];
+    int read = fscanf(file, " %7s", word) == 1
+        && strcmp(word, label) == 0;
+    int region = 0;
+    while (region < NUM_REGIONS && read) {
+        read = fscanf(file, "%d", &values[region]) == 1
+            && values[region] >= min && values[region] <= max;
+        region++;
+    }
+    return read;
+}
@@ -0,0 +1,322 @@
+/*
+ * genTrainingData.c - plays greedy bots against each other on every
+ * core and writes out their positions for training
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * usage: genTrainingData shardPrefix [games] [threads] [shardMegabytes]
+ *
+ * threads defaults to one for each processor.
+ *
+ * Each thread plays games (see SelfPlay.h) on the default board, one
+ * after another, and hands each finished game to a writer thread
+ * through a queue. The writer puts the games into shard files named
+ * shardPrefix-00000.shard, shardPrefix-00001.shard and so on, starting
+ * a new one before a game would take a shard past shardMegabytes. So
+ * the players only ever wait for the disk if the writer falls a whole
+ * queue of games behind.
+ *
+ * Game n is played with seed n, so the same games come out however
+ * many threads play them, but they go into the shards in the order
+ * they finish in.
+ */
+
+// for clock_gettime() and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "SelfPlay.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define DEFAULT_GAMES 1000
+#define DEFAULT_SHARD_MEGABYTES 64
+#define MAX_THREADS 64
+#define MEGABYTE (1024L * 1024L)
+
+// how many finished games can wait for the writer
+#define QUEUE_GAMES 256
+
+// the writer says how far it's got every this many games
+#define REPORT_GAMES 1000
+
+#define MAX_SHARD_NAME 4096
+
+
+// what the players and the writer share. Everything after the lock
+// is only touched with it held
+typedef struct _pipeline {
+    const rollout *start;
+    int games;
+
+    const char *prefix;
+    long shardBytes;
+    int *discipline;
+    int *dice;
+
+    pthread_mutex_t lock;
+    pthread_cond_t notEmpty;
+    pthread_cond_t notFull;
+
+    // the next game nobody has taken yet, and how many players are
+    // still playing
+    int nextGame;
+    int playing;
+
+    // the finished games waiting for the writer, oldest at first
+    selfPlayResult queue[QUEUE_GAMES];
+    int first;
+    int waiting;
+} pipeline;
+
+// what the writer has written
+typedef struct _tally {
+    int games;
+    long positions;
+    int shards;
+    int wins[NUM_UNIS + 1];
+    int failed;
+} tally;
+
+
+// what each player thread runs, playing games until there are none
+// left
+void *playGames(void *arg);
+
+// what the writer thread runs, writing games until the players have
+// all finished and the queue is empty
+void *writeGames(void *arg);
+
+// start a new shard, numbered from 0
+Shard startShard(pipeline *p, int number);
+
+double secondsSince(const struct timespec *start);
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 5) {
+        fprintf(stderr, "usage: %s shardPrefix [games] [threads] "
+                "[shardMegabytes]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    int games = DEFAULT_GAMES;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int megabytes = DEFAULT_SHARD_MEGABYTES;
+    if (argc > 2) {
+        games = atoi(argv[2]);
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (argc > 3) {
+        threads = atoi(argv[3]);
+    }
+    if (argc > 4) {
+        megabytes = atoi(argv[4]);
+    }
+    if (games < 1 || threads < 1 || threads > MAX_THREADS
+            || megabytes < 1) {
+        fprintf(stderr, "games, threads and shardMegabytes must be at "
+                "least 1 (and at most %d threads)\n", MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rollout start;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&start, &board, g, 0);
+    disposeGame(g);
+
+    pipeline p;
+    memset(&p, 0, sizeof(pipeline));
+    p.start = &start;
+    p.games = games;
+    p.prefix = argv[1];
+    p.shardBytes = megabytes * MEGABYTE;
+    p.discipline = disciplines;
+    p.dice = dice;
+    p.playing = threads;
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.notEmpty, NULL);
+    pthread_cond_init(&p.notFull, NULL);
+
+    struct timespec began;
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    tally t;
+    pthread_t writer;
+    pthread_create(&writer, NULL, writeGames, &p);
+    pthread_t players[MAX_THREADS];
+    int i = 0;
+    while (i < threads) {
+        pthread_create(&players[i], NULL, playGames, &p);
+        i++;
+    }
+    i = 0;
+    while (i < threads) {
+        pthread_join(players[i], NULL);
+        i++;
+    }
+    void *written;
+    pthread_join(writer, &written);
+    t = *(tally *)written;
+    free(written);
+    double seconds = secondsSince(&began);
+
+    pthread_cond_destroy(&p.notFull);
+    pthread_cond_destroy(&p.notEmpty);
+    pthread_mutex_destroy(&p.lock);
+
+    printf("%d games, %ld positions in %d shards, %.1f seconds "
+            "(%.0f games/sec, %.0f positions/sec)\n", t.games,
+            t.positions, t.shards, seconds, t.games / seconds,
+            t.positions / seconds);
+    printf("wins: A %d, B %d, C %d, drawn %d\n", t.wins[UNI_A],
+            t.wins[UNI_B], t.wins[UNI_C], t.wins[NO_ONE]);
+    if (t.failed) {
+        fprintf(stderr, "couldn't write every shard\n");
+    }
+
+    return t.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+void *playGames(void *arg) {
+    pipeline *p = arg;
+    double weights[NUM_GREEDY_WEIGHTS];
+    defaultGreedyWeights(weights);
+    const double *everyone[NUM_UNIS] = {weights, weights, weights};
+
+    int taken = TRUE;
+    while (taken) {
+        pthread_mutex_lock(&p->lock);
+        int game = p->nextGame;
+        p->nextGame++;
+        pthread_mutex_unlock(&p->lock);
+
+        taken = (game < p->games);
+        if (taken) {
+            selfPlayResult result;
+            selfPlayGame(p->start, everyone, SELF_PLAY_EXPLORE, game,
+                    TRUE, &result);
+
+            pthread_mutex_lock(&p->lock);
+            while (p->waiting == QUEUE_GAMES) {
+                pthread_cond_wait(&p->notFull, &p->lock);
+            }
+            p->queue[(p->first + p->waiting) % QUEUE_GAMES] = result;
+            p->waiting++;
+            pthread_cond_signal(&p->notEmpty);
+            pthread_mutex_unlock(&p->lock);
+        }
+    }
+
+    pthread_mutex_lock(&p->lock);
+    p->playing--;
+    pthread_cond_signal(&p->notEmpty);
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+
+// Only taking a game off the queue needs the lock, the writing is
+// done without it so the players can keep adding games
+void *writeGames(void *arg) {
+    pipeline *p = arg;
+    tally *t = malloc(sizeof(tally));
+    memset(t, 0, sizeof(tally));
+    Shard s = NULL;
+
+    int finished = FALSE;
+    while (!finished) {
+        pthread_mutex_lock(&p->lock);
+        while (p->waiting == 0 && p->playing > 0) {
+            pthread_cond_wait(&p->notEmpty, &p->lock);
+        }
+        finished = (p->waiting == 0);
+        selfPlayResult result;
+        if (!finished) {
+            result = p->queue[p->first];
+            p->first = (p->first + 1) % QUEUE_GAMES;
+            p->waiting--;
+            pthread_cond_signal(&p->notFull);
+        }
+        pthread_mutex_unlock(&p->lock);
+
+        if (!finished) {
+            long bytes = result.numRecords * (long)sizeof(trainingRecord);
+            if (s != NULL && shardBytes(s) + bytes > p->shardBytes
+                    && shardBytes(s) > (long)sizeof(shardHeader)) {
+                t->failed |= !closeShard(s);
+                s = NULL;
+            }
+            if (s == NULL) {
+                s = startShard(p, t->shards);
+                t->shards++;
+            }
+            if (s == NULL || !shardWrite(s, result.records,
+                        result.numRecords)) {
+                t->failed = TRUE;
+            }
+
+            t->games++;
+            t->positions += result.numRecords;
+            t->wins[result.winner]++;
+            if (t->games % REPORT_GAMES == 0) {
+                printf("%d games, %ld positions\n", t->games,
+                        t->positions);
+                fflush(stdout);
+            }
+            disposeSelfPlayRecords(&result);
+        }
+    }
+
+    if (s != NULL) {
+        t->failed |= !closeShard(s);
+    }
+    return t;
+}
+
+
+Shard startShard(pipeline *p, int number) {
+    char name[MAX_SHARD_NAME];
+    snprintf(name, MAX_SHARD_NAME, "%s-%05d.shard", p->prefix, number);
+    Shard s = newShard(name, p->discipline, p->dice);
+    if (s == NULL) {
+        fprintf(stderr, "couldn't create %s\n", name);
+    }
+    return s;
+}
+
+
+double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec)
+        + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
@@ -6,6 +6,12 @@
  * 
  * Action codes will be determined by scanf's
  * 
+ * usage: runGame [replayFile]
+ * 
+ * Every throw of the dice and action is recorded, and if a replayFile
+ * is given the game is saved there as a replay (see Replay.h) once
+ * someone wins.
+ * 
 */
 
 #include <stdio.h>
@@ -13,6 +19,7 @@
 #include <string.h>
 #include <time.h>
 #include "Game.h"
+#include "Replay.h"
 
 
 #define DEFAULT_DISCIPLINES { \
@@ -45,11 +52,14 @@ int main (int argc, char *argv[]){
     int disciplines[] = DEFAULT_DISCIPLINES;
     int dice[] = DEFAULT_DICE;
     Game g = newGame(disciplines, dice);
+    Replay r = newReplay(disciplines, dice);
 
     int hasWinner = FALSE;
     int winner = NO_ONE;
     while (hasWinner == FALSE) {
-        throwDice(g, (rand()%6 + rand()%6 + 2));
+        int diceScore = rand()%6 + rand()%6 + 2;
+        throwDice(g, diceScore);
+        recordThrow(r, diceScore);
         printf("Player %d's turn\n", getWhoseTurn(g));
         printResources(g, getWhoseTurn(g));
 
@@ -71,6 +81,7 @@ int main (int argc, char *argv[]){
 
         // make their action and check if they won
         makeAction(g, a);
+        recordAction(r, a);
         if (getKPIpoints(g, getWhoseTurn(g)) >= 150) {
             hasWinner = TRUE;
             winner = getWhoseTurn(g);
@@ -79,6 +90,12 @@ int main (int argc, char *argv[]){
 
     printf("Player %d won\n", winner);
 
+    if (argc > 1 && saveReplay(r, argv[1]) == FALSE) {
+        fprintf(stderr, "couldn't save the replay to %s\n", argv[1]);
+    }
+    disposeReplay(r);
+    disposeGame(g);
+
     return EXIT_SUCCESS;
 }
 
@@ -86,6 +103,9 @@ int main (int argc, char *argv[]){
 // ask the user for an action
 action getAction(void) {
     action a;
+    a.destination[0] = '\0';
+    a.disciplineFrom = 0;
+    a.disciplineTo = 0;
 
     printf("Enter an action to perform: ");
     scanf("%d", &(a.actionCode));
@@ -0,0 +1,100 @@
+/*
+ * testArena.c - checks the bump allocator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+#include "Arena.h"
+
+
+#define CAPACITY 1024
+
+
+void testAlloc(void);
+void testFull(void);
+void testMarkAndReset(void);
+
+
+int main(int argc, char *argv[]) {
+    testAlloc();
+    testFull();
+    testMarkAndReset();
+
+    printf("All arena tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// Blocks are aligned, don't overlap and come one after another when
+// their sizes are multiples of the alignment
+void testAlloc(void) {
+    printf("Testing allocation\n");
+    Arena a = newArena(CAPACITY);
+    assert(arenaCapacity(a) == CAPACITY);
+    assert(arenaUsed(a) == 0);
+
+    char *first = arenaAlloc(a, 3);
+    char *second = arenaAlloc(a, 5);
+    assert(first == arenaStart(a));
+    assert((uintptr_t)second % ARENA_ALIGNMENT == 0);
+    assert(second >= first + 3);
+    memset(first, 'a', 3);
+    memset(second, 'b', 5);
+    assert(first[2] == 'a');
+    assert(arenaUsed(a) == ARENA_ALIGNMENT + 5);
+
+    char *third = arenaAlloc(a, 2 * ARENA_ALIGNMENT);
+    char *fourth = arenaAlloc(a, ARENA_ALIGNMENT);
+    assert(fourth == third + 2 * ARENA_ALIGNMENT);
+
+    disposeArena(a);
+}
+
+
+// a full arena says so, and still has what fits
+void testFull(void) {
+    printf("Testing a full arena\n");
+    Arena a = newArena(CAPACITY);
+
+    assert(arenaAlloc(a, CAPACITY + 1) == NULL);
+    assert(arenaUsed(a) == 0);
+    assert(arenaAlloc(a, CAPACITY - 1) != NULL);
+    assert(arenaAlloc(a, 1) == NULL);
+    assert(arenaUsed(a) == CAPACITY - 1);
+
+    arenaReset(a);
+    assert(arenaAlloc(a, CAPACITY) == arenaStart(a));
+    assert(arenaAlloc(a, 0) != NULL);
+    assert(arenaAlloc(a, 1) == NULL);
+
+    disposeArena(a);
+}
+
+
+// releasing to a mark gives back the same memory again, and the peak
+// remembers the most ever used
+void testMarkAndReset(void) {
+    printf("Testing marks and resets\n");
+    Arena a = newArena(CAPACITY);
+
+    arenaAlloc(a, 100);
+    size_t mark = arenaMark(a);
+    void *after = arenaAlloc(a, 200);
+    assert(arenaUsed(a) > mark);
+    arenaRelease(a, mark);
+    assert(arenaUsed(a) == mark);
+    assert(arenaAlloc(a, 200) == after);
+    size_t peak = arenaPeak(a);
+    assert(peak == arenaUsed(a));
+
+    arenaReset(a);
+    assert(arenaUsed(a) == 0);
+    assert(arenaPeak(a) == peak);
+    assert(arenaAlloc(a, 8) == arenaStart(a));
+    assert(arenaPeak(a) == peak);
+
+    disposeArena(a);
+}
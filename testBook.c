@@ -0,0 +1,225 @@
+/*
+ * testBook.c - checks the opening book
+ *
+ * Writes a book file in the current directory and removes it again.
+ */
+
+// for truncate()
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "Book.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define BOOK_FILE "testBook.tmp"
+
+// enough positions that the table has to grow a few times
+#define NUM_POSITIONS 5000
+
+#define TEST_BOARD 1917
+
+
+void testAddAndLookup(void);
+void testSaveAndLoad(void);
+void testBadFiles(void);
+void testGameMacro(void);
+
+// a book with NUM_POSITIONS made up positions in it
+Book makeTestBook(void);
+
+// the made up key and purchase of position i
+uint64_t testKey(int i);
+macroAction testMacro(int i);
+
+
+int main(int argc, char *argv[]) {
+    testAddAndLookup();
+    testSaveAndLoad();
+    testBadFiles();
+    testGameMacro();
+
+    printf("All book tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// Every position added can be found, replacing one doesn't count it
+// twice, and a position never added isn't there
+void testAddAndLookup(void) {
+    printf("Testing adding and looking up\n");
+    Book b = makeTestBook();
+    assert(bookSize(b) == NUM_POSITIONS);
+    assert(bookBoard(b) == TEST_BOARD);
+
+    int i = 0;
+    while (i < NUM_POSITIONS) {
+        rolloutMove build;
+        int playouts;
+        assert(bookLookup(b, testKey(i), &build, &playouts));
+        assert(build.actionCode == OBTAIN_ARC);
+        assert(build.target == i % NUM_EDGES);
+        assert(playouts == i);
+        i++;
+    }
+
+    macroAction pass = {.numActions = 1,
+        .actions = {{.actionCode = PASS}}};
+    bookAdd(b, testKey(0), &pass, 1);
+    assert(bookSize(b) == NUM_POSITIONS);
+    rolloutMove build;
+    assert(bookLookup(b, testKey(0), &build, NULL));
+    assert(build.actionCode == PASS);
+    assert(!bookLookup(b, testKey(NUM_POSITIONS), &build, NULL));
+
+    // 0 is what an empty slot holds, but it's a key like any other
+    assert(!bookLookup(b, 0, &build, NULL));
+    bookAdd(b, 0, &pass, 1);
+    assert(bookLookup(b, 0, &build, NULL));
+
+    disposeBook(b);
+}
+
+
+void testSaveAndLoad(void) {
+    printf("Testing saving and loading\n");
+    Book b = makeTestBook();
+    assert(saveBook(b, BOOK_FILE));
+    disposeBook(b);
+
+    Book loaded = loadBook(BOOK_FILE);
+    assert(loaded != NULL);
+    assert(bookSize(loaded) == NUM_POSITIONS);
+    assert(bookBoard(loaded) == TEST_BOARD);
+    int i = 0;
+    while (i < NUM_POSITIONS) {
+        rolloutMove build;
+        assert(bookLookup(loaded, testKey(i), &build, NULL));
+        assert(build.target == i % NUM_EDGES);
+        i++;
+    }
+
+    disposeBook(loaded);
+    remove(BOOK_FILE);
+}
+
+
+// a missing file, something that isn't a book and a book cut short
+// all fail to load
+void testBadFiles(void) {
+    printf("Testing files that aren't books\n");
+    remove(BOOK_FILE);
+    assert(loadBook(BOOK_FILE) == NULL);
+
+    FILE *file = fopen(BOOK_FILE, "wb");
+    fprintf(file, "this is not a book, but it is long enough to have "
+            "what could be a header\n");
+    fclose(file);
+    assert(loadBook(BOOK_FILE) == NULL);
+
+    Book b = makeTestBook();
+    assert(saveBook(b, BOOK_FILE));
+    disposeBook(b);
+    file = fopen(BOOK_FILE, "r+b");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    assert(truncate(BOOK_FILE, size - 1) == 0);
+    assert(loadBook(BOOK_FILE) == NULL);
+
+    remove(BOOK_FILE);
+}
+
+
+// A position added from a game is found from the game again, with
+// the retraining to pay for it, and nowhere else
+void testGameMacro(void) {
+    printf("Testing macro actions for a game\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Book b = newBook(hashBoard(disciplines, dice));
+    assert(bookBoard(b) == hashBoard(disciplines, dice));
+
+    int turn = 0;
+    while (turn < 12) {
+        throwDice(g, 6 + turn % 3);
+        turn++;
+    }
+    macroAction macros[MAX_MACROS];
+    int count = getMacroActions(g, macros);
+    macroAction *chosen = &macros[count-1];
+    assert(chosen->actions[chosen->numActions-1].actionCode != PASS);
+    bookAdd(b, hashGame(g), chosen, 1);
+
+    macroAction found;
+    assert(bookGameMacro(b, g, &found));
+    assert(found.numActions == chosen->numActions);
+    int i = 0;
+    while (i < found.numActions) {
+        assert(found.actions[i].actionCode
+                == chosen->actions[i].actionCode);
+        assert(strcmp(found.actions[i].destination,
+                    chosen->actions[i].destination) == 0);
+        i++;
+    }
+
+    action *bought = &found.actions[found.numActions-1];
+    if (bought->actionCode == START_SPINOFF) {
+        bought->actionCode = OBTAIN_PUBLICATION;
+    }
+    assert(makeMacroAction(g, &found) == ALL_ACTIONS_APPLIED);
+    assert(!bookGameMacro(b, g, &found));
+
+    disposeBook(b);
+    disposeGame(g);
+}
+
+
+Book makeTestBook(void) {
+    Book b = newBook(TEST_BOARD);
+    int i = 0;
+    while (i < NUM_POSITIONS) {
+        macroAction macro = testMacro(i);
+        bookAdd(b, testKey(i), &macro, i);
+        i++;
+    }
+    return b;
+}
+
+
+uint64_t testKey(int i) {
+    return (i + 1) * 0x9E3779B97F4A7C15ULL;
+}
+
+
+macroAction testMacro(int i) {
+    macroAction macro;
+    memset(&macro, 0, sizeof(macroAction));
+    macro.numActions = 1;
+    macro.actions[0].actionCode = OBTAIN_ARC;
+    strcpy(macro.actions[0].destination, pathOfEdge(i % NUM_EDGES));
+    return macro;
+}
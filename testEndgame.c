@@ -0,0 +1,211 @@
+/*
+ * testEndgame.c - checks the endgame solver
+ *
+ * Positions are made in Game.c and then moved closer to the end by
+ * handing out KPI points in the rollout, which doesn't change what is
+ * legal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+#include "Forecast.h"
+#include "Endgame.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define BIG_BUDGET 2000000
+#define SMALL_BUDGET 20
+
+
+void testTerraNullis(void);
+void testWinningNow(void);
+void testLosing(void);
+void testBudget(void);
+void testDeeper(void);
+
+// a game a few turns in, UNI_A to play
+Game makeTestGame(void);
+
+
+int main(int argc, char *argv[]) {
+    testTerraNullis();
+    testWinningNow();
+    testLosing();
+    testBudget();
+    testDeeper();
+
+    printf("All endgame tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testTerraNullis(void) {
+    printf("Testing the endgame in Terra Nullis\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Endgame e = newEndgame(BIG_BUDGET);
+    endgameResult result;
+
+    solveGameEndgame(e, g, 2, &result);
+    assert(result.plan.numMoves == 0);
+    assert(result.turnsSearched == 0);
+    assert(result.nodes == 0);
+
+    disposeEndgame(e);
+    disposeGame(g);
+}
+
+
+// Two KPI short with an ARC to buy wins this turn, without looking any
+// further, and the plan to do it is legal
+void testWinningNow(void) {
+    printf("Testing a win this turn\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    r.kpi[UNI_A-1] = WINNING_KPI - ARC_KPI;
+    assert(isEndgame(&r, UNI_A));
+    assert(!isEndgame(&r, UNI_B));
+
+    Endgame e = newEndgame(BIG_BUDGET);
+    endgameResult result;
+    solveEndgame(e, &r, 2, &result);
+    assert(result.winChance == 1);
+    assert(result.turnsSearched == 1);
+    assert(result.plan.numMoves > 0);
+
+    int i = 0;
+    while (i < result.plan.numMoves) {
+        assert(isLegalAction(g, result.plan.actions[i]));
+        makeAction(g, result.plan.actions[i]);
+        rolloutMakeMove(&r, &result.plan.moves[i]);
+        i++;
+    }
+    assert(r.kpi[UNI_A-1] >= WINNING_KPI);
+
+    disposeEndgame(e);
+    disposeGame(g);
+}
+
+
+// with nothing to build and UNI_B a step from winning with plenty of
+// students, UNI_A has next to no chance
+void testLosing(void) {
+    printf("Testing a lost position\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    memset(r.students[UNI_A-1], 0, sizeof(r.students[UNI_A-1]));
+    r.kpi[UNI_B-1] = WINNING_KPI - ARC_KPI;
+    r.students[UNI_B-1][STUDENT_BPS] += 10;
+    r.students[UNI_B-1][STUDENT_BQN] += 10;
+
+    Endgame e = newEndgame(BIG_BUDGET);
+    endgameResult result;
+    solveEndgame(e, &r, 1, &result);
+    assert(result.turnsSearched == 1);
+    assert(result.winChance == 0);
+    assert(result.plan.numMoves == 0);
+
+    disposeEndgame(e);
+    disposeGame(g);
+}
+
+
+// the budget is never overspent, and running out of it still gives a
+// plan to play
+void testBudget(void) {
+    printf("Testing the node budget\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    r.kpi[UNI_A-1] = WINNING_KPI - ENDGAME_KPI;
+
+    Endgame e = newEndgame(SMALL_BUDGET);
+    endgameResult result;
+    solveEndgame(e, &r, MAX_ENDGAME_TURNS, &result);
+    assert(result.nodes <= SMALL_BUDGET);
+    assert(result.turnsSearched < MAX_ENDGAME_TURNS);
+    assert(result.winChance >= 0 && result.winChance <= 1);
+
+    // the planner's plan stands in for a search that didn't finish
+    Planner p = newPlanner();
+    turnPlan plan;
+    planTurn(p, &r, NULL, NULL, &plan);
+    if (result.turnsSearched == 0) {
+        assert(result.plan.numMoves == plan.numMoves);
+    }
+
+    disposePlanner(p);
+    disposeEndgame(e);
+    disposeGame(g);
+}
+
+
+// A longer search finishes inside the budget, agrees with itself when
+// asked again (from the table) and is a chance
+void testDeeper(void) {
+    printf("Testing a deeper search\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    r.kpi[UNI_A-1] = WINNING_KPI - 25;
+    r.kpi[UNI_B-1] = WINNING_KPI - 25;
+
+    Endgame e = newEndgame(BIG_BUDGET);
+    endgameResult first;
+    solveEndgame(e, &r, 2, &first);
+    assert(first.turnsSearched == 2);
+    assert(first.winChance > 0 && first.winChance < 1);
+
+    endgameResult again;
+    solveEndgame(e, &r, 2, &again);
+    assert(again.winChance == first.winChance);
+    assert(again.nodes < first.nodes);
+
+    disposeEndgame(e);
+    disposeGame(g);
+}
+
+
+Game makeTestGame(void) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    int turn = 0;
+    while (turn < 10) {
+        throwDice(g, 6 + turn % 3);
+        turn++;
+    }
+    assert(getWhoseTurn(g) == UNI_A);
+    return g;
+}
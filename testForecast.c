@@ -0,0 +1,361 @@
+/*
+ * testForecast.c - checks the student forecasts
+ *
+ * For a few rolls every sequence of dice can be played through Game.c
+ * directly, which gives the exact answer to check the forecast with.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Forecast.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+// the board from Game.h, which has a 7 on the THD region
+#define SEVEN_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  7,  9,  2,  8, 10, \
+    5 }
+
+// a vertex on the THD region in the layouts above
+#define SEVEN_SPOT "LRRL"
+
+#define MAX_EXACT_ROLLS 3
+#define TOLERANCE 1e-12
+
+// the smallest spread estimateWin() gives
+#define MIN_TEST_SPREAD 0.5
+
+
+void testProduction(void);
+void testNoRolls(void);
+void testAgainstGame(void);
+void testLongForecast(void);
+void testTurnsToWin(void);
+void testWinChances(void);
+
+// a game where UNI_A has a GO8 on the THD region (which produces on a
+// 7) as well as its two campuses
+Game makeTestGame(void);
+
+// make sure UNI_A has at least n students of the discipline
+void earnStudents(Game g, int discipline, int n);
+
+// add chance to exact[][] for every way the next rolls can go
+void enumerateRolls(Game g, int player, int rolls, double chance,
+        double exact[NUM_DISCIPLINES][FORECAST_CAP]);
+
+
+int main(int argc, char *argv[]) {
+    testProduction();
+    testNoRolls();
+    testAgainstGame();
+    testLongForecast();
+    testTurnsToWin();
+    testWinChances();
+
+    printf("All forecast tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// what each score adds is what throwing it gives, before any 7
+void testProduction(void) {
+    printf("Testing production\n");
+    Game g = makeTestGame();
+    int production[NUM_DICE_SCORES][NUM_DISCIPLINES];
+    getProduction(g, UNI_A, production);
+    assert(production[7][STUDENT_THD] == 2);
+
+    int score = 2;
+    while (score <= 12) {
+        Game next = cloneGame(g);
+        throwDice(next, score);
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            int gained = getStudents(next, UNI_A, discipline)
+                - getStudents(g, UNI_A, discipline);
+            if (score != 7) {
+                assert(gained == production[score][discipline]);
+            }
+            discipline++;
+        }
+        disposeGame(next);
+        score++;
+    }
+
+    double total = 0;
+    score = 0;
+    while (score < NUM_DICE_SCORES) {
+        total += getDiceChance(score);
+        score++;
+    }
+    assert(fabs(total - 1) < TOLERANCE);
+    assert(getDiceChance(0) == 0 && getDiceChance(1) == 0);
+    assert(getDiceChance(7) == 6.0 / 36);
+    disposeGame(g);
+}
+
+
+void testNoRolls(void) {
+    printf("Testing a forecast for no rolls\n");
+    Game g = makeTestGame();
+    studentForecast forecast;
+    forecastStudents(g, UNI_A, 0, &forecast);
+
+    assert(forecast.rolls == 0);
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        int now = getStudents(g, UNI_A, discipline);
+        assert(forecast.chance[discipline][now] == 1);
+        assert(chanceOfAtLeast(&forecast, discipline, now) == 1);
+        assert(chanceOfAtLeast(&forecast, discipline, now + 1) == 0);
+        assert(expectedStudents(&forecast, discipline) == now);
+        discipline++;
+    }
+    disposeGame(g);
+}
+
+
+// every discipline, 7s and all, matches playing out every roll
+void testAgainstGame(void) {
+    printf("Testing forecasts against Game.c\n");
+    Game g = makeTestGame();
+
+    int rolls = 1;
+    while (rolls <= MAX_EXACT_ROLLS) {
+        double exact[NUM_DISCIPLINES][FORECAST_CAP];
+        memset(exact, 0, sizeof(exact));
+        enumerateRolls(g, UNI_A, rolls, 1, exact);
+
+        studentForecast forecast;
+        forecastStudents(g, UNI_A, rolls, &forecast);
+        assert(forecast.rolls == rolls);
+
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            int n = 0;
+            while (n < FORECAST_CAP) {
+                assert(fabs(forecast.chance[discipline][n]
+                            - exact[discipline][n]) < TOLERANCE);
+                n++;
+            }
+            discipline++;
+        }
+        rolls++;
+    }
+    disposeGame(g);
+}
+
+
+// long forecasts still add up to 1 and the cap catches the tail
+void testLongForecast(void) {
+    printf("Testing a long forecast\n");
+    Game g = makeTestGame();
+    studentForecast forecast;
+    forecastStudents(g, UNI_A, 60, &forecast);
+
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        double total = chanceOfAtLeast(&forecast, discipline, 0);
+        assert(fabs(total - 1) < 1e-9);
+        discipline++;
+    }
+
+    // MTV can never build up past what comes between two 7s, so it
+    // stays small while THD soaks up the rest
+    assert(expectedStudents(&forecast, STUDENT_MTV)
+            < expectedStudents(&forecast, STUDENT_THD));
+    assert(forecast.chance[STUDENT_THD][FORECAST_CAP - 1] > 0);
+
+    // more rolls never make having some number of MJ less likely
+    studentForecast shorter;
+    forecastStudents(g, UNI_A, 10, &shorter);
+    assert(chanceOfAtLeast(&forecast, STUDENT_MJ, 2)
+            >= chanceOfAtLeast(&shorter, STUDENT_MJ, 2));
+    disposeGame(g);
+}
+
+
+void testTurnsToWin(void) {
+    printf("Testing turns to win\n");
+    Game g = makeTestGame();
+    kpiOutlook outlook;
+    getKPIOutlook(g, UNI_A, &outlook);
+    assert(outlook.kpi == getKPIpoints(g, UNI_A));
+    assert(outlook.numGO8s == 1);
+    assert(outlook.playingNow == TRUE);
+
+    winEstimate estimate = estimateWin(&outlook);
+    assert(estimate.turns > 1 && estimate.turns < WIN_TURNS_CAP);
+    assert(estimate.spread > 0);
+    assert(turnsToWin(g, UNI_A) == estimate.turns);
+
+    // more students, more income or more KPI never take longer
+    kpiOutlook better = outlook;
+    better.students[STUDENT_MJ] += 10;
+    assert(estimateWin(&better).turns <= estimate.turns);
+    better = outlook;
+    better.kpi += 50;
+    assert(estimateWin(&better).turns < estimate.turns);
+    better = outlook;
+    int score = 2;
+    while (score <= 12) {
+        better.production[score][STUDENT_BQN]++;
+        score++;
+    }
+    assert(estimateWin(&better).turns < estimate.turns);
+
+    // a uni which has won needs no more turns, and one with nothing
+    // to spend never wins
+    better = outlook;
+    better.kpi = WINNING_KPI;
+    assert(estimateWin(&better).turns == 0);
+    kpiOutlook hopeless;
+    memset(&hopeless, 0, sizeof(hopeless));
+    assert(estimateWin(&hopeless).turns == WIN_TURNS_CAP);
+
+    // students only count on the first turn if the uni can spend them
+    better = outlook;
+    better.students[STUDENT_MJ] += 10;
+    better.students[STUDENT_MMONEY] += 10;
+    better.students[STUDENT_BPS] += 10;
+    better.students[STUDENT_BQN] += 10;
+    better.students[STUDENT_MTV] += 10;
+    kpiOutlook later = better;
+    later.playingNow = FALSE;
+    assert(estimateWin(&later).turns <= estimateWin(&better).turns);
+    disposeGame(g);
+}
+
+
+void testWinChances(void) {
+    printf("Testing win chances\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = SEVEN_DICE;
+    Game g = newGame(disciplines, dice);
+    double chance[NUM_UNIS];
+    getWinChances(g, chance);
+    assert(fabs(chance[0] + chance[1] + chance[2] - 1) < 1e-9);
+    disposeGame(g);
+
+    // with the same prospects, going first is worth something
+    winEstimate same[NUM_UNIS] = {{10, 2}, {10, 2}, {10, 2}};
+    winChancesFrom(same, UNI_B, chance);
+    assert(chance[UNI_B-1] > chance[UNI_C-1]);
+    assert(chance[UNI_C-1] > chance[UNI_A-1]);
+    assert(fabs(chance[0] + chance[1] + chance[2] - 1) < 1e-9);
+
+    // a uni well ahead nearly always wins, and one which has already
+    // won always does
+    winEstimate ahead[NUM_UNIS] = {{20, 2}, {5, 1}, {20, 2}};
+    winChancesFrom(ahead, UNI_A, chance);
+    assert(chance[UNI_B-1] > 0.99);
+    winEstimate won[NUM_UNIS] = {{10, 2}, {10, 2}, {0, MIN_TEST_SPREAD}};
+    winChancesFrom(won, UNI_A, chance);
+    assert(chance[UNI_C-1] > 0.99);
+
+    // nobody ever winning is shared out evenly
+    winEstimate never[NUM_UNIS] = {{WIN_TURNS_CAP, 0.5},
+        {WIN_TURNS_CAP, 0.5}, {WIN_TURNS_CAP, 0.5}};
+    winChancesFrom(never, UNI_A, chance);
+    assert(fabs(chance[0] + chance[1] + chance[2] - 1) < 1e-9);
+}
+
+
+Game makeTestGame(void) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = SEVEN_DICE;
+    Game g = newGame(disciplines, dice);
+    const char *arcs[] = {"L", "LR", "LRR", "LRRL"};
+    action a;
+
+    int i = 0;
+    while (i < 4) {
+        earnStudents(g, STUDENT_BPS, 1);
+        earnStudents(g, STUDENT_BQN, 1);
+        a.actionCode = OBTAIN_ARC;
+        strcpy(a.destination, arcs[i]);
+        assert(isLegalAction(g, a));
+        makeAction(g, a);
+        i++;
+    }
+
+    earnStudents(g, STUDENT_BPS, 1);
+    earnStudents(g, STUDENT_BQN, 1);
+    earnStudents(g, STUDENT_MTV, 1);
+    earnStudents(g, STUDENT_MJ, 1);
+    a.actionCode = BUILD_CAMPUS;
+    strcpy(a.destination, SEVEN_SPOT);
+    assert(isLegalAction(g, a));
+    makeAction(g, a);
+
+    earnStudents(g, STUDENT_MMONEY, 3);
+    earnStudents(g, STUDENT_MJ, 2);
+    a.actionCode = BUILD_GO8;
+    assert(isLegalAction(g, a));
+    makeAction(g, a);
+
+    return g;
+}
+
+
+// UNI_A makes MJ on a 6 and MTV on an 11, anything else it retrains
+// from MTV. Leaves it UNI_A's turn
+void earnStudents(Game g, int discipline, int n) {
+    while (getStudents(g, UNI_A, discipline) < n) {
+        if (discipline == STUDENT_MJ) {
+            throwDice(g, 6);
+        } else if (discipline == STUDENT_MTV) {
+            throwDice(g, 11);
+        } else {
+            while (getStudents(g, UNI_A, STUDENT_MTV) < 3
+                    || getWhoseTurn(g) != UNI_A) {
+                throwDice(g, 11);
+            }
+            action retrain = {.actionCode = RETRAIN_STUDENTS,
+                .disciplineFrom = STUDENT_MTV, .disciplineTo = discipline};
+            makeAction(g, retrain);
+        }
+    }
+    while (getWhoseTurn(g) != UNI_A) {
+        throwDice(g, 11);
+    }
+}
+
+
+void enumerateRolls(Game g, int player, int rolls, double chance,
+        double exact[NUM_DISCIPLINES][FORECAST_CAP]) {
+    if (rolls == 0) {
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            exact[discipline][getStudents(g, player, discipline)]
+                += chance;
+            discipline++;
+        }
+    } else {
+        int score = 2;
+        while (score <= 12) {
+            Game next = cloneGame(g);
+            throwDice(next, score);
+            enumerateRolls(next, player, rolls - 1,
+                    chance * getDiceChance(score), exact);
+            disposeGame(next);
+            score++;
+        }
+    }
+}
@@ -2,7 +2,10 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "Game.h"
+#include "GameEngine.h"
 
 
 #define DEFAULT_DISCIPLINES { \
@@ -36,7 +39,6 @@
     5 }
 
 #define INITIAL_TURN         (-1)
-#define NUM_DISCIPLINES      (6)
 #define MIN_DICE_VAL         (1)
 #define MAX_DICE_VAL         (6)
 #define NUM_DICE             (2)
@@ -56,6 +58,8 @@
 #define INITIAL_MTV          (1)
 #define INITIAL_MMONEY       (1)
 
+#define FEATURE_ROUNDING     (1e-4)
+
 #define INITIAL_STUDENTS_NUM { \
     INITIAL_THD,    INITIAL_BPS,    INITIAL_BQN, \
     INITIAL_MJ,     INITIAL_MTV ,   INITIAL_MMONEY }
@@ -86,6 +90,24 @@ void testGetPublications(void);     // JAMES
 void testGetStudents(void);         // TIM
 void testGetExchangeRate(void);     // CARL
 
+// tests for the engine extensions in GameEngine.h
+void testGetAffordableActions(void);
+void testCheckAction(void);
+void testPreviewAction(void);
+void testARCFromGO8(void);
+void testMostPublications(void);
+void testGO8Frontier(void);
+void testSetGameObserver(void);
+void testUncheckedAPI(void);
+void testCanonicalPaths(void);
+void testApplyActions(void);
+void testCloneGame(void);
+void testGamePublisher(void);
+void testNetworks(void);
+void testFrontiers(void);
+void testHashGame(void);
+void testGetFeatures(void);
+
 
 // helper functions to assist with testing
 void genResources(Game g, int count, int diceNum);
@@ -134,6 +156,22 @@ void beginTesting(void) {
     testGetExchangeRate();
     testIsLegalAction();
     testGetStudents();
+    testGetAffordableActions();
+    testCheckAction();
+    testPreviewAction();
+    testARCFromGO8();
+    testMostPublications();
+    testGO8Frontier();
+    testSetGameObserver();
+    testUncheckedAPI();
+    testCanonicalPaths();
+    testApplyActions();
+    testCloneGame();
+    testGamePublisher();
+    testNetworks();
+    testFrontiers();
+    testHashGame();
+    testGetFeatures();
 
     puts("Congrats, testing found no errors!");
 }
@@ -1357,6 +1395,1039 @@ void testGetExchangeRate(void) {
     disposeGame(g);
 }
 
+// returns a bitmask of the fixed cost actions the player can pay for
+void testGetAffordableActions(void) {
+    puts("Testing function getAffordableActions()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 2);
+
+    // everyone starts with enough for a campus, an ARC or a spinoff
+    // but not a GO8
+    int expected = (1 << PASS) | (1 << BUILD_CAMPUS) | (1 << OBTAIN_ARC)
+        | (1 << START_SPINOFF) | (1 << OBTAIN_PUBLICATION)
+        | (1 << OBTAIN_IP_PATENT);
+    assert(getAffordableActions(A, UNI_A) == expected);
+    assert(getAffordableActions(A, UNI_B) == expected);
+    assert(getAffordableActions(A, UNI_C) == expected);
+
+    // spending the only MJ rules out campuses and spinoffs
+    getPub(A, 1);
+    assert(getAffordableActions(A, UNI_A) 
+            == ((1 << PASS) | (1 << OBTAIN_ARC)));
+
+    // a 7 turns MTV and MMONEY into THD
+    throwDice(A, 7);
+    assert(getAffordableActions(A, UNI_B) 
+            == ((1 << PASS) | (1 << OBTAIN_ARC)));
+
+    // UNI_A's campuses are on an MJ 6 hex and an MTV 11 hex, so it
+    // can save up for a GO8 by retraining MTV into MMONEY
+    genResources(A, 3, 6);
+    genResources(A, 5, 11);
+    endTurn(A);
+    endTurn(A);
+    assert(getWhoseTurn(A) == UNI_A);
+    assert((getAffordableActions(A, UNI_A) & (1 << BUILD_GO8)) == 0);
+    retrain(A, STUDENT_MTV, STUDENT_MMONEY, 3);
+    assert(getAffordableActions(A, UNI_A) & (1 << BUILD_GO8));
+    assert((getAffordableActions(A, UNI_A) & (1 << RETRAIN_STUDENTS))
+            == 0);
+
+    disposeGame(A);
+}
+
+
+// says why an action is illegal, or LEGAL_ACTION
+void testCheckAction(void) {
+    puts("Testing function checkAction()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    action a = {.actionCode = OBTAIN_ARC};
+    strcpy(a.destination, "L");
+    assert(checkAction(A, &a) == ILLEGAL_TERRA_NULLIS);
+
+    throwDice(A, 2);
+    assert(checkAction(A, &a) == LEGAL_ACTION);
+
+    // bad action codes are caught before anything else
+    a.actionCode = OBTAIN_PUBLICATION;
+    assert(checkAction(A, &a) == ILLEGAL_ACTION_CODE);
+    a.actionCode = 8;
+    assert(checkAction(A, &a) == ILLEGAL_ACTION_CODE);
+    a.actionCode = -1;
+    assert(checkAction(A, &a) == ILLEGAL_ACTION_CODE);
+
+    // paths
+    a.actionCode = OBTAIN_ARC;
+    strcpy(a.destination, "LX");
+    assert(checkAction(A, &a) == ILLEGAL_PATH);
+    strcpy(a.destination, "RRRRRR");
+    assert(checkAction(A, &a) == ILLEGAL_PATH);
+    strcpy(a.destination, "");
+    assert(checkAction(A, &a) == ILLEGAL_PATH);
+    memset(a.destination, 'L', PATH_LIMIT);
+    assert(checkAction(A, &a) == ILLEGAL_PATH);
+
+    // ARCs must touch the player's network
+    strcpy(a.destination, "LRL");
+    assert(checkAction(A, &a) == ILLEGAL_NOT_CONNECTED);
+    strcpy(a.destination, "L");
+    makeAction(A, a);
+    assert(checkAction(A, &a) == ILLEGAL_OCCUPIED);
+
+    // campuses
+    a.actionCode = BUILD_CAMPUS;
+    strcpy(a.destination, "");
+    assert(checkAction(A, &a) == ILLEGAL_OCCUPIED);
+    strcpy(a.destination, "L");
+    assert(checkAction(A, &a) == ILLEGAL_TOO_CLOSE);
+    strcpy(a.destination, "LR");
+    assert(checkAction(A, &a) == ILLEGAL_NOT_CONNECTED);
+
+    // vertices on the coast have fewer neighbours
+    strcpy(a.destination, "RR");
+    assert(checkAction(A, &a) == ILLEGAL_NOT_CONNECTED);
+    strcpy(a.destination, "RRLR");
+    assert(checkAction(A, &a) == ILLEGAL_TOO_CLOSE);
+    strcpy(a.destination, "LR");
+    a.actionCode = OBTAIN_ARC;
+    makeAction(A, a);
+    a.actionCode = BUILD_CAMPUS;
+    assert(checkAction(A, &a) == LEGAL_ACTION);
+
+    // GO8s go on the player's own campuses
+    a.actionCode = BUILD_GO8;
+    strcpy(a.destination, "");
+    assert(checkAction(A, &a) == ILLEGAL_UNAFFORDABLE);
+
+    // retraining
+    a.actionCode = RETRAIN_STUDENTS;
+    a.disciplineFrom = STUDENT_THD;
+    a.disciplineTo = STUDENT_BPS;
+    assert(checkAction(A, &a) == ILLEGAL_DISCIPLINE);
+    a.disciplineFrom = STUDENT_BPS;
+    a.disciplineTo = 6;
+    assert(checkAction(A, &a) == ILLEGAL_DISCIPLINE);
+    a.disciplineTo = STUDENT_MJ;
+    assert(checkAction(A, &a) == ILLEGAL_UNAFFORDABLE);
+
+    a.actionCode = PASS;
+    assert(checkAction(A, &a) == LEGAL_ACTION);
+
+    disposeGame(A);
+}
+
+
+// reports what an action would change without changing the game
+void testPreviewAction(void) {
+    puts("Testing function previewAction()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 2);
+
+    // the first ARC brings the prestige award with it
+    action a = {.actionCode = OBTAIN_ARC};
+    strcpy(a.destination, "L");
+    actionDelta delta;
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_A-1] == ARC_KPI + PRESTIGE_BONUS);
+    assert(delta.kpi[UNI_B-1] == 0 && delta.kpi[UNI_C-1] == 0);
+    assert(delta.students[STUDENT_BPS] == -1);
+    assert(delta.students[STUDENT_BQN] == -1);
+    assert(delta.students[STUDENT_MJ] == 0);
+    assert(getKPIpoints(A, UNI_A) == 20 && getARCs(A, UNI_A) == 0);
+    makeAction(A, a);
+    assert(getKPIpoints(A, UNI_A) == 20 + ARC_KPI + PRESTIGE_BONUS);
+
+    // keeping the award doesn't pay the bonus again
+    strcpy(a.destination, "LR");
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_A-1] == ARC_KPI);
+    makeAction(A, a);
+
+    // a campus on "LR" sits on a BQN 4 hex and an MTV 11 hex
+    a.actionCode = BUILD_CAMPUS;
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_A-1] == CAMPUS_KPI);
+    assert(delta.students[STUDENT_MTV] == -1);
+    assert(delta.income[STUDENT_BQN] * 36 > 2.99);
+    assert(delta.income[STUDENT_BQN] * 36 < 3.01);
+    assert(delta.income[STUDENT_MTV] * 36 > 1.99);
+    assert(delta.income[STUDENT_MTV] * 36 < 2.01);
+    assert(delta.income[STUDENT_MJ] == 0);
+    makeAction(A, a);
+    int bqn = getStudents(A, UNI_A, STUDENT_BQN);
+    throwDice(A, 4);
+    assert(getStudents(A, UNI_A, STUDENT_BQN) == bqn + 1);
+
+    // UNI_B taking the ARC lead moves the bonus away from UNI_A
+    genResources(A, 1, 12);
+    assert(getWhoseTurn(A) == UNI_B);
+    a.actionCode = OBTAIN_ARC;
+    strcpy(a.destination, "RRLRL");
+    makeAction(A, a);
+    strcpy(a.destination, "RRLR");
+    makeAction(A, a);
+    strcpy(a.destination, "RRLL");
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_B-1] == ARC_KPI + PRESTIGE_BONUS);
+    assert(delta.kpi[UNI_A-1] == -PRESTIGE_BONUS);
+
+    // spinoffs give the expected KPI of the two outcomes
+    a.actionCode = START_SPINOFF;
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_B-1] > 9.99 && delta.kpi[UNI_B-1] < 10.01);
+    assert(delta.students[STUDENT_MMONEY] == -1);
+
+    disposeGame(A);
+}
+
+
+// upgrading a campus to a GO8 doesn't cut off the edges around it, an
+// ARC can still be built next to a GO8 with no ARC of its own
+void testARCFromGO8(void) {
+    puts("Testing ARCs next to a GO8...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    // UNI_A's campus on "" is on an MJ 6 hex, and retraining pays for
+    // the rest of the GO8
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 6);
+    retrain(A, STUDENT_BPS, STUDENT_MMONEY, 1);
+    retrain(A, STUDENT_BQN, STUDENT_MMONEY, 1);
+    action a = {.actionCode = BUILD_GO8};
+    assert(checkAction(A, &a) == LEGAL_ACTION);
+    buildGO8(A, "");
+    assert(getCampus(A, "") == GO8_A);
+    assert(getARCs(A, UNI_A) == 0);
+
+    // two rounds of MTV pay for an ARC next to it
+    genResources(A, 2, 11);
+    retrain(A, STUDENT_MTV, STUDENT_BPS, 1);
+    retrain(A, STUDENT_MTV, STUDENT_BQN, 1);
+    a.actionCode = OBTAIN_ARC;
+    strcpy(a.destination, "L");
+    assert(checkAction(A, &a) == LEGAL_ACTION);
+
+    // and only the player's own GO8 counts
+    endTurn(A);
+    assert(getWhoseTurn(A) == UNI_B);
+    assert(checkAction(A, &a) == ILLEGAL_NOT_CONNECTED);
+
+    endTurn(A);
+    endTurn(A);
+    buildARC(A, "L");
+    assert(getARC(A, "L") == ARC_A);
+
+    disposeGame(A);
+}
+
+
+// the most publications award pays PRESTIGE_BONUS to whoever goes past
+// the holder's count, and that includes the holder extending their
+// lead. previewAction() agrees with makeAction() about it
+void testMostPublications(void) {
+    puts("Testing the most publications award...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 2);
+    getPub(A, 1);
+    assert(getMostPublications(A) == UNI_A);
+    assert(getKPIpoints(A, UNI_A) == 20 + PRESTIGE_BONUS);
+
+    // extending the lead pays the bonus again
+    action a = {.actionCode = OBTAIN_PUBLICATION};
+    actionDelta delta;
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_A-1] == PRESTIGE_BONUS);
+    getPub(A, 2);
+    assert(getPublications(A, UNI_A) == 3);
+    assert(getKPIpoints(A, UNI_A) == 20 + 3 * PRESTIGE_BONUS);
+
+    // drawing level isn't enough to take it, going past is
+    throwDice(A, 2);
+    getPub(A, 3);
+    assert(getMostPublications(A) == UNI_A);
+    previewAction(A, &a, &delta);
+    assert(delta.kpi[UNI_B-1] == PRESTIGE_BONUS);
+    assert(delta.kpi[UNI_A-1] == -PRESTIGE_BONUS);
+    getPub(A, 1);
+    assert(getMostPublications(A) == UNI_B);
+    assert(getKPIpoints(A, UNI_A) == 20 + 2 * PRESTIGE_BONUS);
+    assert(getKPIpoints(A, UNI_B) == 20 + PRESTIGE_BONUS);
+
+    disposeGame(A);
+}
+
+
+// a GO8 keeps the ARC frontier its campus had, and only for its owner
+void testGO8Frontier(void) {
+    puts("Testing the ARC frontier next to a GO8...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 2);
+    edgeSet before = getARCFrontier(A, UNI_A);
+    buildGO8(A, "");
+    assert(getCampus(A, "") == GO8_A);
+    assert(getARCs(A, UNI_A) == 0);
+
+    // the GO8 was paid for out of MJs and MMONEYs A didn't have, so
+    // the ARC frontier says where an ARC would be connected
+    edgeSet arcs = getARCFrontier(A, UNI_A);
+    assert(edgeSetHas(&arcs, edgeOfPath("L")));
+    assert(edgeSetHas(&arcs, edgeOfPath("R")));
+    assert(memcmp(&arcs, &before, sizeof(edgeSet)) == 0);
+
+    // and only the player's own GO8 counts
+    arcs = getARCFrontier(A, UNI_B);
+    assert(!edgeSetHas(&arcs, edgeOfPath("L")));
+
+    disposeGame(A);
+}
+
+
+// what the test observer has been told
+typedef struct _eventLog {
+    int campuses;
+    int go8s;
+    int arcs;
+    int rolls;
+    int produced[NUM_UNIS][NUM_DISCIPLINES];
+    int converted[NUM_UNIS];
+    int transfers;
+    int lastFrom;
+    int lastTo;
+} eventLog;
+
+void logCampus(void *context, Game g, int player, int isGO8,
+        const char *destination) {
+    eventLog *log = context;
+    if (isGO8) {
+        log->go8s++;
+    } else {
+        log->campuses++;
+    }
+    assert(getCampus(g, (char *)destination) == player + 3 * isGO8);
+}
+
+void logARC(void *context, Game g, int player, const char *destination) {
+    eventLog *log = context;
+    log->arcs++;
+    assert(getARC(g, (char *)destination) == player);
+}
+
+void logProduction(void *context, Game g, int diceScore,
+        int produced[NUM_UNIS][NUM_DISCIPLINES]) {
+    eventLog *log = context;
+    log->rolls++;
+    int uni = 0;
+    while (uni < NUM_UNIS) {
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            log->produced[uni][discipline] += produced[uni][discipline];
+            discipline++;
+        }
+        uni++;
+    }
+}
+
+void logConversion(void *context, Game g, int player, int mtv,
+        int mmoney) {
+    eventLog *log = context;
+    log->converted[player-1] += mtv + mmoney;
+}
+
+void logTransfer(void *context, Game g, int award, int from, int to) {
+    eventLog *log = context;
+    assert(award == MOST_ARCS_AWARD);
+    log->transfers++;
+    log->lastFrom = from;
+    log->lastTo = to;
+}
+
+
+// tells an observer about everything that happens in the game
+void testSetGameObserver(void) {
+    puts("Testing function setGameObserver()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    eventLog log;
+    memset(&log, 0, sizeof(log));
+    gameObserver observer = {
+        .context = &log,
+        .onCampusBuilt = logCampus,
+        .onARCBuilt = logARC,
+        .onStudentsProduced = logProduction,
+        .onSevenConversion = logConversion,
+        .onPrestigeTransfer = logTransfer
+    };
+
+    Game A = newGame(setResource, setDice);
+    setGameObserver(A, &observer);
+
+    // UNI_A's campus on the MJ 6 hex
+    throwDice(A, 6);
+    assert(log.rolls == 1);
+    assert(log.produced[UNI_A-1][STUDENT_MJ] == 1);
+
+    buildARC(A, "L");
+    buildARC(A, "LR");
+    buildCampus(A, "LR");
+    assert(log.arcs == 2 && log.campuses == 1);
+    assert(log.transfers == 1);
+    assert(log.lastFrom == NO_ONE && log.lastTo == UNI_A);
+
+    // a 7 converts everyone's MTV and MMONEY
+    int mtv = getStudents(A, UNI_B, STUDENT_MTV);
+    int mmoney = getStudents(A, UNI_B, STUDENT_MMONEY);
+    throwDice(A, 7);
+    assert(log.converted[UNI_B-1] == mtv + mmoney);
+
+    // UNI_B takes the most ARCs award
+    buildARC(A, "RRLRL");
+    buildARC(A, "RRLR");
+    buildARC(A, "RRLL");
+    assert(log.transfers == 2);
+    assert(log.lastFrom == UNI_A && log.lastTo == UNI_B);
+
+    // nothing more once the observer is removed
+    setGameObserver(A, NULL);
+    throwDice(A, 6);
+    assert(log.rolls == 2);
+
+    disposeGame(A);
+}
+
+
+// vertex/edge IDs and the fast path getters agree with Game.h
+void testUncheckedAPI(void) {
+    puts("Testing the unchecked fast path API...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+
+    // bad paths have no ID
+    assert(vertexOfPath("RRRRRR") == NO_VERTEX);
+    assert(vertexOfPath("LX") == NO_VERTEX);
+    assert(edgeOfPath("") == NO_EDGE);
+    assert(edgeOfPath("B") == NO_EDGE);
+
+    // different routes to the same place give the same ID
+    assert(vertexOfPath("") >= 0 && vertexOfPath("") < NUM_VERTICES);
+    assert(vertexOfPath("LB") == vertexOfPath(""));
+    assert(vertexOfPath("LRB") == vertexOfPath("L"));
+    assert(vertexOfPath("LRRRRRR") == vertexOfPath("L"));
+    assert(vertexOfPath("L") != vertexOfPath("R"));
+    assert(edgeOfPath("L") >= 0 && edgeOfPath("L") < NUM_EDGES);
+    assert(edgeOfPath("LB") == edgeOfPath("L"));
+    assert(edgeOfPath("L") != edgeOfPath("R"));
+
+    assert(getCampusAt(A, vertexOfPath("")) == CAMPUS_A);
+    assert(getCampusAt(A, vertexOfPath("RRLRL")) == CAMPUS_B);
+    assert(getCampusAt(A, vertexOfPath("L")) == VACANT_VERTEX);
+
+    throwDice(A, 11);
+    buildARC(A, "L");
+    assert(getARCAt(A, edgeOfPath("L")) == ARC_A);
+    assert(getARCAt(A, edgeOfPath("R")) == VACANT_ARC);
+
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        assert(getKPIpointsFast(A, player) == getKPIpoints(A, player));
+        int discipline = STUDENT_THD;
+        while (discipline <= STUDENT_MMONEY) {
+            assert(getStudentsFast(A, player, discipline)
+                    == getStudents(A, player, discipline));
+            if (discipline != STUDENT_THD) {
+                assert(getExchangeRateFast(A, player, discipline)
+                        == getExchangeRate(A, player, discipline,
+                            STUDENT_THD));
+            }
+            discipline++;
+        }
+        player++;
+    }
+
+    disposeGame(A);
+}
+
+
+// every path to a place canonicalises to the same shortest path
+void testCanonicalPaths(void) {
+    puts("Testing canonical paths...");
+    path out;
+
+    // the start has the empty path, and one step is already shortest
+    assert(strcmp(pathOfVertex(vertexOfPath("")), "") == 0);
+    assert(strcmp(pathOfVertex(vertexOfPath("L")), "L") == 0);
+    assert(strcmp(pathOfEdge(edgeOfPath("R")), "R") == 0);
+
+    // loops and backtracks come out as the shortest path
+    assert(canonicalVertexPath("LB", out) == TRUE);
+    assert(strcmp(out, "") == 0);
+    assert(canonicalVertexPath("LRRRRRR", out) == TRUE);
+    assert(strcmp(out, "L") == 0);
+    assert(canonicalVertexPath("LRB", out) == TRUE);
+    assert(strcmp(out, "L") == 0);
+    assert(canonicalEdgePath("LB", out) == TRUE);
+    assert(strcmp(out, "L") == 0);
+    assert(canonicalEdgePath("LRB", out) == TRUE);
+    assert(strcmp(out, pathOfEdge(edgeOfPath("LR"))) == 0);
+
+    // bad paths have no canonical form
+    strcpy(out, "L");
+    assert(canonicalVertexPath("RRRRRR", out) == FALSE);
+    assert(strcmp(out, "") == 0);
+    assert(canonicalEdgePath("", out) == FALSE);
+    assert(canonicalEdgePath("LX", out) == FALSE);
+
+    // every canonical path leads back to its own vertex/edge, is no
+    // longer than any other path there, and is its own canonical form
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        const char *p = pathOfVertex(vertex);
+        assert(vertexOfPath(p) == vertex);
+        assert(canonicalVertexPath(p, out) == TRUE);
+        assert(strcmp(out, p) == 0);
+
+        // step off and straight back, one way or the other is on land
+        path longer;
+        strcpy(longer, p);
+        strcat(longer, "LB");
+        if (vertexOfPath(longer) == NO_VERTEX) {
+            strcpy(longer, p);
+            strcat(longer, "RB");
+        }
+        assert(canonicalVertexPath(longer, out) == TRUE);
+        assert(strcmp(out, p) == 0);
+        vertex++;
+    }
+
+    int edge = 0;
+    while (edge < NUM_EDGES) {
+        const char *p = pathOfEdge(edge);
+        assert(edgeOfPath(p) == edge);
+        assert(canonicalEdgePath(p, out) == TRUE);
+        assert(strcmp(out, p) == 0);
+        assert(strlen(pathOfVertex(vertexOfPath(p))) <= strlen(p));
+        edge++;
+    }
+}
+
+
+// a batch goes through whole or not at all
+void testApplyActions(void) {
+    puts("Testing function applyActions()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    eventLog log;
+    memset(&log, 0, sizeof(log));
+    gameObserver observer = {
+        .context = &log,
+        .onCampusBuilt = logCampus,
+        .onARCBuilt = logARC,
+        .onPrestigeTransfer = logTransfer
+    };
+
+    Game A = newGame(setResource, setDice);
+    setGameObserver(A, &observer);
+    // UNI_A's campus on the MTV 11 hex
+    throwDice(A, 11);
+
+    // nothing to do is fine
+    assert(applyActions(A, NULL, 0) == ALL_ACTIONS_APPLIED);
+
+    // the third action is too close to UNI_A's first campus, so the
+    // ARCs before it are undone too and nobody hears about them
+    action acts[3] = {
+        {.actionCode = OBTAIN_ARC, .destination = "L"},
+        {.actionCode = OBTAIN_ARC, .destination = "LR"},
+        {.actionCode = BUILD_CAMPUS, .destination = "L"}
+    };
+    assert(applyActions(A, acts, 3) == 2);
+    assert(getARC(A, "L") == VACANT_ARC);
+    assert(getARCs(A, UNI_A) == 0);
+    assert(getMostARCs(A) == NO_ONE);
+    assert(getKPIpoints(A, UNI_A) == INITIAL_KPI);
+    checkStudents(A, INITIAL_BPS, INITIAL_BQN, INITIAL_MJ,
+            INITIAL_MTV + 1, INITIAL_MMONEY, INITIAL_THD);
+    assert(log.arcs == 0 && log.campuses == 0 && log.transfers == 0);
+
+    // the ARCs pay for themselves first, then the campus can go at the
+    // end of them
+    strcpy(acts[2].destination, "LR");
+    assert(applyActions(A, acts, 3) == ALL_ACTIONS_APPLIED);
+    assert(getARC(A, "LR") == ARC_A);
+    assert(getCampus(A, "LR") == CAMPUS_A);
+    assert(getMostARCs(A) == UNI_A);
+    assert(getKPIpoints(A, UNI_A) == INITIAL_KPI + 2 * ARC_KPI
+            + CAMPUS_KPI + PRESTIGE_BONUS);
+    checkStudents(A, 0, 0, 0, 1, INITIAL_MMONEY, INITIAL_THD);
+    assert(log.arcs == 2 && log.campuses == 1 && log.transfers == 1);
+
+    // the same batch again fails on its first action
+    assert(applyActions(A, acts, 3) == 0);
+    assert(log.arcs == 2 && log.campuses == 1);
+    disposeGame(A);
+
+    // spinoffs have to come already resolved
+    A = newGame(setResource, setDice);
+    throwDice(A, 11);
+    action spinoffs[2] = {
+        {.actionCode = START_SPINOFF},
+        {.actionCode = OBTAIN_IP_PATENT}
+    };
+    assert(applyActions(A, spinoffs, 2) == 0);
+    assert(getIPs(A, UNI_A) == 0);
+
+    // and there are only the students for one of them
+    spinoffs[0].actionCode = OBTAIN_PUBLICATION;
+    assert(applyActions(A, spinoffs, 2) == 1);
+    assert(getPublications(A, UNI_A) == 0);
+    assert(getIPs(A, UNI_A) == 0);
+    assert(applyActions(A, spinoffs, 1) == ALL_ACTIONS_APPLIED);
+    assert(getPublications(A, UNI_A) == 1);
+    assert(getMostPublications(A) == UNI_A);
+    disposeGame(A);
+
+    // nothing is legal in Terra Nullis
+    A = newGame(setResource, setDice);
+    action pass = {.actionCode = PASS};
+    assert(applyActions(A, &pass, 1) == 0);
+    disposeGame(A);
+}
+
+
+// a clone starts the same and then goes its own way
+void testCloneGame(void) {
+    puts("Testing function cloneGame()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    eventLog log;
+    memset(&log, 0, sizeof(log));
+    gameObserver observer = {.context = &log, .onARCBuilt = logARC};
+
+    Game A = newGame(setResource, setDice);
+    setGameObserver(A, &observer);
+    throwDice(A, 11);
+    buildARC(A, "L");
+
+    Game B = cloneGame(A);
+    assert(getTurnNumber(B) == 0);
+    assert(getARC(B, "L") == ARC_A);
+    assert(getKPIpoints(B, UNI_A) == getKPIpoints(A, UNI_A));
+    assert(getStudents(B, UNI_A, STUDENT_MTV) == INITIAL_MTV + 1);
+
+    // the clone has no observer and doesn't change the original
+    buildARC(B, "R");
+    assert(log.arcs == 1);
+    assert(getARC(B, "R") == ARC_A);
+    assert(getARC(A, "R") == VACANT_ARC);
+    assert(getARCs(A, UNI_A) == 1);
+
+    disposeGame(B);
+    disposeGame(A);
+}
+
+
+#define PUBLISHED_ROLLS 20000
+#define NUM_READERS 3
+
+// what the game thread and readers share in testGamePublisher()
+typedef struct _publishTest {
+    GamePublisher pub;
+    Game live;
+    atomic_int finished;
+} publishTest;
+
+// UNI_A's campus gets one MJ on every 6, so every whole state has
+// one more MJ than the number of dice thrown. Half of one state and
+// half of the next wouldn't
+void *readSnapshots(void *arg) {
+    publishTest *test = arg;
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    // cloning the live game here would race the game thread
+    Game mine = newGame(setResource, setDice);
+    int lastTurn = -1;
+    while (!atomic_load(&test->finished)) {
+        readPublishedGame(test->pub, mine);
+        int turn = getTurnNumber(mine);
+        assert(turn >= lastTurn);
+        assert(getStudents(mine, UNI_A, STUDENT_MJ)
+                == INITIAL_MJ + turn + 1);
+        lastTurn = turn;
+    }
+    disposeGame(mine);
+    return NULL;
+}
+
+// readers see whole published states while the game keeps going
+void testGamePublisher(void) {
+    puts("Testing the game publisher...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    publishTest test;
+    test.live = newGame(setResource, setDice);
+    test.pub = newGamePublisher(test.live);
+    atomic_init(&test.finished, FALSE);
+
+    // a reader sees what was published, not what happened since
+    Game snapshot = cloneGame(test.live);
+    throwDice(test.live, 6);
+    readPublishedGame(test.pub, snapshot);
+    assert(getTurnNumber(snapshot) == -1);
+    publishGame(test.pub, test.live);
+    readPublishedGame(test.pub, snapshot);
+    assert(getTurnNumber(snapshot) == 0);
+    assert(getStudents(snapshot, UNI_A, STUDENT_MJ) == INITIAL_MJ + 1);
+    disposeGame(snapshot);
+
+    pthread_t readers[NUM_READERS];
+    int i = 0;
+    while (i < NUM_READERS) {
+        pthread_create(&readers[i], NULL, readSnapshots, &test);
+        i++;
+    }
+
+    i = 1;
+    while (i < PUBLISHED_ROLLS) {
+        throwDice(test.live, 6);
+        publishGame(test.pub, test.live);
+        i++;
+    }
+    atomic_store(&test.finished, TRUE);
+
+    i = 0;
+    while (i < NUM_READERS) {
+        pthread_join(readers[i], NULL);
+        i++;
+    }
+
+    disposeGamePublisher(test.pub);
+    disposeGame(test.live);
+}
+
+
+// networks grow with each campus and ARC, and pieces join up
+void testNetworks(void) {
+    puts("Testing ARC networks...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    int start = vertexOfPath("");
+    int other = vertexOfPath("RRLRL");
+
+    // to begin with each campus is a piece on its own
+    assert(getNetwork(A, UNI_A) == (VERTEX_BIT(start)
+                | VERTEX_BIT(vertexOfPath("RLRLRLRLRLL"))));
+    assert(isOnNetwork(A, UNI_A, start) == TRUE);
+    assert(isOnNetwork(A, UNI_B, start) == FALSE);
+    assert(isOnNetwork(A, UNI_B, other) == TRUE);
+    assert(getNetworkPiece(A, UNI_A, start) == start);
+    assert(getNetworkPieceSize(A, UNI_A, start) == 1);
+    assert(getNetworkPiece(A, UNI_A, vertexOfPath("L")) == NO_VERTEX);
+    assert(getNetworkPieceSize(A, UNI_A, vertexOfPath("L")) == 0);
+    assert(isTouchingNetwork(A, UNI_A, edgeOfPath("L")) == TRUE);
+    assert(isTouchingNetwork(A, UNI_A, edgeOfPath("LR")) == FALSE);
+
+    throwDice(A, 11);
+    buildARC(A, "L");
+    assert(isOnNetwork(A, UNI_A, vertexOfPath("L")) == TRUE);
+    assert(getNetworkPiece(A, UNI_A, vertexOfPath("L"))
+            == getNetworkPiece(A, UNI_A, start));
+    assert(getNetworkPieceSize(A, UNI_A, start) == 2);
+    assert(isTouchingNetwork(A, UNI_A, edgeOfPath("LR")) == TRUE);
+
+    // an ARC out on its own is a new piece, until the ARC between
+    // them joins it up with the first
+    buildARC(A, "LRR");
+    int far = vertexOfPath("LRR");
+    assert(getNetworkPiece(A, UNI_A, far) != NO_VERTEX);
+    assert(getNetworkPiece(A, UNI_A, far)
+            != getNetworkPiece(A, UNI_A, start));
+    assert(getNetworkPieceSize(A, UNI_A, far) == 2);
+    buildARC(A, "LR");
+    assert(getNetworkPiece(A, UNI_A, far)
+            == getNetworkPiece(A, UNI_A, start));
+    assert(getNetworkPieceSize(A, UNI_A, far) == 4);
+
+    // networks belong to one uni each
+    assert(getNetworkPiece(A, UNI_B, far) == NO_VERTEX);
+    assert(isTouchingNetwork(A, UNI_B, edgeOfPath("LR")) == FALSE);
+    disposeGame(A);
+
+    // a GO8 keeps its place on the network, so ARCs can still be
+    // built next to it
+    A = newGame(setResource, setDice);
+    genResources(A, 3, 11);
+    genResources(A, 1, 6);
+    throwDice(A, 6);
+    retrain(A, STUDENT_MTV, STUDENT_MMONEY, 3);
+    buildGO8(A, "");
+    assert(getCampus(A, "") == GO8_A);
+    assert(isOnNetwork(A, UNI_A, start) == TRUE);
+    action arc = {.actionCode = OBTAIN_ARC, .destination = "L"};
+    assert(checkAction(A, &arc) == LEGAL_ACTION);
+    disposeGame(A);
+}
+
+
+// the frontiers are exactly where checkAction() would let the player
+// build, and other unis' campuses take spots away
+void testFrontiers(void) {
+    puts("Testing campus and ARC frontiers...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    assert(getCampusFrontier(A, UNI_A) == 0);
+    edgeSet arcs = getARCFrontier(A, UNI_A);
+    assert(edgeSetHas(&arcs, edgeOfPath("L")));
+    assert(edgeSetHas(&arcs, edgeOfPath("R")));
+    assert(edgeSetHas(&arcs, edgeOfPath("LR")) == FALSE);
+
+    throwDice(A, 11);
+    buildARC(A, "L");
+    buildARC(A, "LR");
+
+    // "L" is next to the campus at the start, "LR" is far enough away
+    assert(getCampusFrontier(A, UNI_A) == VERTEX_BIT(vertexOfPath("LR")));
+    assert(getCampusFrontier(A, UNI_B) == 0);
+
+    // UNI_A can still pay for a campus and an ARC, so every spot on
+    // the frontiers is legal and nowhere else is
+    action a;
+    memset(&a, 0, sizeof(action));
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        a.actionCode = BUILD_CAMPUS;
+        strcpy(a.destination, pathOfVertex(vertex));
+        int onFrontier = (getCampusFrontier(A, UNI_A) 
+                & VERTEX_BIT(vertex)) != 0;
+        assert(onFrontier == (checkAction(A, &a) == LEGAL_ACTION));
+        vertex++;
+    }
+
+    arcs = getARCFrontier(A, UNI_A);
+    int edge = 0;
+    while (edge < NUM_EDGES) {
+        a.actionCode = OBTAIN_ARC;
+        strcpy(a.destination, pathOfEdge(edge));
+        assert(edgeSetHas(&arcs, edge) 
+                == (checkAction(A, &a) == LEGAL_ACTION));
+        edge++;
+    }
+
+    // going through the set one edge at a time gets all of them
+    int count = 0;
+    edge = popEdge(&arcs);
+    while (edge != NO_EDGE) {
+        assert(getARCAt(A, edge) == VACANT_ARC);
+        count++;
+        edge = popEdge(&arcs);
+    }
+    arcs = getARCFrontier(A, UNI_A);
+    assert(count == edgeSetCount(&arcs));
+
+    // a UNI_B campus next to "LR" takes it off UNI_A's frontier
+    throwDice(A, 11);
+    buildCampus(A, "LRR");
+    assert(getCampusFrontier(A, UNI_A) == 0);
+    vertexSet spots = getCampusFrontier(A, UNI_A);
+    assert(popVertex(&spots) == NO_VERTEX);
+
+    disposeGame(A);
+}
+
+
+// the same state hashes the same however it was reached, and
+// anything changing changes the hash
+void testHashGame(void) {
+    puts("Testing function hashGame()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    Game B = newGame(setResource, setDice);
+    assert(hashGame(A) == hashGame(B));
+    uint64_t start = hashGame(A);
+
+    // the same ARCs in a different order
+    throwDice(A, 11);
+    throwDice(B, 11);
+    assert(hashGame(A) != start);
+    buildARC(A, "L");
+    assert(hashGame(A) != hashGame(B));
+    buildARC(A, "R");
+    buildARC(B, "R");
+    buildARC(B, "L");
+    assert(hashGame(A) == hashGame(B));
+
+    Game C = cloneGame(A);
+    assert(hashGame(C) == hashGame(A));
+    throwDice(C, 11);
+    assert(hashGame(C) != hashGame(A));
+
+    // another board, even with nothing built, is another position
+    int otherDice[] = DEFAULT_DICE;
+    otherDice[0] = otherDice[1];
+    otherDice[1] = setDice[0];
+    Game D = newGame(setResource, otherDice);
+    assert(hashBoard(setResource, otherDice)
+            != hashBoard(setResource, setDice));
+    assert(hashGame(D) != start);
+
+    disposeGame(D);
+    disposeGame(C);
+    disposeGame(B);
+    disposeGame(A);
+}
+
+void testGetFeatures(void) {
+    puts("Testing function getFeatures()...");
+    int setResource[] = DEFAULT_DISCIPLINES;
+    int setDice[] = DEFAULT_DICE;
+
+    Game A = newGame(setResource, setDice);
+    throwDice(A, 11);
+    buildARC(A, "L");
+    Game B = cloneGame(A);
+    throwDice(B, 8);
+    Game C = newGame(setResource, setDice);
+
+    float features[NUM_FEATURES];
+    assert(FEATURE_PADDING <= NUM_FEATURES);
+    assert(NUM_FEATURES % FEATURE_LANES == 0);
+    getFeatures(A, features);
+
+    // every vertex and edge is exactly one of its states
+    int vertex = 0;
+    while (vertex < NUM_VERTICES) {
+        float *states = &features[FEATURE_VERTICES
+            + vertex * VERTEX_STATES];
+        int state = 0;
+        float total = 0;
+        while (state < VERTEX_STATES) {
+            total += states[state];
+            state++;
+        }
+        assert(total == 1);
+        assert(states[getCampusAt(A, vertex)] == 1);
+        vertex++;
+    }
+    int edge = 0;
+    while (edge < NUM_EDGES) {
+        assert(features[FEATURE_ARCS + edge * ARC_STATES
+                + getARCAt(A, edge)] == 1);
+        edge++;
+    }
+    assert(features[FEATURE_VERTICES + vertexOfPath("") * VERTEX_STATES
+            + CAMPUS_A] == 1);
+    assert(features[FEATURE_ARCS + edgeOfPath("L") * ARC_STATES
+            + ARC_A] == 1);
+
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        int production[NUM_DICE_SCORES][NUM_DISCIPLINES];
+        getProduction(A, player, production);
+        int d = 0;
+        while (d < NUM_DISCIPLINES) {
+            int feature = (player - 1) * NUM_DISCIPLINES + d;
+            assert(features[FEATURE_STUDENTS + feature]
+                    == getStudents(A, player, d));
+            double income = 0;
+            int score = 2;
+            while (score <= 12) {
+                income += production[score][d] * getDiceChance(score);
+                score++;
+            }
+            assert(features[FEATURE_INCOME + feature] > income
+                    - FEATURE_ROUNDING);
+            assert(features[FEATURE_INCOME + feature] < income
+                    + FEATURE_ROUNDING);
+            if (d != STUDENT_THD) {
+                assert(features[FEATURE_EXCHANGE + feature]
+                        == getExchangeRate(A, player, d, STUDENT_BPS));
+            }
+            d++;
+        }
+        assert(features[FEATURE_KPI + player - 1] == getKPIpoints(A, player));
+        player++;
+    }
+    assert(features[FEATURE_MOST_ARCS + UNI_A] == 1);
+    assert(features[FEATURE_MOST_PUBS + NO_ONE] == 1);
+    int feature = FEATURE_PADDING;
+    while (feature < NUM_FEATURES) {
+        assert(features[feature] == 0);
+        feature++;
+    }
+
+    // a batch holds the same features a game to a column, with the
+    // columns past the last game left 0
+    Game games[] = {A, B, C};
+    int numGames = 3;
+    int stride = FEATURE_BATCH_STRIDE(numGames);
+    assert(stride == FEATURE_LANES);
+    float *batch = malloc(NUM_FEATURES * stride * sizeof(float));
+    getFeatureBatch(games, numGames, batch);
+    float weights[NUM_FEATURES];
+    feature = 0;
+    while (feature < NUM_FEATURES) {
+        weights[feature] = (feature % 7) - 3;
+        feature++;
+    }
+    float scores[3];
+    scoreFeatureBatch(batch, numGames, weights, scores);
+
+    int i = 0;
+    while (i < numGames) {
+        getFeatures(games[i], features);
+        double score = 0;
+        feature = 0;
+        while (feature < NUM_FEATURES) {
+            assert(batch[feature * stride + i] == features[feature]);
+            score += weights[feature] * features[feature];
+            feature++;
+        }
+        assert(scores[i] > score - FEATURE_ROUNDING * NUM_FEATURES);
+        assert(scores[i] < score + FEATURE_ROUNDING * NUM_FEATURES);
+        i++;
+    }
+    feature = 0;
+    while (feature < NUM_FEATURES) {
+        i = numGames;
+        while (i < stride) {
+            assert(batch[feature * stride + i] == 0);
+            i++;
+        }
+        feature++;
+    }
+
+    free(batch);
+    disposeGame(C);
+    disposeGame(B);
+    disposeGame(A);
+}
 /*
  * SOME FUNCTIONS WHICH SIMPLIFY THE TESTING BUT AREN'T PART OF THE 
  * TESTING SUITE NOR THE INTERFACE FOR THE ADT
@@ -0,0 +1,323 @@
+/*
+ * testMacro.c - checks the macro actions
+ *
+ * The retraining is checked against trying every way of paying, and
+ * every macro action has to go through Game.c as it is.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define NUM_SEEDS 10
+#define STEPS_PER_GAME 400
+
+// only move one step in SAVING_STEPS so students build up
+#define SAVING_STEPS 4
+
+#define NUM_TURNS 60
+
+// more than any retraining could cost
+#define TOO_MANY 1000
+
+
+void testRetraining(void);
+void testMacroMoves(void);
+void testGameMacros(void);
+
+// play seeded random games and check each position along the way
+void checkRandomGames(void (*check)(const rollout *r));
+
+void checkRetraining(const rollout *r);
+void checkMacroMoves(const rollout *r);
+
+// the fewest students the current player can spend to pay for
+// actionCode by retraining, trying every way. TOO_MANY if they can't
+int cheapestRetraining(const rollout *r, int actionCode);
+int cheapestFrom(int spare[], const int rate[], int owed[], int to);
+
+// how many students the player spends on retraining
+int studentsSpent(const rollout *r, const rolloutMove retrains[],
+        int count);
+
+
+// the positions seen and moves counted by checkMacroMoves()
+int positions = 0;
+int numMacros = 0;
+int numMoves = 0;
+
+
+int main(int argc, char *argv[]) {
+    testRetraining();
+    testMacroMoves();
+    testGameMacros();
+
+    printf("All macro tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testRetraining(void) {
+    printf("Testing the cheapest retraining\n");
+    checkRandomGames(checkRetraining);
+}
+
+
+// Fewer macros than moves, even though retraining lets the macros buy
+// things the moves can't yet, and every purchase left out has one of
+// the same kind kept in its place
+void testMacroMoves(void) {
+    printf("Testing macro moves\n");
+    checkRandomGames(checkMacroMoves);
+    assert(positions > NUM_SEEDS);
+    assert(numMacros < numMoves);
+}
+
+
+// Every macro action the game offers can be made, and making one of
+// them each turn keeps the game going
+void testGameMacros(void) {
+    printf("Testing macro actions in the game\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    int retrained = 0;
+
+    int turn = 0;
+    while (turn < NUM_TURNS) {
+        throwDice(g, 6 + turn % 6);
+        macroAction macros[MAX_MACROS];
+        int count = getMacroActions(g, macros);
+        assert(count >= 1);
+        assert(macros[0].numActions == 1);
+        assert(macros[0].actions[0].actionCode == PASS);
+
+        int i = 0;
+        while (i < count) {
+            macroAction macro = macros[i];
+            action *last = &macro.actions[macro.numActions-1];
+            if (last->actionCode == START_SPINOFF) {
+                last->actionCode = OBTAIN_PUBLICATION;
+            }
+            if (macro.numActions > 1) {
+                retrained++;
+            }
+            Game copy = cloneGame(g);
+            assert(makeMacroAction(copy, &macro) == ALL_ACTIONS_APPLIED);
+            disposeGame(copy);
+            i++;
+        }
+
+        // buy the last thing on offer
+        macroAction macro = macros[count-1];
+        action *last = &macro.actions[macro.numActions-1];
+        if (last->actionCode == START_SPINOFF) {
+            last->actionCode = OBTAIN_PUBLICATION;
+        }
+        assert(makeMacroAction(g, &macro) == ALL_ACTIONS_APPLIED);
+        turn++;
+    }
+    assert(retrained > 0);
+
+    disposeGame(g);
+}
+
+
+void checkRandomGames(void (*check)(const rollout *r)) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+
+    int seed = 1;
+    while (seed <= NUM_SEEDS) {
+        rollout r;
+        rolloutFromGame(&r, &board, g, seed);
+        rolloutThrowDice(&r, rolloutRollDice(&r));
+        int steps = 0;
+        while (steps < STEPS_PER_GAME) {
+            check(&r);
+            rolloutMove move = rolloutRandomMove(&r);
+            if (steps % SAVING_STEPS != 0) {
+                move.actionCode = PASS;
+            }
+            if (move.actionCode == PASS) {
+                rolloutThrowDice(&r, rolloutRollDice(&r));
+            } else {
+                rolloutMakeMove(&r, &move);
+            }
+            steps++;
+        }
+        seed++;
+    }
+
+    disposeGame(g);
+}
+
+
+// The retraining pays for the purchase at the lowest cost there is,
+// and there is some exactly when any way of retraining would pay
+void checkRetraining(const rollout *r) {
+    int codes[] = {BUILD_CAMPUS, BUILD_GO8, OBTAIN_ARC, START_SPINOFF};
+    int player = rolloutWhoseTurn(r);
+    int i = 0;
+    while (i < 4) {
+        rolloutMove retrains[MAX_MACRO_RETRAINS];
+        int count = rolloutRetraining(r, codes[i], retrains);
+        int cheapest = cheapestRetraining(r, codes[i]);
+        if (count == CANT_RETRAIN) {
+            assert(cheapest == TOO_MANY);
+        } else {
+            assert(count <= MAX_MACRO_RETRAINS);
+            assert(studentsSpent(r, retrains, count) == cheapest);
+            rollout after = *r;
+            int j = 0;
+            while (j < count) {
+                rolloutMakeMove(&after, &retrains[j]);
+                j++;
+            }
+            int discipline = 0;
+            while (discipline < NUM_DISCIPLINES) {
+                assert(after.students[player-1][discipline]
+                        >= actionCosts[codes[i]][discipline]);
+                discipline++;
+            }
+        }
+        i++;
+    }
+}
+
+
+void checkMacroMoves(const rollout *r) {
+    int player = rolloutWhoseTurn(r);
+    rolloutMove builds[MAX_MACROS];
+    int count = rolloutMacroMoves(r, builds);
+    rolloutMove moves[MAX_ROLLOUT_MOVES];
+    int numListed = rolloutListMoves(r, moves);
+    positions++;
+    numMacros += count;
+    numMoves += numListed;
+
+    // every macro can be made and leaves nobody short
+    int kinds = 0;
+    int i = 0;
+    while (i < count) {
+        assert(builds[i].actionCode != RETRAIN_STUDENTS);
+        rollout after = *r;
+        rolloutMove build = builds[i];
+        rolloutMakeMacro(&after, &build);
+        int discipline = 0;
+        while (discipline < NUM_DISCIPLINES) {
+            assert(after.students[player-1][discipline] >= 0);
+            discipline++;
+        }
+        kinds |= 1 << builds[i].actionCode;
+        i++;
+    }
+
+    // every purchase which can be made now without retraining is kept
+    // or has one of its kind kept
+    i = 0;
+    while (i < numListed) {
+        int found = FALSE;
+        int j = 0;
+        while (j < count) {
+            if (builds[j].actionCode == moves[i].actionCode
+                    && builds[j].target == moves[i].target) {
+                found = TRUE;
+            }
+            j++;
+        }
+        if (moves[i].actionCode == BUILD_CAMPUS
+                || moves[i].actionCode == BUILD_GO8) {
+            assert(found || (kinds & (1 << moves[i].actionCode)));
+        } else if (moves[i].actionCode != RETRAIN_STUDENTS) {
+            assert(found);
+        }
+        i++;
+    }
+}
+
+
+int cheapestRetraining(const rollout *r, int actionCode) {
+    int player = rolloutWhoseTurn(r);
+    int spare[NUM_DISCIPLINES];
+    int rate[NUM_DISCIPLINES];
+    int owed[NUM_DISCIPLINES];
+    int discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        spare[discipline] = r->students[player-1][discipline]
+            - actionCosts[actionCode][discipline];
+        owed[discipline] = 0;
+        if (spare[discipline] < 0) {
+            owed[discipline] = -spare[discipline];
+            spare[discipline] = 0;
+        }
+        rate[discipline] = rolloutExchangeRate(r, player, discipline);
+        discipline++;
+    }
+    return cheapestFrom(spare, rate, owed, 0);
+}
+
+
+// pay the first student still owed from every discipline in turn
+int cheapestFrom(int spare[], const int rate[], int owed[], int to) {
+    while (to < NUM_DISCIPLINES && owed[to] == 0) {
+        to++;
+    }
+
+    int best = 0;
+    if (to < NUM_DISCIPLINES) {
+        best = TOO_MANY;
+        int from = STUDENT_BPS;
+        while (from <= STUDENT_MMONEY) {
+            if (spare[from] >= rate[from]) {
+                spare[from] -= rate[from];
+                owed[to]--;
+                int cost = rate[from] + cheapestFrom(spare, rate, owed, to);
+                if (cost < best) {
+                    best = cost;
+                }
+                owed[to]++;
+                spare[from] += rate[from];
+            }
+            from++;
+        }
+    }
+    return best;
+}
+
+
+int studentsSpent(const rollout *r, const rolloutMove retrains[],
+        int count) {
+    int player = rolloutWhoseTurn(r);
+    int spent = 0;
+    int i = 0;
+    while (i < count) {
+        spent += rolloutExchangeRate(r, player, retrains[i].disciplineFrom);
+        i++;
+    }
+    return spent;
+}
@@ -0,0 +1,258 @@
+/*
+ * testMcts.c - checks the Monte Carlo tree search player
+ *
+ * Whole games are played in Game.c with the player choosing every
+ * action, and the tree it keeps between decisions is checked to be
+ * the part it had already searched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "Mcts.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define MAX_NODES 200000
+#define PLAYOUTS 500
+#define NUM_TURNS 60
+
+// a player is cut off after this many actions in a turn
+#define MAX_TURN_ACTIONS 20
+
+
+void testTerraNullis(void);
+void testReroot(void);
+void testPlayGame(void);
+void testNoRoom(void);
+void testMemory(void);
+
+
+int main(int argc, char *argv[]) {
+    testTerraNullis();
+    testReroot();
+    testPlayGame();
+    testNoRoom();
+    testMemory();
+
+    printf("All MCTS tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testTerraNullis(void) {
+    printf("Testing MCTS in Terra Nullis\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Mcts m = newMcts(g, MAX_NODES, 1);
+
+    macroAction macro;
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    assert(macro.numActions == 1);
+    assert(macro.actions[0].actionCode == PASS);
+    assert(mctsNumNodes(m) == 1);
+    assert(mctsRootVisits(m) == 0);
+
+    // the first dice roll starts a tree for UNI_A
+    throwDice(g, 8);
+    mctsThrowDice(m, 8);
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    assert(isLegalAction(g, macro.actions[0]));
+    assert(mctsRootVisits(m) == PLAYOUTS);
+
+    disposeMcts(m);
+    disposeGame(g);
+}
+
+
+// Whatever is made, the tree keeps what was under it: the search
+// always adds exactly as many playouts as asked for, so a root with
+// more than that must have started with some
+void testReroot(void) {
+    printf("Testing the tree is kept\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Mcts m = newMcts(g, MAX_NODES, 2);
+    throwDice(g, 8);
+    mctsThrowDice(m, 8);
+
+    // UNI_A can afford an ARC from the start
+    macroAction macro;
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    int before = mctsNumNodes(m);
+    assert(before > 1);
+    assert(macro.actions[macro.numActions-1].actionCode != PASS);
+    assert(makeMacroAction(g, &macro) == ALL_ACTIONS_APPLIED);
+    mctsMakeMacro(m, &macro);
+    assert(mctsRootVisits(m) > 0);
+    assert(mctsNumNodes(m) < before);
+
+    int kept = mctsRootVisits(m);
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    assert(mctsRootVisits(m) == kept + PLAYOUTS);
+    assert(isLegalAction(g, macro.actions[0]));
+
+    // passing and throwing the dice keeps the subtree for that roll
+    action pass = {.actionCode = PASS};
+    mctsMakeAction(m, pass);
+    assert(mctsRootVisits(m) > 0);
+    throwDice(g, 6);
+    mctsThrowDice(m, 6);
+    assert(mctsRootVisits(m) > 0);
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    assert(isLegalAction(g, macro.actions[0]));
+
+    disposeMcts(m);
+    disposeGame(g);
+}
+
+
+// Every uni is played by the same tree for a while. Each action it
+// chooses is legal, and most decisions start with playouts already
+// done
+void testPlayGame(void) {
+    printf("Testing a game played by MCTS\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Mcts m = newMcts(g, MAX_NODES, 3);
+    srand(3);
+    int decisions = 0;
+    int reused = 0;
+
+    int turn = 0;
+    while (turn < NUM_TURNS) {
+        int score = rand() % 6 + rand() % 6 + 2;
+        throwDice(g, score);
+        mctsThrowDice(m, score);
+
+        int actions = 0;
+        int passed = FALSE;
+        while (!passed) {
+            if (mctsRootVisits(m) > 0) {
+                reused++;
+            }
+            decisions++;
+            macroAction macro;
+            mctsChooseMacro(m, PLAYOUTS, &macro);
+            assert(mctsNumNodes(m) <= MAX_NODES);
+            action *bought = &macro.actions[macro.numActions-1];
+            if (bought->actionCode == START_SPINOFF) {
+                if (rand() % IP_PATENT_ODDS == 0) {
+                    bought->actionCode = OBTAIN_IP_PATENT;
+                } else {
+                    bought->actionCode = OBTAIN_PUBLICATION;
+                }
+            }
+
+            if (bought->actionCode == PASS || actions == MAX_TURN_ACTIONS) {
+                passed = TRUE;
+            } else {
+                assert(makeMacroAction(g, &macro) == ALL_ACTIONS_APPLIED);
+                mctsMakeMacro(m, &macro);
+                actions++;
+            }
+        }
+        turn++;
+    }
+    assert(reused * 2 > decisions);
+
+    disposeMcts(m);
+    disposeGame(g);
+}
+
+
+// Without room to grow the tree every decision is made from nothing,
+// and moves the tree never has, like retraining on its own, are still
+// followed
+void testNoRoom(void) {
+    printf("Testing a tree with no room\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Mcts m = newMcts(g, 1, 4);
+    throwDice(g, 8);
+    mctsThrowDice(m, 8);
+
+    macroAction macro;
+    mctsChooseMacro(m, PLAYOUTS, &macro);
+    assert(macro.actions[0].actionCode == PASS);
+    assert(mctsNumNodes(m) == 1);
+    assert(mctsRootVisits(m) == PLAYOUTS);
+
+    action a = {.actionCode = RETRAIN_STUDENTS,
+        .disciplineFrom = STUDENT_MJ, .disciplineTo = STUDENT_BPS};
+    while (getStudents(g, UNI_A, STUDENT_MJ) < 3) {
+        throwDice(g, 6);
+        mctsThrowDice(m, 6);
+        throwDice(g, 8);
+        mctsThrowDice(m, 8);
+        throwDice(g, 8);
+        mctsThrowDice(m, 8);
+    }
+    assert(isLegalAction(g, a));
+    makeAction(g, a);
+    mctsMakeAction(m, a);
+    assert(mctsRootVisits(m) == 0);
+
+    disposeMcts(m);
+    disposeGame(g);
+}
+
+
+// The tree's memory is all there from the start: it grows with the
+// nodes, never past what maxNodes allows, and shrinks to the subtree
+// kept when an action is made
+void testMemory(void) {
+    printf("Testing the tree's memory\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    int maxNodes = 1000;
+    Mcts m = newMcts(g, maxNodes, 5);
+    throwDice(g, 8);
+    mctsThrowDice(m, 8);
+    size_t nodeSize = mctsMemoryUsed(m);
+    assert(mctsNumNodes(m) == 1);
+
+    macroAction macro;
+    mctsChooseMacro(m, PLAYOUTS * 10, &macro);
+    assert(mctsNumNodes(m) <= maxNodes);
+    assert(mctsMemoryUsed(m) == mctsNumNodes(m) * nodeSize);
+    assert(mctsPeakMemory(m) <= maxNodes * nodeSize);
+    size_t before = mctsMemoryUsed(m);
+
+    action *bought = &macro.actions[macro.numActions-1];
+    if (bought->actionCode == START_SPINOFF) {
+        bought->actionCode = OBTAIN_PUBLICATION;
+    }
+    assert(makeMacroAction(g, &macro) == ALL_ACTIONS_APPLIED);
+    mctsMakeMacro(m, &macro);
+    assert(mctsMemoryUsed(m) < before);
+    assert(mctsMemoryUsed(m) == mctsNumNodes(m) * nodeSize);
+    assert(mctsPeakMemory(m) >= before);
+
+    disposeMcts(m);
+    disposeGame(g);
+}
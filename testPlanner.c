@@ -0,0 +1,289 @@
+/*
+ * testPlanner.c - checks the turn planner
+ *
+ * Plans are checked against trying every legal order of moves (only
+ * possible while there are few students), and every plan has to be
+ * legal to make in Game.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define NUM_SEEDS 10
+#define STEPS_PER_GAME 400
+
+// positions with more students than this to spend are too slow to
+// check without the table
+#define BRUTE_FORCE_STUDENTS 12
+
+#define SAVING_STEPS 4
+
+#define TOLERANCE 1e-9
+
+
+void testTerraNullis(void);
+void testBruteForce(void);
+void testPlansAreLegal(void);
+void testOtherScores(void);
+
+// the best expected score from r, trying every order of moves
+double bruteForce(const rollout *r, planScore score);
+
+// how many students the current player has that could be spent
+int spendableStudents(const rollout *r);
+
+// scores a position by how many spinoffs the player has had
+double spinoffScore(const rollout *r, int player, void *data);
+
+// scores every position the same
+double flatScore(const rollout *r, int player, void *data);
+
+
+int main(int argc, char *argv[]) {
+    testTerraNullis();
+    testBruteForce();
+    testPlansAreLegal();
+    testOtherScores();
+
+    printf("All planner tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testTerraNullis(void) {
+    printf("Testing a plan in Terra Nullis\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Planner p = newPlanner();
+    turnPlan plan;
+
+    planGameTurn(p, g, &plan);
+    assert(plan.numMoves == 0);
+    assert(plan.score == 0);
+
+    disposePlanner(p);
+    disposeGame(g);
+}
+
+
+// Play random games and check the plan in every small enough position
+// scores exactly what the best order of moves does
+void testBruteForce(void) {
+    printf("Testing plans against brute force\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    Planner p = newPlanner();
+    int checked = 0;
+
+    int seed = 1;
+    while (seed <= NUM_SEEDS) {
+        rollout r;
+        rolloutFromGame(&r, &board, g, seed);
+        rolloutThrowDice(&r, rolloutRollDice(&r));
+        int steps = 0;
+        while (steps < STEPS_PER_GAME) {
+            if (spendableStudents(&r) <= BRUTE_FORCE_STUDENTS) {
+                turnPlan plan;
+                planTurn(p, &r, NULL, NULL, &plan);
+                assert(fabs(plan.score - bruteForce(&r, kpiScore))
+                        < TOLERANCE);
+                checked++;
+            }
+
+            // only move one step in SAVING_STEPS so students build up
+            rolloutMove move = rolloutRandomMove(&r);
+            if (steps % SAVING_STEPS != 0) {
+                move.actionCode = PASS;
+            }
+            if (move.actionCode == PASS) {
+                rolloutThrowDice(&r, rolloutRollDice(&r));
+            } else {
+                rolloutMakeMove(&r, &move);
+            }
+            steps++;
+        }
+        seed++;
+    }
+    assert(checked > NUM_SEEDS);
+
+    disposePlanner(p);
+    disposeGame(g);
+}
+
+
+// Make every plan in Game.c. With no spinoffs in it the plan has to
+// end up with exactly the KPI it expected, and a second plan from the
+// end of it has nothing more to do
+void testPlansAreLegal(void) {
+    printf("Testing plans are legal\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Planner p = newPlanner();
+    int turns = 0;
+
+    while (turns < 60) {
+        // plenty of sevens go by, so keep the students coming
+        throwDice(g, 6 + turns % 6);
+        turnPlan plan;
+        planGameTurn(p, g, &plan);
+
+        int player = getWhoseTurn(g);
+        int spinoffs = FALSE;
+        int i = 0;
+        while (i < plan.numMoves) {
+            action a = plan.actions[i];
+            assert(isLegalAction(g, a));
+            if (a.actionCode == START_SPINOFF) {
+                a.actionCode = OBTAIN_PUBLICATION;
+                spinoffs = TRUE;
+            }
+            makeAction(g, a);
+            i++;
+        }
+        if (!spinoffs) {
+            assert(getKPIpoints(g, player) == plan.score);
+        }
+
+        turnPlan after;
+        planGameTurn(p, g, &after);
+        if (!spinoffs) {
+            assert(after.numMoves == 0);
+        }
+        turns++;
+    }
+
+    disposePlanner(p);
+    disposeGame(g);
+}
+
+
+// A score for spinoffs alone gets as many as retraining can pay for,
+// and a score nothing changes plans nothing
+void testOtherScores(void) {
+    printf("Testing plans with other scores\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    Planner p = newPlanner();
+    int checked = 0;
+
+    int seed = 1;
+    while (seed <= NUM_SEEDS) {
+        rollout r;
+        rolloutFromGame(&r, &board, g, seed);
+        rolloutThrowDice(&r, rolloutRollDice(&r));
+        int steps = 0;
+        while (steps < STEPS_PER_GAME) {
+            if (spendableStudents(&r) <= BRUTE_FORCE_STUDENTS) {
+                turnPlan plan;
+                planTurn(p, &r, spinoffScore, NULL, &plan);
+                assert(fabs(plan.score - bruteForce(&r, spinoffScore))
+                        < TOLERANCE);
+                planTurn(p, &r, flatScore, NULL, &plan);
+                assert(plan.numMoves == 0);
+                checked++;
+            }
+
+            // only move one step in SAVING_STEPS so students build up
+            rolloutMove move = rolloutRandomMove(&r);
+            if (steps % SAVING_STEPS != 0) {
+                move.actionCode = PASS;
+            }
+            if (move.actionCode == PASS) {
+                rolloutThrowDice(&r, rolloutRollDice(&r));
+            } else {
+                rolloutMakeMove(&r, &move);
+            }
+            steps++;
+        }
+        seed++;
+    }
+    assert(checked > NUM_SEEDS);
+
+    disposePlanner(p);
+    disposeGame(g);
+}
+
+
+double bruteForce(const rollout *r, planScore score) {
+    int player = rolloutWhoseTurn(r);
+    double best = score(r, player, NULL);
+    rolloutMove moves[MAX_ROLLOUT_MOVES];
+    int count = rolloutListMoves(r, moves);
+    int i = 1;
+    while (i < count) {
+        rolloutMove move = moves[i];
+        rollout next = *r;
+        double value;
+        if (move.actionCode == START_SPINOFF) {
+            move.actionCode = OBTAIN_IP_PATENT;
+            rolloutMakeMove(&next, &move);
+            value = bruteForce(&next, score) / IP_PATENT_ODDS;
+            next = *r;
+            move.actionCode = OBTAIN_PUBLICATION;
+            rolloutMakeMove(&next, &move);
+            value += bruteForce(&next, score) * (IP_PATENT_ODDS - 1)
+                / IP_PATENT_ODDS;
+        } else {
+            rolloutMakeMove(&next, &move);
+            value = bruteForce(&next, score);
+        }
+        if (value > best) {
+            best = value;
+        }
+        i++;
+    }
+    return best;
+}
+
+
+int spendableStudents(const rollout *r) {
+    int player = rolloutWhoseTurn(r);
+    int total = 0;
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        total += r->students[player-1][discipline];
+        discipline++;
+    }
+    return total;
+}
+
+
+double spinoffScore(const rollout *r, int player, void *data) {
+    return r->numPubs[player-1] + r->numIPs[player-1];
+}
+
+
+double flatScore(const rollout *r, int player, void *data) {
+    return 0;
+}
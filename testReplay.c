@@ -0,0 +1,313 @@
+/*
+ * testReplay.c - checks recording games and playing them back
+ *
+ * Writes a replay file in the current directory and removes it again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Replay.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define REPLAY_FILE "testReplay.tmp"
+
+// more events than the test game has
+#define MAX_TEST_EVENTS 64
+
+
+void testRecordAndReplay(void);
+void testIllegalEvents(void);
+void testSaveAndLoad(void);
+void testBadFiles(void);
+void testActionText(void);
+
+// play a few turns in g, recording them in r and the hash of g after
+// each event in hashes[]. returns how many events there were
+int playTestGame(Game g, Replay r, uint64_t hashes[]);
+
+// throw the dice or make the action in g and record it in r
+void roll(Game g, Replay r, int diceScore);
+void act(Game g, Replay r, int actionCode, char *destination,
+        int disciplineFrom, int disciplineTo);
+
+// write text into the replay file
+void writeFile(const char *text);
+
+
+int main(int argc, char *argv[]) {
+    testRecordAndReplay();
+    testIllegalEvents();
+    testSaveAndLoad();
+    testBadFiles();
+    testActionText();
+
+    printf("All replay tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// Playing back any number of events gets the game that was played to
+// that point
+void testRecordAndReplay(void) {
+    printf("Testing recording and playing back\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Replay r = newReplay(disciplines, dice);
+    uint64_t hashes[MAX_TEST_EVENTS];
+    int events = playTestGame(g, r, hashes);
+    assert(replayLength(r) == events);
+
+    int board[NUM_REGIONS];
+    int boardDice[NUM_REGIONS];
+    replayBoard(r, board, boardDice);
+    assert(memcmp(board, disciplines, sizeof(board)) == 0);
+    assert(memcmp(boardDice, dice, sizeof(boardDice)) == 0);
+    assert(replayEventAt(r, 0).type == REPLAY_ROLL);
+    assert(replayEventAt(r, 0).diceScore == 11);
+    assert(replayEventAt(r, 1).type == REPLAY_ACTION);
+    assert(replayEventAt(r, 1).a.actionCode == RETRAIN_STUDENTS);
+    assert(replayEventAt(r, 1).a.disciplineTo == STUDENT_MJ);
+
+    Game start = replayGame(r, 0);
+    assert(getTurnNumber(start) == -1);
+    disposeGame(start);
+    int n = 1;
+    while (n <= events) {
+        Game played = replayGame(r, n);
+        assert(played != NULL);
+        assert(hashGame(played) == hashes[n-1]);
+        disposeGame(played);
+        n++;
+    }
+
+    disposeReplay(r);
+    disposeGame(g);
+}
+
+
+// An event that can't be made where it was recorded stops the replay
+// there, without changing the game
+void testIllegalEvents(void) {
+    printf("Testing illegal events\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Replay r = newReplay(disciplines, dice);
+    uint64_t hashes[MAX_TEST_EVENTS];
+    int events = playTestGame(g, r, hashes);
+
+    // the ARC again, which is taken
+    recordAction(r, replayEventAt(r, events - 2).a);
+    Game played = replayGame(r, events);
+    assert(played != NULL);
+    disposeGame(played);
+    assert(replayGame(r, events + 1) == NULL);
+    assert(!replayStep(r, g, events));
+    assert(hashGame(g) == hashes[events-1]);
+
+    // nothing can be done before the first roll
+    Replay early = newReplay(disciplines, dice);
+    action pass = {.actionCode = PASS};
+    recordAction(early, pass);
+    assert(replayGame(early, 1) == NULL);
+    recordThrow(early, 13);
+    Game first = replayGame(early, 0);
+    assert(!replayStep(early, first, 1));
+
+    disposeGame(first);
+    disposeReplay(early);
+    disposeReplay(r);
+    disposeGame(g);
+}
+
+
+void testSaveAndLoad(void) {
+    printf("Testing saving and loading\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Replay r = newReplay(disciplines, dice);
+    uint64_t hashes[MAX_TEST_EVENTS];
+    int events = playTestGame(g, r, hashes);
+    assert(saveReplay(r, REPLAY_FILE));
+
+    Replay loaded = loadReplay(REPLAY_FILE);
+    assert(loaded != NULL);
+    assert(replayLength(loaded) == events);
+    int n = 0;
+    while (n < events) {
+        replayEvent a = replayEventAt(r, n);
+        replayEvent b = replayEventAt(loaded, n);
+        assert(a.type == b.type);
+        if (a.type == REPLAY_ROLL) {
+            assert(a.diceScore == b.diceScore);
+        } else {
+            assert(a.a.actionCode == b.a.actionCode);
+            assert(strcmp(a.a.destination, b.a.destination) == 0);
+            if (a.a.actionCode == RETRAIN_STUDENTS) {
+                assert(a.a.disciplineFrom == b.a.disciplineFrom);
+                assert(a.a.disciplineTo == b.a.disciplineTo);
+            }
+        }
+        n++;
+    }
+    Game played = replayGame(loaded, events);
+    assert(hashGame(played) == hashGame(g));
+
+    disposeGame(played);
+    disposeReplay(loaded);
+    disposeReplay(r);
+    disposeGame(g);
+    remove(REPLAY_FILE);
+}
+
+
+void testBadFiles(void) {
+    printf("Testing files that aren't replays\n");
+    remove(REPLAY_FILE);
+    assert(loadReplay(REPLAY_FILE) == NULL);
+
+    writeFile("this is not a replay\n");
+    assert(loadReplay(REPLAY_FILE) == NULL);
+
+    // the wrong version, too few dice, a bad path and a bad line
+    const char *board = "board 2 5 3 5 3 1 4 4 1 4 2 3 2 0 3 5 4 2 1\n";
+    const char *dice = "dice 9 10 8 12 6 5 3 11 3 11 4 6 4 9 9 2 8 10 5\n";
+    char text[1024];
+    sprintf(text, "replay 2\n%s%s", board, dice);
+    writeFile(text);
+    assert(loadReplay(REPLAY_FILE) == NULL);
+    sprintf(text, "replay 1\n%sdice 9 10 8\n", board);
+    writeFile(text);
+    assert(loadReplay(REPLAY_FILE) == NULL);
+    sprintf(text, "replay 1\n%s%sroll 11\nact 3 LQ 0 0\n", board, dice);
+    writeFile(text);
+    assert(loadReplay(REPLAY_FILE) == NULL);
+    sprintf(text, "replay 1\n%s%sroll 11\nbuild\n", board, dice);
+    writeFile(text);
+    assert(loadReplay(REPLAY_FILE) == NULL);
+
+    // and one that's fine, without a newline at the end
+    sprintf(text, "replay 1\n%s%sroll 11\nact 3 L 0 0", board, dice);
+    writeFile(text);
+    Replay r = loadReplay(REPLAY_FILE);
+    assert(r != NULL);
+    assert(replayLength(r) == 2);
+    Game g = replayGame(r, 2);
+    assert(getARC(g, "L") == ARC_A);
+
+    disposeGame(g);
+    disposeReplay(r);
+    remove(REPLAY_FILE);
+}
+
+
+void testActionText(void) {
+    printf("Testing actions as text\n");
+    action a = {.actionCode = RETRAIN_STUDENTS,
+        .disciplineFrom = STUDENT_BPS, .disciplineTo = STUDENT_MJ};
+    char text[MAX_ACTION_TEXT];
+    formatAction(a, text);
+    assert(strcmp(text, "7 - 1 3") == 0);
+    action b;
+    assert(parseAction(text, &b));
+    assert(b.actionCode == RETRAIN_STUDENTS);
+    assert(b.destination[0] == 0);
+    assert(b.disciplineFrom == STUDENT_BPS);
+    assert(b.disciplineTo == STUDENT_MJ);
+
+    action arc = {.actionCode = OBTAIN_ARC, .destination = "RLRL"};
+    formatAction(arc, text);
+    assert(parseAction(text, &b));
+    assert(strcmp(b.destination, "RLRL") == 0);
+
+    char longPath[PATH_LIMIT + 16];
+    memset(longPath, 'L', PATH_LIMIT);
+    longPath[PATH_LIMIT] = 0;
+    sprintf(text, "3 %s 0 0", longPath);
+    assert(!parseAction(text, &b));
+
+    assert(!parseAction("8 - 0 0", &b));
+    assert(!parseAction("3 L 0", &b));
+    assert(!parseAction("3 L 0 0 0", &b));
+    assert(!parseAction("7 - 1 6", &b));
+}
+
+
+// A retrains for a spinoff, which becomes a publication, and passes.
+// The dice go round, then A retrains for an ARC and doesn't pass
+// before the dice are thrown again
+int playTestGame(Game g, Replay r, uint64_t hashes[]) {
+    int events = 0;
+    roll(g, r, 11);
+    hashes[events++] = hashGame(g);
+    act(g, r, RETRAIN_STUDENTS, "", STUDENT_BPS, STUDENT_MJ);
+    hashes[events++] = hashGame(g);
+    act(g, r, OBTAIN_PUBLICATION, "", 0, 0);
+    hashes[events++] = hashGame(g);
+    act(g, r, PASS, "", 0, 0);
+    hashes[events++] = hashGame(g);
+    int turn = 0;
+    while (turn < NUM_UNIS) {
+        roll(g, r, 6);
+        hashes[events++] = hashGame(g);
+        turn++;
+    }
+    act(g, r, RETRAIN_STUDENTS, "", STUDENT_MJ, STUDENT_BPS);
+    hashes[events++] = hashGame(g);
+    act(g, r, OBTAIN_ARC, "L", 0, 0);
+    hashes[events++] = hashGame(g);
+    roll(g, r, 8);
+    hashes[events++] = hashGame(g);
+    assert(getMostPublications(g) == UNI_A);
+    assert(getARCs(g, UNI_A) == 1);
+    return events;
+}
+
+
+void roll(Game g, Replay r, int diceScore) {
+    throwDice(g, diceScore);
+    recordThrow(r, diceScore);
+}
+
+
+void act(Game g, Replay r, int actionCode, char *destination,
+        int disciplineFrom, int disciplineTo) {
+    action a = {.actionCode = actionCode,
+        .disciplineFrom = disciplineFrom, .disciplineTo = disciplineTo};
+    strcpy(a.destination, destination);
+    if (actionCode == OBTAIN_PUBLICATION) {
+        a.actionCode = START_SPINOFF;
+    }
+    assert(isLegalAction(g, a));
+    a.actionCode = actionCode;
+    makeAction(g, a);
+    recordAction(r, a);
+}
+
+
+void writeFile(const char *text) {
+    FILE *file = fopen(REPLAY_FILE, "w");
+    fputs(text, file);
+    fclose(file);
+}
@@ -0,0 +1,331 @@
+/*
+ * testRollout.c - checks the rollout engine plays by Game.c's rules
+ *
+ * Plays seeded random games through Rollout.c and Game.c side by side
+ * and checks after every move and dice roll that both agree on
+ * everything, including which moves are legal.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+// the board from Game.h, which has a 7 on the THD region
+#define SEVEN_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  7,  9,  2,  8, 10, \
+    5 }
+
+#define NUM_SEEDS 20
+#define STEPS_PER_GAME 3000
+
+
+void testBoardGraph(void);
+void testLockstep(void);
+void testPlayout(void);
+
+// play one seeded game both ways
+void playLockstep(int dice[], unsigned int seed);
+
+// assert the rollout and the game agree on everything
+void checkSameState(rollout *r, Game g);
+
+// every listed move is legal in g and there are as many as counted
+void checkMoveList(rollout *r, Game g);
+
+// count the current player's legal actions the slow way, through
+// isLegalAction() on every vertex, edge and retraining
+int countLegalActions(Game g);
+
+
+int main(int argc, char *argv[]) {
+    testBoardGraph();
+    testLockstep();
+    testPlayout();
+
+    printf("All rollout tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// every vertex and edge is reached by its path, and the adjacency
+// tables agree with each other
+void testBoardGraph(void) {
+    printf("Testing the board graph\n");
+    const boardGraph *graph = getBoardGraph();
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        assert(vertexOfPath(pathOfVertex(v)) == v);
+        int i = 0;
+        while (i < 3) {
+            int next = graph->vertexNeighbours[v][i];
+            if (next != NO_VERTEX) {
+                int e = graph->vertexEdges[v][i];
+                assert(graph->neighbourSet[next] & VERTEX_BIT(v));
+                assert(graph->edgeEndSet[e]
+                        == (VERTEX_BIT(v) | VERTEX_BIT(next)));
+                assert(edgeSetHas(&graph->vertexEdgeSet[v], e));
+            }
+            i++;
+        }
+        v++;
+    }
+
+    int e = 0;
+    while (e < NUM_EDGES) {
+        assert(edgeOfPath(pathOfEdge(e)) == e);
+        assert(__builtin_popcountll(graph->edgeEndSet[e]) == 2);
+        e++;
+    }
+
+    // UNI_A's first campus is where every path starts
+    assert(pathOfVertex(vertexOfPath(""))[0] == 0);
+    assert(graph->vertexRetrain[vertexOfPath("")] == -1);
+
+    // two retraining centres for every discipline but THD
+    int centres[NUM_DISCIPLINES] = {0};
+    v = 0;
+    while (v < NUM_VERTICES) {
+        if (graph->vertexRetrain[v] != -1) {
+            centres[graph->vertexRetrain[v]]++;
+        }
+        v++;
+    }
+    assert(centres[STUDENT_THD] == 0);
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        assert(centres[discipline] == 2);
+        discipline++;
+    }
+}
+
+
+void testLockstep(void) {
+    printf("Testing rollouts against Game.c\n");
+    int dice[] = DEFAULT_DICE;
+    int sevenDice[] = SEVEN_DICE;
+
+    unsigned int seed = 1;
+    while (seed <= NUM_SEEDS) {
+        playLockstep(dice, seed);
+        playLockstep(sevenDice, seed);
+        seed++;
+    }
+}
+
+
+void testPlayout(void) {
+    printf("Testing playouts\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+
+    // the same seed plays the same game
+    rollout first;
+    rollout second;
+    rolloutFromGame(&first, &board, g, 42);
+    rolloutFromGame(&second, &board, g, 42);
+    int winner = rolloutPlayout(&first, 10000);
+    assert(rolloutPlayout(&second, 10000) == winner);
+    assert(memcmp(&first, &second, sizeof(rollout)) == 0);
+    assert(first.turnNumber >= 0);
+    if (winner != NO_ONE) {
+        assert(first.kpi[winner-1] >= WINNING_KPI);
+    }
+
+    // a turn limit of 0 still gets the game out of Terra Nullis
+    rolloutFromGame(&first, &board, g, 7);
+    assert(rolloutPlayout(&first, 0) == NO_ONE);
+    assert(first.turnNumber == 0);
+
+    disposeGame(g);
+}
+
+
+// Each step either throws the dice (when the rollout picks PASS) or
+// makes the move the rollout picked in both, giving Game.c the
+// spinoff outcome the rollout rolled
+void playLockstep(int dice[], unsigned int seed) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, seed);
+    checkSameState(&r, g);
+
+    int steps = 0;
+    while (steps < STEPS_PER_GAME) {
+        rolloutMove move = {.actionCode = PASS};
+        if (getTurnNumber(g) != -1) {
+            assert(rolloutCountMoves(&r) == countLegalActions(g));
+            checkMoveList(&r, g);
+            move = rolloutRandomMove(&r);
+        }
+
+        if (move.actionCode == PASS) {
+            int diceScore = rolloutRollDice(&r);
+            rolloutThrowDice(&r, diceScore);
+            throwDice(g, diceScore);
+        } else {
+            action a = rolloutMoveToAction(&r, &move);
+            assert(isLegalAction(g, a));
+            rolloutMakeMove(&r, &move);
+            a.actionCode = move.actionCode;
+            makeAction(g, a);
+        }
+        checkSameState(&r, g);
+        steps++;
+    }
+
+    disposeGame(g);
+}
+
+
+void checkMoveList(rollout *r, Game g) {
+    rolloutMove moves[MAX_ROLLOUT_MOVES];
+    int count = rolloutListMoves(r, moves);
+    assert(count == rolloutCountMoves(r));
+    assert(moves[0].actionCode == PASS);
+    int i = 1;
+    while (i < count) {
+        action a = rolloutMoveToAction(r, &moves[i]);
+        assert(isLegalAction(g, a));
+        i++;
+    }
+}
+
+
+void checkSameState(rollout *r, Game g) {
+    assert(r->turnNumber == getTurnNumber(g));
+    assert(rolloutWhoseTurn(r) == getWhoseTurn(g));
+    assert(r->mostARCs == getMostARCs(g));
+    assert(r->mostPubs == getMostPublications(g));
+
+    int player = UNI_A;
+    while (player <= UNI_C) {
+        int i = player - 1;
+        assert(r->kpi[i] == getKPIpoints(g, player));
+        assert(r->numARCs[i] == getARCs(g, player));
+        assert(r->numCampuses[i] == getCampuses(g, player));
+        assert(r->numGO8s[i] == getGO8s(g, player));
+        assert(r->numIPs[i] == getIPs(g, player));
+        assert(r->numPubs[i] == getPublications(g, player));
+
+        // the game's frontiers are the places the rollout builds
+        edgeSet arcs = getARCFrontier(g, player);
+        assert(getCampusFrontier(g, player)
+                == (r->arcEnds[i] & ~(r->occupied | r->blocked)));
+        assert(arcs.bits[0] == (r->arcReach[i].bits[0]
+                    & ~r->arcsTaken.bits[0]));
+        assert(arcs.bits[1] == (r->arcReach[i].bits[1]
+                    & ~r->arcsTaken.bits[1]));
+        int discipline = STUDENT_THD;
+        while (discipline <= STUDENT_MMONEY) {
+            assert(r->students[i][discipline]
+                    == getStudents(g, player, discipline));
+            discipline++;
+        }
+        player++;
+    }
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        int contents = VACANT_VERTEX;
+        player = UNI_A;
+        while (player <= UNI_C) {
+            if (r->campuses[player-1] & VERTEX_BIT(v)) {
+                contents = CAMPUS_A + player - UNI_A;
+            } else if (r->go8s[player-1] & VERTEX_BIT(v)) {
+                contents = GO8_A + player - UNI_A;
+            }
+            player++;
+        }
+        assert(contents == getCampusAt(g, v));
+        v++;
+    }
+
+    int e = 0;
+    while (e < NUM_EDGES) {
+        int contents = VACANT_ARC;
+        player = UNI_A;
+        while (player <= UNI_C) {
+            if (edgeSetHas(&r->arcs[player-1], e)) {
+                contents = ARC_A + player - UNI_A;
+            }
+            player++;
+        }
+        assert(contents == getARCAt(g, e));
+        e++;
+    }
+}
+
+
+int countLegalActions(Game g) {
+    action a;
+    memset(&a, 0, sizeof(action));
+    int count = 0;
+
+    a.actionCode = PASS;
+    count += isLegalAction(g, a);
+    a.actionCode = START_SPINOFF;
+    count += isLegalAction(g, a);
+
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        strcpy(a.destination, pathOfVertex(v));
+        a.actionCode = BUILD_CAMPUS;
+        count += isLegalAction(g, a);
+        a.actionCode = BUILD_GO8;
+        count += isLegalAction(g, a);
+        v++;
+    }
+
+    int e = 0;
+    while (e < NUM_EDGES) {
+        strcpy(a.destination, pathOfEdge(e));
+        a.actionCode = OBTAIN_ARC;
+        count += isLegalAction(g, a);
+        e++;
+    }
+
+    // rollouts leave out retraining to the same discipline
+    a.actionCode = RETRAIN_STUDENTS;
+    a.disciplineFrom = STUDENT_THD;
+    while (a.disciplineFrom <= STUDENT_MMONEY) {
+        a.disciplineTo = STUDENT_THD;
+        while (a.disciplineTo <= STUDENT_MMONEY) {
+            if (a.disciplineTo != a.disciplineFrom) {
+                count += isLegalAction(g, a);
+            }
+            a.disciplineTo++;
+        }
+        a.disciplineFrom++;
+    }
+
+    return count;
+}
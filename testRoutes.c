@@ -0,0 +1,202 @@
+/*
+ * testRoutes.c - checks the ARC route planner
+ *
+ * Every route it plans has to be the right length and buildable one
+ * ARC at a time, and other unis' ARCs have to block it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Routes.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+
+void testDistances(void);
+void testRoutesBuild(void);
+void testBlockedRoutes(void);
+
+// check every route the player could plan in g is buildable
+void checkEveryRoute(Game g, int player);
+
+// make an ARC for whoever's turn it is
+void buildARC(Game g, const char *destination);
+
+
+int main(int argc, char *argv[]) {
+    testDistances();
+    testRoutesBuild();
+    testBlockedRoutes();
+
+    printf("All route tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testDistances(void) {
+    printf("Testing ARC distances\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    int distance[NUM_VERTICES];
+
+    getARCDistances(g, UNI_A, distance);
+    assert(distance[vertexOfPath("")] == 0);
+    assert(distance[vertexOfPath("L")] == 1);
+    assert(distance[vertexOfPath("LR")] == 2);
+    assert(distance[vertexOfPath("RRLRL")] > 0);
+
+    // an ARC brings everything past it one closer
+    throwDice(g, 11);
+    buildARC(g, "L");
+    getARCDistances(g, UNI_A, distance);
+    assert(distance[vertexOfPath("L")] == 0);
+    assert(distance[vertexOfPath("LR")] == 1);
+
+    // the single target query agrees with the table
+    arcRoute route;
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        assert(planARCRoute(g, UNI_A, v, &route) == distance[v]);
+        assert(route.numARCs == distance[v]);
+        v++;
+    }
+
+    // the route to "LRR" is the ARC "LR" then "LRR", and a campus can
+    // go at the end of it but not at the end of "L"
+    assert(planARCRoute(g, UNI_A, vertexOfPath("LRR"), &route) == 2);
+    assert(route.edges[0] == edgeOfPath("LR"));
+    assert(route.edges[1] == edgeOfPath("LRR"));
+    assert(route.students[STUDENT_BPS] == 2);
+    assert(route.students[STUDENT_BQN] == 2);
+    assert(route.students[STUDENT_MJ] == 0);
+    assert(route.campusSpot == TRUE);
+    assert(planARCRoute(g, UNI_A, vertexOfPath("L"), &route) == 0);
+    assert(route.campusSpot == FALSE);
+
+    disposeGame(g);
+}
+
+
+void testRoutesBuild(void) {
+    printf("Testing routes can be built\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+
+    checkEveryRoute(g, UNI_A);
+    throwDice(g, 11);
+    buildARC(g, "L");
+    buildARC(g, "LR");
+    throwDice(g, 11);
+    buildARC(g, "LRR");
+    checkEveryRoute(g, UNI_A);
+    checkEveryRoute(g, UNI_B);
+    checkEveryRoute(g, UNI_C);
+
+    disposeGame(g);
+}
+
+
+void testBlockedRoutes(void) {
+    printf("Testing blocked routes\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    const boardGraph *graph = getBoardGraph();
+    Game g = newGame(disciplines, dice);
+    int distance[NUM_VERTICES];
+
+    // UNI_B takes the ARC "L" so UNI_A has to go the long way round
+    throwDice(g, 11);
+    throwDice(g, 11);
+    buildARC(g, "L");
+    getARCDistances(g, UNI_A, distance);
+    assert(distance[vertexOfPath("L")] > 1);
+    checkEveryRoute(g, UNI_A);
+
+    // with every edge out of UNI_A's campuses taken nothing else can
+    // be reached
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        if (getCampusAt(g, v) == CAMPUS_A) {
+            int i = 0;
+            while (i < 3) {
+                int edge = graph->vertexEdges[v][i];
+                if (edge != NO_EDGE && getARCAt(g, edge) == VACANT_ARC) {
+                    buildARC(g, pathOfEdge(edge));
+                }
+                i++;
+            }
+        }
+        v++;
+    }
+
+    getARCDistances(g, UNI_A, distance);
+    arcRoute route;
+    v = 0;
+    while (v < NUM_VERTICES) {
+        if (getCampusAt(g, v) == CAMPUS_A) {
+            assert(distance[v] == 0);
+        } else {
+            assert(distance[v] == NO_ROUTE);
+            assert(planARCRoute(g, UNI_A, v, &route) == NO_ROUTE);
+            assert(route.numARCs == 0);
+        }
+        v++;
+    }
+
+    disposeGame(g);
+}
+
+
+// Build each route on a copy of the game, checking each ARC is free
+// and touching the network when its turn comes
+void checkEveryRoute(Game g, int player) {
+    int v = 0;
+    while (v < NUM_VERTICES) {
+        arcRoute route;
+        int length = planARCRoute(g, player, v, &route);
+        if (length != NO_ROUTE) {
+            Game copy = cloneGame(g);
+            while (getWhoseTurn(copy) != player) {
+                throwDice(copy, 11);
+            }
+            int i = 0;
+            while (i < route.numARCs) {
+                int edge = route.edges[i];
+                assert(getARCAt(copy, edge) == VACANT_ARC);
+                assert(isTouchingNetwork(copy, player, edge));
+                buildARC(copy, pathOfEdge(edge));
+                i++;
+            }
+            assert(isOnNetwork(copy, player, v));
+            disposeGame(copy);
+        }
+        v++;
+    }
+}
+
+
+void buildARC(Game g, const char *destination) {
+    action a = {.actionCode = OBTAIN_ARC};
+    strcpy(a.destination, destination);
+    makeAction(g, a);
+}
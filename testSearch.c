@@ -0,0 +1,339 @@
+/*
+ * testSearch.c - checks the anytime search and the time manager
+ *
+ * Positions are made in Game.c, and given more students in the rollout
+ * where the search needs more to think about.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Planner.h"
+#include "Forecast.h"
+#include "Endgame.h"
+#include "Macro.h"
+#include "Search.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+// more time than any of the searches here need
+#define PLENTY_OF_TIME 60.0
+#define SHORT_TIME 0.01
+
+// the short search has to stop well inside this, allowing for the
+// first depth and a slow machine
+#define SHORT_TIME_LIMIT 1.0
+
+// the students each discipline is given for a search too big to finish
+#define MANY_STUDENTS 30
+
+#define SECONDS_PER_TURN 1.0
+#define ROUNDING 1e-9
+
+// how many of UNI_A's turns a game's worth of time is
+#define BUDGET_TURNS 60
+
+
+void testTerraNullis(void);
+void testWinningNow(void);
+void testComplete(void);
+void testDeadline(void);
+void testTimeManager(void);
+void testTimeBudget(void);
+
+// a game a few turns in, UNI_A to play
+Game makeTestGame(void);
+
+// make the macro in g, with a spinoff becoming a publication
+void makeMacro(Game g, const searchResult *result);
+
+// throw the dice until it is UNI_A's turn again
+void nextTurn(Game g);
+
+
+int main(int argc, char *argv[]) {
+    testTerraNullis();
+    testWinningNow();
+    testComplete();
+    testDeadline();
+    testTimeManager();
+    testTimeBudget();
+
+    printf("All search tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+void testTerraNullis(void) {
+    printf("Testing the search in Terra Nullis\n");
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    Search s = newSearch();
+    searchResult result;
+
+    searchGameMacro(s, g, PLENTY_OF_TIME, &result);
+    assert(result.macro.numActions == 1);
+    assert(result.macro.actions[0].actionCode == PASS);
+    assert(result.depth == 0);
+    assert(result.nodes == 0);
+    assert(gamePhase(g) == OPENING_PHASE);
+
+    disposeSearch(s);
+    disposeGame(g);
+}
+
+
+// An ARC from winning, the search finds one and is sure of it
+void testWinningNow(void) {
+    printf("Testing a win this turn\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    r.kpi[UNI_A-1] = WINNING_KPI - ARC_KPI;
+
+    Search s = newSearch();
+    searchResult result;
+    searchMacro(s, &r, PLENTY_OF_TIME, MAX_SEARCH_DEPTH, &result);
+    assert(result.winChance == 1);
+    assert(result.depth >= 1);
+    assert(result.build.actionCode != START_SPINOFF);
+    rolloutMakeMacro(&r, &result.build);
+    assert(r.kpi[UNI_A-1] >= WINNING_KPI);
+    makeMacro(g, &result);
+
+    disposeSearch(s);
+    disposeGame(g);
+}
+
+
+// With time to spare the search sees the whole turn and stops. Each
+// depth is at least as good as the one before, and what it chooses can
+// be made in the game
+void testComplete(void) {
+    printf("Testing a search that finishes\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+
+    Search s = newSearch();
+    searchResult result;
+    searchMacro(s, &r, PLENTY_OF_TIME, MAX_SEARCH_DEPTH, &result);
+    assert(result.complete);
+    assert(result.depth >= 1 && result.depth < MAX_SEARCH_DEPTH);
+    assert(result.winChance > 0 && result.winChance < 1);
+
+    double last = 0;
+    int depth = 1;
+    while (depth <= result.depth) {
+        searchResult shallower;
+        searchMacro(s, &r, PLENTY_OF_TIME, depth, &shallower);
+        assert(shallower.depth == depth);
+        assert(shallower.winChance >= last - ROUNDING);
+        assert(shallower.complete == (depth == result.depth));
+        last = shallower.winChance;
+        depth++;
+    }
+    assert(last == result.winChance);
+
+    // the best purchase on its own scores what the search said it would
+    assert(searchBuildValue(s, &r, &result.build, result.depth)
+            == result.winChance);
+
+    makeMacro(g, &result);
+
+    disposeSearch(s);
+    disposeGame(g);
+}
+
+
+// Too much to search stops in time, with an answer from at least the
+// first depth that can be made
+void testDeadline(void) {
+    printf("Testing the deadline\n");
+    Game g = makeTestGame();
+    rolloutBoard board;
+    rolloutBoardFromGame(&board, g);
+    rollout r;
+    rolloutFromGame(&r, &board, g, 0);
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        r.students[UNI_A-1][discipline] = MANY_STUDENTS;
+        discipline++;
+    }
+
+    Search s = newSearch();
+    searchResult result;
+    searchMacro(s, &r, SHORT_TIME, MAX_SEARCH_DEPTH, &result);
+    assert(!result.complete);
+    assert(result.depth >= 1);
+    assert(result.seconds < SHORT_TIME_LIMIT);
+    assert(result.macro.actions[0].actionCode != PASS);
+
+    rollout after = r;
+    rolloutMakeMacro(&after, &result.build);
+    discipline = 0;
+    while (discipline < NUM_DISCIPLINES) {
+        assert(after.students[UNI_A-1][discipline] >= 0);
+        discipline++;
+    }
+
+    disposeSearch(s);
+    disposeGame(g);
+}
+
+
+// A turn never gives out more than its share, what it doesn't use is
+// saved for later turns and going over is paid back
+void testTimeManager(void) {
+    printf("Testing the time manager\n");
+    Game g = makeTestGame();
+    assert(gamePhase(g) == OPENING_PHASE);
+
+    TimeManager t = newTimeManager(SECONDS_PER_TURN);
+    double total = 0;
+    int decision = 0;
+    while (decision < MAX_EXPECTED_ACTIONS * 2) {
+        double seconds = allotTime(t, g);
+        assert(seconds >= 0);
+        spendTime(t, seconds);
+        total += seconds;
+        decision++;
+    }
+    assert(total > 0);
+    assert(total <= SECONDS_PER_TURN * OPENING_SHARE + ROUNDING);
+    assert(fabs(bankedTime(t) - SECONDS_PER_TURN * (1 - OPENING_SHARE))
+            < ROUNDING);
+
+    // a turn with nothing spent is saved
+    nextTurn(g);
+    double leftOver = SECONDS_PER_TURN * OPENING_SHARE - total;
+    allotTime(t, g);
+    nextTurn(g);
+    allotTime(t, g);
+    assert(bankedTime(t) > leftOver);
+
+    // going well over takes the time from the turns after
+    spendTime(t, SECONDS_PER_TURN * BANK_TURNS * 10);
+    nextTurn(g);
+    assert(allotTime(t, g) == 0);
+    assert(bankedTime(t) < 0);
+
+    while (getTurnNumber(g) < OPENING_TURNS) {
+        nextTurn(g);
+    }
+    assert(gamePhase(g) == MIDDLE_PHASE);
+
+    disposeTimeManager(t);
+    disposeGame(g);
+}
+
+
+// A whole game of using up every turn's time never takes more than
+// SECONDS_PER_TURN a turn, and the endgame gets the time the opening
+// saved
+void testTimeBudget(void) {
+    printf("Testing a game's worth of time\n");
+    Game g = makeTestGame();
+    TimeManager t = newTimeManager(SECONDS_PER_TURN);
+    double total = 0;
+    int turns = 0;
+    int endgameTurns = 0;
+    double firstEndgameTurn = 0;
+
+    while (turns < BUDGET_TURNS) {
+        assert(getWhoseTurn(g) == UNI_A);
+
+        double turn = 0;
+        int decision = 0;
+        while (decision < MAX_EXPECTED_ACTIONS * 2) {
+            double seconds = allotTime(t, g);
+            spendTime(t, seconds);
+            turn += seconds;
+            decision++;
+        }
+        if (gamePhase(g) == ENDGAME_PHASE) {
+            if (endgameTurns == 0) {
+                firstEndgameTurn = turn;
+            }
+            endgameTurns++;
+        }
+        total += turn;
+        turns++;
+        assert(total <= turns * SECONDS_PER_TURN + ROUNDING);
+
+        // UNI_B gets near the end halfway through
+        if (turns == BUDGET_TURNS / 2) {
+            throwDice(g, 6);
+            action patent = {.actionCode = OBTAIN_IP_PATENT};
+            while (getKPIpoints(g, UNI_B) < WINNING_KPI - ENDGAME_KPI) {
+                makeAction(g, patent);
+            }
+            throwDice(g, 7);
+            throwDice(g, 8);
+        } else {
+            nextTurn(g);
+        }
+    }
+    assert(endgameTurns == BUDGET_TURNS - BUDGET_TURNS / 2);
+    assert(firstEndgameTurn > SECONDS_PER_TURN);
+
+    disposeTimeManager(t);
+    disposeGame(g);
+}
+
+
+Game makeTestGame(void) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    int turn = 0;
+    while (turn < 10) {
+        throwDice(g, 6 + turn % 3);
+        turn++;
+    }
+    assert(getWhoseTurn(g) == UNI_A);
+    return g;
+}
+
+
+void makeMacro(Game g, const searchResult *result) {
+    macroAction macro = result->macro;
+    action *bought = &macro.actions[macro.numActions-1];
+    if (bought->actionCode == START_SPINOFF) {
+        bought->actionCode = OBTAIN_PUBLICATION;
+    }
+    assert(makeMacroAction(g, &macro) == ALL_ACTIONS_APPLIED);
+}
+
+
+void nextTurn(Game g) {
+    int turn = 0;
+    while (turn < NUM_UNIS) {
+        throwDice(g, 6 + turn % 3);
+        turn++;
+    }
+}
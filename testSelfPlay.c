@@ -0,0 +1,290 @@
+/*
+ * testSelfPlay.c - checks packed positions, the greedy bots, self-play
+ * games and shard files
+ *
+ * Writes a shard file in the current directory and removes it again.
+ */
+
+// for truncate()
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "SelfPlay.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define SHARD_FILE "testSelfPlay.tmp"
+
+#define NUM_RANDOM_MOVES 5000
+#define NUM_TEST_GAMES 20
+#define TEST_SEED 1917
+
+
+void testPackPositions(void);
+void testGreedyMove(void);
+void testSelfPlayGames(void);
+void testShards(void);
+
+// the start of a game on the default board
+void makeStart(rolloutBoard *board, rollout *start);
+
+// TRUE if a and b are the same apart from their random numbers
+int sameRollout(const rollout *a, const rollout *b);
+
+
+int main(int argc, char *argv[]) {
+    testPackPositions();
+    testGreedyMove();
+    testSelfPlayGames();
+    testShards();
+
+    printf("All self-play tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// Packing every position of a random game and unpacking it again gets
+// the same rollout back
+void testPackPositions(void) {
+    printf("Testing packing positions\n");
+    assert(sizeof(packedPosition) == PACKED_POSITION_BYTES);
+    assert(sizeof(trainingRecord) == TRAINING_RECORD_BYTES);
+
+    rolloutBoard board;
+    rollout r;
+    makeStart(&board, &r);
+    packedPosition p;
+    rollout unpacked;
+    rolloutPack(&r, &p);
+    rolloutUnpack(&unpacked, &board, &p, 0);
+    assert(sameRollout(&r, &unpacked));
+
+    int move = 0;
+    while (move < NUM_RANDOM_MOVES) {
+        rolloutMove chosen = rolloutRandomMove(&r);
+        if (chosen.actionCode == PASS) {
+            rolloutThrowDice(&r, rolloutRollDice(&r));
+        } else {
+            rolloutMakeMove(&r, &chosen);
+        }
+        rolloutPack(&r, &p);
+        rolloutUnpack(&unpacked, &board, &p, move);
+        assert(sameRollout(&r, &unpacked));
+        move++;
+    }
+}
+
+
+void testGreedyMove(void) {
+    printf("Testing the greedy bots\n");
+    rolloutBoard board;
+    rollout r;
+    makeStart(&board, &r);
+    rolloutThrowDice(&r, 8);
+
+    // UNI_A can pay for an ARC or a spinoff, with nowhere to put a
+    // campus yet
+    double weights[NUM_GREEDY_WEIGHTS];
+    defaultGreedyWeights(weights);
+    rolloutMove build = greedyMacroMove(&r, weights);
+    assert(build.actionCode == START_SPINOFF);
+    weights[GREEDY_SPINOFF] = 0;
+    build = greedyMacroMove(&r, weights);
+    assert(build.actionCode == OBTAIN_ARC);
+
+    // nothing is worth buying
+    weights[GREEDY_ARC] = -1;
+    build = greedyMacroMove(&r, weights);
+    assert(build.actionCode == PASS);
+
+    // with plenty of students a GO8 is worth more than anything else
+    defaultGreedyWeights(weights);
+    int discipline = STUDENT_BPS;
+    while (discipline <= STUDENT_MMONEY) {
+        r.students[UNI_A-1][discipline] = 10;
+        discipline++;
+    }
+    build = greedyMacroMove(&r, weights);
+    assert(build.actionCode == BUILD_GO8);
+    assert(r.campuses[UNI_A-1] & VERTEX_BIT(build.target));
+}
+
+
+// Games end with a winner or the turn limit, every decision is kept
+// with the ending, the same seed plays the same game and rolls the
+// same dice for different bots
+void testSelfPlayGames(void) {
+    printf("Testing self-play games\n");
+    rolloutBoard board;
+    rollout start;
+    makeStart(&board, &start);
+    double weights[NUM_GREEDY_WEIGHTS];
+    defaultGreedyWeights(weights);
+    const double *everyone[NUM_UNIS] = {weights, weights, weights};
+
+    int won = 0;
+    int seed = 0;
+    while (seed < NUM_TEST_GAMES) {
+        selfPlayResult result;
+        selfPlayGame(&start, everyone, SELF_PLAY_EXPLORE, seed, TRUE,
+                &result);
+        assert(result.numRecords > result.turns);
+        if (result.winner != NO_ONE) {
+            assert(result.kpi[result.winner-1] >= WINNING_KPI);
+            won++;
+        } else {
+            assert(result.turns == SELF_PLAY_MAX_TURNS);
+        }
+
+        int last = -1;
+        int i = 0;
+        while (i < result.numRecords) {
+            trainingRecord *record = &result.records[i];
+            assert(record->winner == result.winner);
+            int uni = 0;
+            while (uni < NUM_UNIS && result.winner != NO_ONE) {
+                assert((record->margins[uni] > 0)
+                        == (result.winner == uni + 1));
+                uni++;
+            }
+            assert(record->position.turnNumber >= last);
+            last = record->position.turnNumber;
+            i++;
+        }
+
+        selfPlayResult again;
+        selfPlayGame(&start, everyone, SELF_PLAY_EXPLORE, seed, TRUE,
+                &again);
+        assert(again.numRecords == result.numRecords);
+        assert(memcmp(again.records, result.records,
+                    result.numRecords * sizeof(trainingRecord)) == 0);
+        disposeSelfPlayRecords(&again);
+        disposeSelfPlayRecords(&result);
+        seed++;
+    }
+    assert(won > 0);
+
+    // bots that never buy anything only get what the dice give them,
+    // and the dice are the same whoever plays
+    double never[NUM_GREEDY_WEIGHTS] = {-1, -1, -1, -1, 0, 0};
+    const double *nobody[NUM_UNIS] = {never, never, never};
+    const double *onlyA[NUM_UNIS] = {weights, never, never};
+    selfPlayResult passing;
+    selfPlayResult buying;
+    selfPlayGame(&start, nobody, 0, TEST_SEED, TRUE, &passing);
+    selfPlayGame(&start, onlyA, 0, TEST_SEED, TRUE, &buying);
+    assert(passing.winner == NO_ONE);
+    assert(passing.numRecords == SELF_PLAY_MAX_TURNS);
+    int i = 0;
+    while (i < buying.numRecords) {
+        packedPosition *p = &buying.records[i].position;
+        packedPosition *same = &passing.records[p->turnNumber].position;
+        assert(same->turnNumber == p->turnNumber);
+        assert(memcmp(p->students[UNI_B-1], same->students[UNI_B-1],
+                    2 * sizeof(p->students[0])) == 0);
+        i++;
+    }
+    disposeSelfPlayRecords(&buying);
+    disposeSelfPlayRecords(&passing);
+}
+
+
+void testShards(void) {
+    printf("Testing shard files\n");
+    rolloutBoard board;
+    rollout start;
+    makeStart(&board, &start);
+    double weights[NUM_GREEDY_WEIGHTS];
+    defaultGreedyWeights(weights);
+    const double *everyone[NUM_UNIS] = {weights, weights, weights};
+    selfPlayResult first;
+    selfPlayResult second;
+    selfPlayGame(&start, everyone, SELF_PLAY_EXPLORE, 1, TRUE, &first);
+    selfPlayGame(&start, everyone, SELF_PLAY_EXPLORE, 2, TRUE, &second);
+
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Shard s = newShard(SHARD_FILE, disciplines, dice);
+    assert(s != NULL);
+    assert(shardBytes(s) == sizeof(shardHeader));
+    assert(shardWrite(s, first.records, first.numRecords));
+    assert(shardWrite(s, second.records, second.numRecords));
+    long bytes = shardBytes(s);
+    assert(bytes == (long)(sizeof(shardHeader) + (first.numRecords
+                    + second.numRecords) * sizeof(trainingRecord)));
+    assert(closeShard(s));
+
+    // the board comes back with the records, and a position from the
+    // shard unpacks onto it
+    shardHeader header;
+    trainingRecord *records = loadShard(SHARD_FILE, &header);
+    assert(records != NULL);
+    assert(header.numRecords == first.numRecords + second.numRecords);
+    assert(memcmp(records, first.records,
+                first.numRecords * sizeof(trainingRecord)) == 0);
+    assert(memcmp(&records[first.numRecords], second.records,
+                second.numRecords * sizeof(trainingRecord)) == 0);
+    int region = 0;
+    while (region < NUM_REGIONS) {
+        assert(header.discipline[region] == disciplines[region]);
+        assert(header.dice[region] == dice[region]);
+        region++;
+    }
+    rollout unpacked;
+    rolloutUnpack(&unpacked, &board, &records[first.numRecords].position, 0);
+    assert(unpacked.turnNumber == 0);
+    free(records);
+
+    // cut short, or not a shard at all
+    assert(truncate(SHARD_FILE, bytes - 1) == 0);
+    assert(loadShard(SHARD_FILE, &header) == NULL);
+    FILE *file = fopen(SHARD_FILE, "wb");
+    fprintf(file, "this is not a shard, but it is long enough to have "
+            "what could be a header\n");
+    fclose(file);
+    assert(loadShard(SHARD_FILE, &header) == NULL);
+    remove(SHARD_FILE);
+    assert(loadShard(SHARD_FILE, &header) == NULL);
+
+    disposeSelfPlayRecords(&second);
+    disposeSelfPlayRecords(&first);
+}
+
+
+void makeStart(rolloutBoard *board, rollout *start) {
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoardFromGame(board, g);
+    rolloutFromGame(start, board, g, 0);
+    disposeGame(g);
+}
+
+
+int sameRollout(const rollout *a, const rollout *b) {
+    rollout copy = *b;
+    copy.rng = a->rng;
+    return memcmp(a, &copy, sizeof(rollout)) == 0;
+}
@@ -40,9 +40,6 @@ static int isPathContained(path inPath);
 // static int isARCConnected(path inPath, int player);
 // static int isCampusConnected(path inPath, int player);
 
-// returns true if there are campuses next to the vertex at inPath
-static int isCampusTooClose(Game g, path inPath);
-
 int main (int argc, char *argv[]) {
 
     // Assert that regions are being converted to and from coordinates 
@@ -223,16 +220,16 @@ int main (int argc, char *argv[]) {
     assert(test.vertNum == -1);
 
 
-    // check that isCampusTooClose works correctly
-    puts("Testing isCampusTooClose()");
+    // check that the starting campuses block the vertices next to them
+    puts("Testing campusBlocked");
     int disciplines[] = DEFAULT_DISCIPLINES;
     int dice[] = DEFAULT_DICE;
     Game g = newGame(disciplines, dice);
-    assert(isCampusTooClose(g, "R") == TRUE);
-    assert(isCampusTooClose(g, "L") == TRUE);
-    assert(isCampusTooClose(g, "RR") == FALSE);
-    assert(isCampusTooClose(g, "LR") == FALSE);
-    assert(isCampusTooClose(g, "RRLR") == TRUE);
+    assert(g->campusBlocked & VERTEX_BIT(vertexOfPath("R")));
+    assert(g->campusBlocked & VERTEX_BIT(vertexOfPath("L")));
+    assert(!(g->campusBlocked & VERTEX_BIT(vertexOfPath("RR"))));
+    assert(!(g->campusBlocked & VERTEX_BIT(vertexOfPath("LR"))));
+    assert(g->campusBlocked & VERTEX_BIT(vertexOfPath("RRLR")));
 
 
     puts("All tests for static functions passed!\n");
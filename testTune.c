@@ -0,0 +1,170 @@
+/*
+ * testTune.c - checks the SPSA tuner on made up scores
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+#include "Tune.h"
+
+
+#define NUM_TEST_WEIGHTS 6
+#define TEST_WEIGHTS {10, 12, 3, 4, 20, -1}
+#define TEST_SEED 1917
+
+#define NUM_ITERATIONS 300
+#define NUM_TRIALS 4
+
+
+void testStart(void);
+void testCalibratedStep(void);
+void testSyntheticScore(void);
+
+// a made up score for the weights, best at target and falling away
+// with the square of how many scales they are from it
+double syntheticScore(const double weights[], const double target[],
+        const double scale[]);
+
+
+int main(int argc, char *argv[]) {
+    testStart();
+    testCalibratedStep();
+    testSyntheticScore();
+
+    printf("All tuning tests passed!\n");
+    return EXIT_SUCCESS;
+}
+
+
+// Scales are a fraction of each weight but never below the minimum,
+// candidates are a nudge either side, and the same seed nudges the
+// same way
+void testStart(void) {
+    printf("Testing starting and nudging\n");
+    double start[NUM_TEST_WEIGHTS] = TEST_WEIGHTS;
+    spsa s;
+    spsaStart(&s, start, NUM_TEST_WEIGHTS, NUM_ITERATIONS, TEST_SEED);
+    assert(s.numWeights == NUM_TEST_WEIGHTS && s.k == 0);
+    assert(s.scale[0] == 10 * SPSA_SCALE_FRACTION);
+    assert(s.scale[5] == SPSA_MIN_SCALE);
+
+    double plus[NUM_TEST_WEIGHTS];
+    double minus[NUM_TEST_WEIGHTS];
+    spsaCandidates(&s, plus, minus);
+    assert(s.perturb == SPSA_PERTURB);
+    int w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        assert(s.signs[w] == 1 || s.signs[w] == -1);
+        double nudge = s.signs[w] * s.perturb * s.scale[w];
+        assert(fabs(plus[w] - (start[w] + nudge)) < 1e-9);
+        assert(fabs(minus[w] - (start[w] - nudge)) < 1e-9);
+        w++;
+    }
+
+    spsa again;
+    spsaStart(&again, start, NUM_TEST_WEIGHTS, NUM_ITERATIONS, TEST_SEED);
+    spsaCandidates(&again, plus, minus);
+    assert(memcmp(s.signs, again.signs, sizeof(s.signs)) == 0);
+}
+
+
+// A calibrated first step moves each weight one nudge for the average
+// difference, and no step goes further than SPSA_MAX_STEP nudges
+void testCalibratedStep(void) {
+    printf("Testing calibration\n");
+    double start[NUM_TEST_WEIGHTS] = TEST_WEIGHTS;
+    spsa s;
+    spsaStart(&s, start, NUM_TEST_WEIGHTS, NUM_ITERATIONS, TEST_SEED);
+    double plus[NUM_TEST_WEIGHTS];
+    double minus[NUM_TEST_WEIGHTS];
+
+    // the trials differ by 0.015 on average
+    double differences[] = {0.02, 0, 0.01, 0.03};
+    spsaCalibrate(&s, differences, 4);
+    spsaCandidates(&s, plus, minus);
+    spsaStep(&s, 0.515, 0.5);
+    assert(s.k == 1);
+    int w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        double moved = (s.weights[w] - start[w]) / s.scale[w];
+        assert(fabs(moved - SPSA_PERTURB * s.signs[w]) < 1e-9);
+        w++;
+    }
+
+    // a huge difference is held to the largest step
+    double before[NUM_TEST_WEIGHTS];
+    memcpy(before, s.weights, sizeof(before));
+    spsaCandidates(&s, plus, minus);
+    spsaStep(&s, 1, 0);
+    w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        double moved = (s.weights[w] - before[w]) / s.scale[w];
+        assert(fabs(moved - SPSA_MAX_STEP * s.perturb * s.signs[w])
+                < 1e-9);
+        w++;
+    }
+
+    // if the trials never differ the gain is left alone
+    spsaStart(&s, start, NUM_TEST_WEIGHTS, NUM_ITERATIONS, TEST_SEED);
+    double ties[] = {0, 0};
+    spsaCalibrate(&s, ties, 2);
+    assert(s.gain == SPSA_GAIN);
+}
+
+
+// Tuning a made up score with no noise finds the weights it's best at
+void testSyntheticScore(void) {
+    printf("Testing tuning a made up score\n");
+    double start[NUM_TEST_WEIGHTS] = TEST_WEIGHTS;
+    spsa s;
+    spsaStart(&s, start, NUM_TEST_WEIGHTS, NUM_ITERATIONS, TEST_SEED);
+
+    // the target is a couple of scales away from where it starts
+    double target[NUM_TEST_WEIGHTS];
+    int w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        target[w] = start[w] + (w % 2 == 0 ? 2 : -1.5) * s.scale[w];
+        w++;
+    }
+
+    double plus[NUM_TEST_WEIGHTS];
+    double minus[NUM_TEST_WEIGHTS];
+    double trials[NUM_TRIALS];
+    int i = 0;
+    while (i < NUM_TRIALS) {
+        spsaCandidates(&s, plus, minus);
+        trials[i] = syntheticScore(plus, target, s.scale)
+            - syntheticScore(minus, target, s.scale);
+        i++;
+    }
+    spsaCalibrate(&s, trials, NUM_TRIALS);
+    double before = syntheticScore(s.weights, target, s.scale);
+    i = 0;
+    while (i < NUM_ITERATIONS) {
+        spsaCandidates(&s, plus, minus);
+        spsaStep(&s, syntheticScore(plus, target, s.scale),
+                syntheticScore(minus, target, s.scale));
+        i++;
+    }
+    assert(syntheticScore(s.weights, target, s.scale) > before / 100);
+    w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        assert(fabs(s.weights[w] - target[w]) < 0.25 * s.scale[w]);
+        w++;
+    }
+}
+
+
+double syntheticScore(const double weights[], const double target[],
+        const double scale[]) {
+    double score = 0;
+    int w = 0;
+    while (w < NUM_TEST_WEIGHTS) {
+        double off = (weights[w] - target[w]) / scale[w];
+        score -= off * off;
+        w++;
+    }
+    return score;
+}
@@ -0,0 +1,308 @@
+/*
+ * tuneWeights.c - tunes the greedy bots' weights by self-play
+ *
+ * By Timothy Chin, James Houlahan, Matthew Siesco and Tianqi Liu
+ *
+ * usage: tuneWeights [iterations] [games] [threads]
+ *
+ * threads defaults to one for each processor.
+ *
+ * The weights are tuned by SPSA (see Tune.h): each iteration
+ * plays the weights nudged one way and the weights nudged the other
+ * way games games each against bots with the default weights, and
+ * moves the weights towards whichever won more. Before the first
+ * iteration a few trial nudges are played to calibrate how far the
+ * weights step.
+ *
+ * The two candidates play the same games: game n of an iteration has
+ * the same seed, and so the same dice, for both, and the candidate
+ * takes each seat in turn. So the difference between them is down to
+ * the weights rather than the luck.
+ *
+ * Once tuned, the weights and the defaults play games games each on
+ * seeds none of the tuning used. Each iteration prints how well the
+ * two candidates did, how fast the games went and the weights so far,
+ * and the last line is the tuned weights if they won more of those
+ * games than the defaults, or else the defaults.
+ */
+
+// for clock_gettime() and CLOCK_MONOTONIC
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rollout.h"
+#include "Macro.h"
+#include "SelfPlay.h"
+#include "Tune.h"
+
+
+#define DEFAULT_DISCIPLINES { \
+    STUDENT_BQN,    STUDENT_MMONEY, STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MJ,     STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_MTV,    STUDENT_BPS, \
+    STUDENT_MTV,    STUDENT_BQN,    STUDENT_MJ, \
+    STUDENT_BQN,    STUDENT_THD,    STUDENT_MJ, \
+    STUDENT_MMONEY, STUDENT_MTV,    STUDENT_BQN, \
+    STUDENT_BPS }
+
+#define DEFAULT_DICE { \
+    9, 10,  8, 12,  6,  5,  \
+    3, 11,  3, 11,  4,  6, \
+    4,  9,  9,  2,  8, 10, \
+    5 }
+
+#define DEFAULT_ITERATIONS 50
+#define DEFAULT_GAMES 2000
+#define MAX_THREADS 64
+
+// the two candidates of an iteration
+#define PLUS 0
+#define MINUS 1
+
+// how many trial nudges calibrate the gain, where the signs of the
+// nudges come from and where the seeds of the games checking the tuned
+// weights start
+#define CALIBRATION_TRIALS 4
+#define SPSA_SEED 1917
+#define HELD_OUT_SEED (1ULL << 40)
+
+
+// what the threads playing an iteration share
+typedef struct _iteration {
+    const rollout *start;
+    const double *baseline;
+    double candidates[2][NUM_GREEDY_WEIGHTS];
+    int games;
+    uint64_t firstSeed;
+
+    // the next game nobody has taken yet, and how many games each
+    // candidate has won and drawn so far
+    int next;
+    int wins[2];
+    int draws[2];
+    pthread_mutex_t lock;
+} iteration;
+
+
+// play every game of the iteration with threads threads
+void playIteration(iteration *it, int threads);
+
+// what each thread runs, taking games until there are none left
+void *playGames(void *arg);
+
+// how well a candidate did: 1 for a win and 1/NUM_UNIS for a draw,
+// over the games played
+double candidateScore(const iteration *it, int candidate);
+
+void printWeights(const char *label, const double weights[]);
+
+double secondsSince(const struct timespec *start);
+
+
+int main(int argc, char *argv[]) {
+    if (argc > 4) {
+        fprintf(stderr, "usage: %s [iterations] [games] [threads]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    int iterations = DEFAULT_ITERATIONS;
+    int games = DEFAULT_GAMES;
+    int threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        games = atoi(argv[2]);
+    }
+    if (threads > MAX_THREADS) {
+        threads = MAX_THREADS;
+    }
+    if (argc > 3) {
+        threads = atoi(argv[3]);
+    }
+    if (iterations < 1 || games < 1 || threads < 1
+            || threads > MAX_THREADS) {
+        fprintf(stderr, "iterations, games and threads must be at least "
+                "1 (and at most %d threads)\n", MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    int disciplines[] = DEFAULT_DISCIPLINES;
+    int dice[] = DEFAULT_DICE;
+    Game g = newGame(disciplines, dice);
+    rolloutBoard board;
+    rollout start;
+    rolloutBoardFromGame(&board, g);
+    rolloutFromGame(&start, &board, g, 0);
+    disposeGame(g);
+
+    double baseline[NUM_GREEDY_WEIGHTS];
+    defaultGreedyWeights(baseline);
+    spsa tuner;
+    spsaStart(&tuner, baseline, NUM_GREEDY_WEIGHTS, iterations,
+            SPSA_SEED);
+    printWeights("start", tuner.weights);
+
+    iteration it;
+    it.start = &start;
+    it.baseline = baseline;
+    it.games = games;
+    pthread_mutex_init(&it.lock, NULL);
+
+    // the trials play the seeds after the iterations'
+    struct timespec began;
+    clock_gettime(CLOCK_MONOTONIC, &began);
+    long played = 0;
+    double differences[CALIBRATION_TRIALS];
+    int trial = 0;
+    while (trial < CALIBRATION_TRIALS) {
+        spsaCandidates(&tuner, it.candidates[PLUS],
+                it.candidates[MINUS]);
+        it.firstSeed = (uint64_t)(iterations + trial) * games;
+        playIteration(&it, threads);
+        played += 2 * games;
+        differences[trial] = candidateScore(&it, PLUS)
+            - candidateScore(&it, MINUS);
+        trial++;
+    }
+    spsaCalibrate(&tuner, differences, CALIBRATION_TRIALS);
+    printf("calibrated the gain to %.3f\n", tuner.gain);
+
+    int k = 0;
+    while (k < iterations) {
+        spsaCandidates(&tuner, it.candidates[PLUS],
+                it.candidates[MINUS]);
+        it.firstSeed = (uint64_t)k * games;
+
+        struct timespec iterationBegan;
+        clock_gettime(CLOCK_MONOTONIC, &iterationBegan);
+        playIteration(&it, threads);
+        double seconds = secondsSince(&iterationBegan);
+        played += 2 * games;
+
+        double plus = candidateScore(&it, PLUS);
+        double minus = candidateScore(&it, MINUS);
+        spsaStep(&tuner, plus, minus);
+
+        printf("iteration %d: %.3f vs %.3f, %.0f games/sec\n", k + 1,
+                plus, minus, 2 * games / seconds);
+        printWeights("  weights", tuner.weights);
+        fflush(stdout);
+        k++;
+    }
+
+    // the tuned weights and the defaults play the same held out games
+    memcpy(it.candidates[PLUS], tuner.weights, sizeof(baseline));
+    memcpy(it.candidates[MINUS], baseline, sizeof(baseline));
+    it.firstSeed = HELD_OUT_SEED;
+    playIteration(&it, threads);
+    played += 2 * games;
+    pthread_mutex_destroy(&it.lock);
+    double tuned = candidateScore(&it, PLUS);
+    double defaults = candidateScore(&it, MINUS);
+    printf("held out games: tuned %.3f vs default %.3f\n", tuned,
+            defaults);
+
+    double seconds = secondsSince(&began);
+    printf("%ld games in %.1f seconds (%.0f games/sec)\n", played,
+            seconds, played / seconds);
+    if (tuned > defaults) {
+        printWeights("tuned", tuner.weights);
+    } else {
+        printf("the tuned weights didn't beat the defaults\n");
+        printWeights("default", baseline);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+void playIteration(iteration *it, int threads) {
+    it->next = 0;
+    memset(it->wins, 0, sizeof(it->wins));
+    memset(it->draws, 0, sizeof(it->draws));
+
+    pthread_t ids[MAX_THREADS];
+    int i = 0;
+    while (i < threads) {
+        pthread_create(&ids[i], NULL, playGames, it);
+        i++;
+    }
+    i = 0;
+    while (i < threads) {
+        pthread_join(ids[i], NULL);
+        i++;
+    }
+}
+
+
+// Game 2n is game n for PLUS and game 2n+1 the same game for MINUS.
+// Nothing is recorded and nobody explores, so a game is only a few
+// rollouts' worth of work
+void *playGames(void *arg) {
+    iteration *it = arg;
+    int taken = TRUE;
+    while (taken) {
+        pthread_mutex_lock(&it->lock);
+        int game = it->next;
+        it->next++;
+        pthread_mutex_unlock(&it->lock);
+
+        taken = (game < 2 * it->games);
+        if (taken) {
+            int candidate = game % 2;
+            int n = game / 2;
+            int seat = n % NUM_UNIS;
+            const double *weights[NUM_UNIS];
+            int i = 0;
+            while (i < NUM_UNIS) {
+                weights[i] = it->baseline;
+                i++;
+            }
+            weights[seat] = it->candidates[candidate];
+
+            selfPlayResult result;
+            selfPlayGame(it->start, weights, 0, it->firstSeed + n, FALSE,
+                    &result);
+            pthread_mutex_lock(&it->lock);
+            if (result.winner == seat + 1) {
+                it->wins[candidate]++;
+            } else if (result.winner == NO_ONE) {
+                it->draws[candidate]++;
+            }
+            pthread_mutex_unlock(&it->lock);
+        }
+    }
+    return NULL;
+}
+
+
+double candidateScore(const iteration *it, int candidate) {
+    return (it->wins[candidate] + it->draws[candidate] / (double)NUM_UNIS)
+        / it->games;
+}
+
+
+void printWeights(const char *label, const double weights[]) {
+    printf("%s: campus %.2f, GO8 %.2f, ARC %.2f, spinoff %.2f, "
+            "income %.2f, retrain %.2f\n", label,
+            weights[GREEDY_CAMPUS], weights[GREEDY_GO8],
+            weights[GREEDY_ARC], weights[GREEDY_SPINOFF],
+            weights[GREEDY_INCOME], weights[GREEDY_RETRAIN]);
+}
+
+
+double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec)
+        + (now.tv_nsec - start->tv_nsec) / 1e9;
+}